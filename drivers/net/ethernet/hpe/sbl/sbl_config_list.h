@@ -4,6 +4,9 @@
 #ifndef SBL_CONFIG_LIST_H
 #define SBL_CONFIG_LIST_H
 
+#include <linux/bitops.h>
+#include <linux/rcupdate.h>
+
 #include <uapi/ethernet/sbl_serdes.h>
 #include <uapi/ethernet/sbl_serdes_defaults.h>
 
@@ -13,6 +16,9 @@
  * entries are statically defined - additional entries can be added and removed from the
  * list dynamically
  *
+ * The list is kept sorted most specific entry first, so a lookup takes the
+ * first match. It is read under RCU and changed under serdes_config_lock.
+ *
  * To add a static serdes configuration
  * 1. create an initializer as below
  * 2. create an static structure in sbl_init.c
@@ -31,9 +37,38 @@ struct sbl_serdes_config {
 	struct list_head list;
 	bool is_default;            /* Default configuration */
 	u32 tag;                    /* tag for debugging */
+
+	u8  port_bits;              /* ports in port_mask */
+	u8  serdes_bits;            /* serdes in serdes_mask */
+	u8  mask_bits;              /* bits in tp_state_mask0 and 1 */
+	struct rcu_head rcu;
 };
 
 
+/*
+ * Is config a more specific than config b - i.e. has it
+ *  * [1] fewer ports
+ *  * [2] if tie, fewer serdes
+ *  * [3] if tie, more tp state mask bits
+ */
+static inline bool sbl_serdes_config_more_specific(const struct sbl_serdes_config *a,
+		const struct sbl_serdes_config *b)
+{
+	if (a->port_bits != b->port_bits)
+		return a->port_bits < b->port_bits;
+	if (a->serdes_bits != b->serdes_bits)
+		return a->serdes_bits < b->serdes_bits;
+	return a->mask_bits > b->mask_bits;
+}
+
+/* work out the specificity of a config */
+static inline void sbl_serdes_config_count_bits(struct sbl_serdes_config *sc)
+{
+	sc->port_bits   = hweight64(sc->port_mask);
+	sc->serdes_bits = hweight8(sc->serdes_mask);
+	sc->mask_bits   = hweight64(sc->tp_state_mask0) + hweight64(sc->tp_state_mask1);
+}
+
 /* Default serdes config initializer */
 #define SBL_SERDES_CONFIG_INITIALIZER					\
 {									\
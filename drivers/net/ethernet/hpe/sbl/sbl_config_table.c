@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/sort.h>
+#include <linux/firmware.h>
+#include <linux/rculist.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include <uapi/ethernet/sbl_serdes.h>
+
+#include "sbl_config_list.h"
+#include "sbl_internal.h"
+
+/*
+ * SerDes configuration table
+ *
+ * Loads a whole serdes config list from a struct sbl_sc_table image in
+ * one go. The image is validated and every entry built and sorted before
+ * the config list lock is taken; then all the non default entries are
+ * swapped out for the table under a single write of serdes_config_seq,
+ * so a lookup sees either the old list or the new one.
+ */
+
+struct sbl_sc_table_slot {
+	struct sbl_serdes_config *sc;
+	u32 idx;                                  /* position in the table */
+};
+
+static bool sbl_sc_table_same(const struct sbl_serdes_config *a,
+		const struct sbl_serdes_config *b)
+{
+	return (a->port_mask == b->port_mask) &&
+		(a->serdes_mask == b->serdes_mask) &&
+		(a->tp_state_mask0 == b->tp_state_mask0) &&
+		(a->tp_state_mask1 == b->tp_state_mask1) &&
+		(a->tp_state_match0 == b->tp_state_match0) &&
+		(a->tp_state_match1 == b->tp_state_match1);
+}
+
+static int sbl_sc_table_cmp_u64(u64 a, u64 b)
+{
+	return (a > b) - (a < b);
+}
+
+/* most specific first, then grouping identical entries together */
+static int sbl_sc_table_cmp_dup(const void *a, const void *b)
+{
+	const struct sbl_serdes_config *sa = ((const struct sbl_sc_table_slot *)a)->sc;
+	const struct sbl_serdes_config *sb = ((const struct sbl_sc_table_slot *)b)->sc;
+
+	if (sbl_serdes_config_more_specific(sa, sb))
+		return -1;
+	if (sbl_serdes_config_more_specific(sb, sa))
+		return 1;
+
+	return sbl_sc_table_cmp_u64(sa->port_mask, sb->port_mask) ?:
+		sbl_sc_table_cmp_u64(sa->serdes_mask, sb->serdes_mask) ?:
+		sbl_sc_table_cmp_u64(sa->tp_state_mask0, sb->tp_state_mask0) ?:
+		sbl_sc_table_cmp_u64(sa->tp_state_mask1, sb->tp_state_mask1) ?:
+		sbl_sc_table_cmp_u64(sa->tp_state_match0, sb->tp_state_match0) ?:
+		sbl_sc_table_cmp_u64(sa->tp_state_match1, sb->tp_state_match1);
+}
+
+/* most specific first, then table order */
+static int sbl_sc_table_cmp_lookup(const void *a, const void *b)
+{
+	const struct sbl_sc_table_slot *ta = a;
+	const struct sbl_sc_table_slot *tb = b;
+
+	if (sbl_serdes_config_more_specific(ta->sc, tb->sc))
+		return -1;
+	if (sbl_serdes_config_more_specific(tb->sc, ta->sc))
+		return 1;
+
+	return sbl_sc_table_cmp_u64(ta->idx, tb->idx);
+}
+
+static int sbl_sc_table_validate(struct sbl_inst *sbl, const void *data, size_t size)
+{
+	const struct sbl_sc_table *table = data;
+	const struct sbl_sc_table_entry *entry;
+	u32 i;
+
+	if (size < sizeof(struct sbl_sc_table)) {
+		sbl_dev_err(sbl->dev, "config table: too small (%zd)", size);
+		return -EINVAL;
+	}
+
+	if (table->magic != SBL_SERDES_CONFIG_TABLE_MAGIC) {
+		sbl_dev_err(sbl->dev, "config table: bad magic (0x%x)", table->magic);
+		return -EINVAL;
+	}
+
+	if (table->version != SBL_SERDES_CONFIG_TABLE_VERSION) {
+		sbl_dev_err(sbl->dev, "config table: unsupported version %d",
+			table->version);
+		return -EINVAL;
+	}
+
+	if (table->entry_size != sizeof(struct sbl_sc_table_entry)) {
+		sbl_dev_err(sbl->dev, "config table: bad entry size %d",
+			table->entry_size);
+		return -EINVAL;
+	}
+
+	if (table->num_entries > SBL_SC_TABLE_MAX_ENTRIES) {
+		sbl_dev_err(sbl->dev, "config table: too many entries (%d)",
+			table->num_entries);
+		return -E2BIG;
+	}
+
+	if (size != struct_size(table, entries, table->num_entries)) {
+		sbl_dev_err(sbl->dev, "config table: size %zd wrong for %d entries",
+			size, table->num_entries);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < table->num_entries; ++i) {
+		entry = table->entries + i;
+		if (entry->vals.magic != SBL_SERDES_CONFIG_MAGIC) {
+			sbl_dev_err(sbl->dev, "config table: entry %d bad magic (0x%x)",
+				i, entry->vals.magic);
+			return -EINVAL;
+		}
+		if (entry->vals.num_intr > SBL_SC_MAX_INTR) {
+			sbl_dev_err(sbl->dev, "config table: entry %d too many interrupts (%d)",
+				i, entry->vals.num_intr);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void sbl_sc_table_free(struct sbl_sc_table_slot *slots, u32 num)
+{
+	u32 i;
+
+	for (i = 0; i < num; ++i)
+		kfree(slots[i].sc);
+	kvfree(slots);
+}
+
+/* build the new entries, sorted into lookup order */
+static struct sbl_sc_table_slot *sbl_sc_table_build(struct sbl_inst *sbl,
+		const struct sbl_sc_table *table)
+{
+	const struct sbl_sc_table_entry *entry;
+	struct sbl_sc_table_slot *slots;
+	struct sbl_serdes_config *sc;
+	u32 i;
+
+	slots = kvcalloc(table->num_entries, sizeof(*slots), GFP_KERNEL);
+	if (!slots)
+		return ERR_PTR(-ENOMEM);
+
+	for (i = 0; i < table->num_entries; ++i) {
+		entry = table->entries + i;
+		sc = kmalloc(sizeof(struct sbl_serdes_config), GFP_KERNEL);
+		if (!sc) {
+			sbl_sc_table_free(slots, i);
+			return ERR_PTR(-ENOMEM);
+		}
+
+		sc->tp_state_mask0  = entry->tp_state_mask0;
+		sc->tp_state_mask1  = entry->tp_state_mask1;
+		sc->tp_state_match0 = entry->tp_state_match0;
+		sc->tp_state_match1 = entry->tp_state_match1;
+		sc->port_mask       = entry->port_mask;
+		sc->serdes_mask     = entry->serdes_mask;
+		sc->is_default      = false;
+		sc->tag             = sbl_serdes_get_config_tag();
+		memcpy(&sc->vals, &entry->vals, sizeof(struct sbl_sc_values));
+		sbl_serdes_config_count_bits(sc);
+		INIT_LIST_HEAD(&sc->list);
+
+		slots[i].sc = sc;
+		slots[i].idx = i;
+	}
+
+	/* entries must be unique, as for sbl_serdes_add_config() */
+	sort(slots, table->num_entries, sizeof(*slots), sbl_sc_table_cmp_dup, NULL);
+	for (i = 1; i < table->num_entries; ++i) {
+		if (sbl_sc_table_same(slots[i - 1].sc, slots[i].sc)) {
+			sbl_dev_err(sbl->dev, "config table: entries %d and %d are the same",
+				slots[i - 1].idx, slots[i].idx);
+			sbl_sc_table_free(slots, table->num_entries);
+			return ERR_PTR(-EEXIST);
+		}
+	}
+
+	sort(slots, table->num_entries, sizeof(*slots), sbl_sc_table_cmp_lookup, NULL);
+
+	return slots;
+}
+
+/**
+ * sbl_serdes_load_config_table() - Replace the serdes configurations
+ * @sbl: A slingshot base link device instance
+ * @data: struct sbl_sc_table image
+ * @size: size of the image
+ *
+ * All the non default serdes configurations are replaced by the entries in
+ * the table. Nothing is changed if the table is not valid, or any entry
+ * is the same as a default one.
+ *
+ * Context: Process context, Acquires lock and release serdes_config_lock <spin_lock>
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_load_config_table(struct sbl_inst *sbl, const void *data, size_t size)
+{
+	const struct sbl_sc_table *table = data;
+	struct sbl_sc_table_slot *slots;
+	struct sbl_serdes_config *sc;
+	struct sbl_serdes_config *tmp_sc;
+	struct list_head *pos;
+	u32 i;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (!data)
+		return -EINVAL;
+
+	err = sbl_sc_table_validate(sbl, data, size);
+	if (err)
+		return err;
+
+	slots = sbl_sc_table_build(sbl, table);
+	if (IS_ERR(slots))
+		return PTR_ERR(slots);
+
+	spin_lock(&sbl->serdes_config_lock);
+
+	/* defaults are kept, so the table can't repeat them */
+	list_for_each_entry(sc, &sbl->serdes_config_list, list) {
+		if (!sc->is_default)
+			continue;
+		for (i = 0; i < table->num_entries; ++i) {
+			if (sbl_sc_table_same(sc, slots[i].sc)) {
+				spin_unlock(&sbl->serdes_config_lock);
+				sbl_dev_err(sbl->dev, "config table: entry %d is a default (tag %d)",
+					slots[i].idx, sc->tag);
+				sbl_sc_table_free(slots, table->num_entries);
+				return -EEXIST;
+			}
+		}
+	}
+
+	write_seqcount_begin(&sbl->serdes_config_seq);
+
+	list_for_each_entry_safe(sc, tmp_sc, &sbl->serdes_config_list, list) {
+		if (!sc->is_default) {
+			list_del_rcu(&sc->list);
+			kfree_rcu(sc, rcu);
+		}
+	}
+
+	/* merge the sorted table with the defaults, newest first on a tie */
+	pos = sbl->serdes_config_list.next;
+	for (i = 0; i < table->num_entries; ++i) {
+		while ((pos != &sbl->serdes_config_list) &&
+		       sbl_serdes_config_more_specific(
+				list_entry(pos, struct sbl_serdes_config, list), slots[i].sc))
+			pos = pos->next;
+		list_add_tail_rcu(&slots[i].sc->list, pos);
+	}
+
+	write_seqcount_end(&sbl->serdes_config_seq);
+
+	spin_unlock(&sbl->serdes_config_lock);
+
+	sbl_dev_info(sbl->dev, "loaded serdes config table (%d entries)",
+		table->num_entries);
+
+	/* the entries now belong to the list */
+	kvfree(slots);
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_serdes_load_config_table);
+
+/**
+ * sbl_serdes_request_config_table() - Load the serdes configurations from a file
+ * @sbl: A slingshot base link device instance
+ * @fname: firmware file holding a struct sbl_sc_table image
+ *
+ * Context: Process context. May request firmware.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_request_config_table(struct sbl_inst *sbl, const char *fname)
+{
+	const struct firmware *fw;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = request_firmware(&fw, fname, sbl->dev);
+	if (err) {
+		sbl_dev_err(sbl->dev, "config table %s request failed [%d]", fname, err);
+		return err;
+	}
+
+	err = sbl_serdes_load_config_table(sbl, fw->data, fw->size);
+
+	release_firmware(fw);
+
+	return err;
+}
+EXPORT_SYMBOL(sbl_serdes_request_config_table);
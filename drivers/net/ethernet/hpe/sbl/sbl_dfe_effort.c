@@ -0,0 +1,307 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include "sbl_constants.h"
+#include "sbl_internal.h"
+
+/*
+ * Adaptive DFE tune effort
+ *
+ * Every dfe tune is recorded against its port, media and ICAL effort:
+ * how many were tried, how many were good and how long they all took.
+ * A tune which passes its eye checks is only counted as good once the
+ * fec up check passes as well; a failed up check counts against the
+ * effort used, together with the time up to the end of the check.
+ * Repeating a tune at one effort until it is good takes total_ms / good
+ * on average, so with the SBL_OPT_DFE_ADAPTIVE_EFFORT option each tune
+ * uses the effort with the smallest expected time to link.
+ *
+ * Each level starts with a prior worth SBL_DFE_EFFORT_PRIOR_TRIES tunes
+ * that favours medium effort, as the fixed ladder did. A tuning still
+ * goes to max effort after SBL_DFE_EFFORT_ESCALATE bad tunes, and every
+ * SBL_DFE_EFFORT_EXPLORE tunings the first tune tries the next lower
+ * effort so an easy channel can find out it doesn't need the best one.
+ */
+
+static const u16 sbl_dfe_effort_ical_value[SBL_DFE_EFFORT_NUM] = {
+	[SBL_DFE_EFFORT_MIN] = SPICO_INT_DATA_ICAL_MIN_EFFORT,
+	[SBL_DFE_EFFORT_MED] = SPICO_INT_DATA_ICAL_MED_EFFORT,
+	[SBL_DFE_EFFORT_MAX] = SPICO_INT_DATA_ICAL_MAX_EFFORT,
+};
+
+/* expected good tunes and time of each try before any are recorded */
+static const struct {
+	u32 good;
+	u32 ms;
+} sbl_dfe_effort_prior[SBL_DFE_EFFORT_NUM] = {
+	[SBL_DFE_EFFORT_MIN] = { .good = 1, .ms =  2000 },
+	[SBL_DFE_EFFORT_MED] = { .good = 3, .ms =  5000 },
+	[SBL_DFE_EFFORT_MAX] = { .good = 4, .ms = 15000 },
+};
+
+static const char * const sbl_dfe_effort_name[SBL_DFE_EFFORT_NUM] = {
+	[SBL_DFE_EFFORT_MIN] = "min",
+	[SBL_DFE_EFFORT_MED] = "med",
+	[SBL_DFE_EFFORT_MAX] = "max",
+};
+
+/* ICAL effort value for an effort level */
+u16 sbl_dfe_effort_ical(int effort)
+{
+	return sbl_dfe_effort_ical_value[effort];
+}
+
+static int sbl_dfe_effort_level(u16 ical_effort)
+{
+	int effort;
+
+	for (effort = 0; effort < SBL_DFE_EFFORT_NUM; ++effort) {
+		if (sbl_dfe_effort_ical_value[effort] == ical_effort)
+			return effort;
+	}
+
+	return -1;
+}
+
+static int sbl_dfe_effort_media(struct sbl_link *link)
+{
+	if (link->mattr.media >= SBL_DFE_EFFORT_MEDIA_NUM)
+		return SBL_LINK_MEDIA_UNKNOWN;
+
+	return link->mattr.media;
+}
+
+/* expected ms to a good tune, repeating this effort */
+static u64 sbl_dfe_effort_cost(const struct sbl_dfe_effort_stats *stats, int effort)
+{
+	u64 ms = (u64)SBL_DFE_EFFORT_PRIOR_TRIES * sbl_dfe_effort_prior[effort].ms +
+		stats->total_ms;
+
+	return div_u64(ms, sbl_dfe_effort_prior[effort].good + stats->good);
+}
+
+/**
+ * sbl_dfe_effort_choose() - Choose the effort for the next dfe tune
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Context: Process context, tuning the port
+ *
+ * Return: the effort level with the smallest expected time to link
+ */
+int sbl_dfe_effort_choose(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_dfe_effort_stats *stats;
+	u64 cost[SBL_DFE_EFFORT_NUM];
+	int best = SBL_DFE_EFFORT_MAX;
+	bool explore = false;
+	int effort;
+
+	if (link->dfe_tune_count >= SBL_DFE_EFFORT_ESCALATE)
+		return SBL_DFE_EFFORT_MAX;
+
+	stats = link->dfe_effort_stats[sbl_dfe_effort_media(link)];
+
+	spin_lock(&link->dfe_effort_lock);
+	for (effort = SBL_DFE_EFFORT_MAX; effort >= 0; --effort) {
+		cost[effort] = sbl_dfe_effort_cost(stats + effort, effort);
+		/* more effort wins a tie */
+		if (cost[effort] < cost[best])
+			best = effort;
+	}
+	if (!link->dfe_tune_count && (++link->dfe_effort_runs >= SBL_DFE_EFFORT_EXPLORE) &&
+	    (best > SBL_DFE_EFFORT_MIN)) {
+		link->dfe_effort_runs = 0;
+		explore = true;
+		best--;
+	}
+	spin_unlock(&link->dfe_effort_lock);
+
+	sbl_dev_dbg(sbl->dev, "p%d: dfe effort %s%s (min %llu, med %llu, max %llu ms)",
+		port_num, sbl_dfe_effort_name[best], explore ? " (exploring)" : "",
+		cost[SBL_DFE_EFFORT_MIN], cost[SBL_DFE_EFFORT_MED],
+		cost[SBL_DFE_EFFORT_MAX]);
+
+	return best;
+}
+
+/* add one try, good or not, and its time to the stats (dfe_effort_lock held) */
+static void sbl_dfe_effort_add(struct sbl_link *link, u16 ical_effort,
+		bool good, u64 start_ns)
+{
+	struct sbl_dfe_effort_stats *stats;
+	int effort;
+
+	effort = sbl_dfe_effort_level(ical_effort);
+	if (effort < 0)
+		return;
+
+	stats = link->dfe_effort_stats[sbl_dfe_effort_media(link)] + effort;
+	stats->tries++;
+	if (good)
+		stats->good++;
+	stats->total_ms += div_u64(ktime_get_ns() - start_ns, NSEC_PER_MSEC);
+}
+
+/**
+ * sbl_dfe_effort_record() - Record a dfe tune
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @ical_effort: ICAL effort the tune used
+ * @err: result of the tune
+ * @start_ns: ktime the tune started
+ *
+ * Only tunes which completed or failed on their own are recorded, not
+ * ones cancelled, timed out or failed by something else. A good tune is
+ * held until sbl_dfe_effort_up_check() says whether the link came up
+ * on it.
+ */
+void sbl_dfe_effort_record(struct sbl_inst *sbl, int port_num, u16 ical_effort,
+		int err, u64 start_ns)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	switch (err) {
+	case 0:
+	case -ETIME:    // tuning did not complete
+	case -ECHRNG:   // eye heights bad
+	case -ELNRNG:   // tuning params out of range
+		break;
+	default:
+		return;
+	}
+
+	spin_lock(&link->dfe_effort_lock);
+	if (err) {
+		sbl_dfe_effort_add(link, ical_effort, false, start_ns);
+	} else {
+		link->dfe_effort_pending = true;
+		link->dfe_effort_pending_ical = ical_effort;
+		link->dfe_effort_pending_ns = start_ns;
+	}
+	spin_unlock(&link->dfe_effort_lock);
+}
+
+/**
+ * sbl_dfe_effort_up_check() - Record the fec up check after a good tune
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @err: result of the fec up check
+ *
+ * The tune held by sbl_dfe_effort_record() is good if the check passed,
+ * otherwise it is a bad try. Its time runs up to the end of the check.
+ * Nothing is recorded if the link was not tuned for this start.
+ */
+void sbl_dfe_effort_up_check(struct sbl_inst *sbl, int port_num, int err)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	spin_lock(&link->dfe_effort_lock);
+	if (link->dfe_effort_pending) {
+		link->dfe_effort_pending = false;
+		sbl_dfe_effort_add(link, link->dfe_effort_pending_ical, !err,
+				link->dfe_effort_pending_ns);
+	}
+	spin_unlock(&link->dfe_effort_lock);
+}
+
+/**
+ * sbl_dfe_effort_clear() - Forget the recorded dfe tunes
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_dfe_effort_clear(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	link = sbl->link + port_num;
+
+	spin_lock(&link->dfe_effort_lock);
+	memset(link->dfe_effort_stats, 0, sizeof(link->dfe_effort_stats));
+	link->dfe_effort_runs = 0;
+	link->dfe_effort_pending = false;
+	spin_unlock(&link->dfe_effort_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_dfe_effort_clear);
+
+#ifdef CONFIG_SYSFS
+/**
+ * sbl_dfe_effort_sysfs_sprint() - Print the dfe tune effort statistics
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @buf: Destination buffer to write the data
+ * @size: Size of data to write
+ *
+ * One line per media and effort tried: tries, good tunes, mean time of a
+ * try and the expected time to a good tune (all ms).
+ *
+ * Return: Number of characters on success, negative error on failure
+ */
+int sbl_dfe_effort_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size)
+{
+	struct sbl_dfe_effort_stats stats[SBL_DFE_EFFORT_MEDIA_NUM][SBL_DFE_EFFORT_NUM];
+	struct sbl_link *link;
+	int media;
+	int effort;
+	int s = 0;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	if (buf == NULL || size == 0U)
+		return -ENOMEM;
+
+	link = sbl->link + port_num;
+
+	spin_lock(&link->dfe_effort_lock);
+	memcpy(stats, link->dfe_effort_stats, sizeof(stats));
+	spin_unlock(&link->dfe_effort_lock);
+
+	s += scnprintf(buf+s, size-s, "adaptive: %s\n",
+			(link->blattr.options & SBL_OPT_DFE_ADAPTIVE_EFFORT) ? "on" : "off");
+
+	for (media = 0; media < SBL_DFE_EFFORT_MEDIA_NUM; ++media) {
+		for (effort = 0; effort < SBL_DFE_EFFORT_NUM; ++effort) {
+			if (!stats[media][effort].tries)
+				continue;
+			s += scnprintf(buf+s, size-s, "%s %s: tries %u, good %u, mean %llu, cost %llu\n",
+					sbl_link_media_str(media), sbl_dfe_effort_name[effort],
+					stats[media][effort].tries, stats[media][effort].good,
+					div_u64(stats[media][effort].total_ms, stats[media][effort].tries),
+					sbl_dfe_effort_cost(&stats[media][effort], effort));
+		}
+	}
+
+	return s;
+}
+EXPORT_SYMBOL(sbl_dfe_effort_sysfs_sprint);
+#endif
@@ -521,57 +521,326 @@ int sbl_fec_adjustments_set(struct sbl_inst *sbl, int port_num,
 }
 EXPORT_SYMBOL(sbl_fec_adjustments_set);
 
-int sbl_fec_up_check(struct sbl_inst *sbl, int port_num)
+/* check the up rates over the last window, logging and counting a failure */
+static int sbl_fec_up_rates_check(struct sbl_inst *sbl, int port_num,
+		u32 ucw_thresh_adj, u32 ccw_thresh_adj, bool use_stp_thresh)
+{
+	bool ucw_err;
+	bool ccw_err;
+
+	ucw_err = sbl_fec_ucw_rate_bad(sbl, port_num, ucw_thresh_adj);
+	if (ucw_err)
+		sbl_dev_err(sbl->dev, "%d: fec up check: ucw fail", port_num);
+
+	ccw_err = sbl_fec_ccw_rate_bad(sbl, port_num, ccw_thresh_adj, use_stp_thresh);
+	if (ccw_err)
+		sbl_dev_err(sbl->dev, "%d: fec up check: %sccw fail", port_num,
+				use_stp_thresh ? "stp " : "");
+
+	if (ucw_err || ccw_err) {
+		sbl_link_counters_incr(sbl, port_num, fec_up_fail);
+		return -EOVERFLOW;
+	}
+
+	return 0;
+}
+
+enum sbl_fec_seq_result {
+	SBL_FEC_SEQ_MORE,                       /* keep sampling */
+	SBL_FEC_SEQ_GOOD,                       /* clearly below threshold */
+	SBL_FEC_SEQ_BAD,                        /* clearly above threshold */
+};
+
+/* sequential test of an error count against a rate threshold
+ *
+ * Errors are treated as a poisson process. The count is compared with
+ * the number expected at the threshold rate over the elapsed time, and a
+ * decision is only made once the count is outside a confidence band of
+ * +/- z * sqrt(count) (plus z^2 to bound the zero count case) around it.
+ */
+static int sbl_fec_seq_test(u64 count, u64 thresh, unsigned long elapsed_ms,
+		u32 confidence)
+{
+	u64 limit;
+	u64 spread;
+	u64 margin;
+
+	/* no threshold, no test */
+	if (thresh == 0)
+		return SBL_FEC_SEQ_GOOD;
+
+	limit  = thresh * elapsed_ms / 1000;
+	spread = (u64)confidence * int_sqrt(count * 10000) / 10000;
+	margin = (u64)confidence * confidence / 10000;
+
+	if (count > limit + spread)
+		return SBL_FEC_SEQ_BAD;
+
+	if (count + spread + margin < limit)
+		return SBL_FEC_SEQ_GOOD;
+
+	return SBL_FEC_SEQ_MORE;
+}
+
+static u64 sbl_fec_count_diff(u64 curr, u64 prev)
+{
+	return (curr > prev) ? curr - prev : 0;
+}
+
+/* set the fec rates from the counts over one up check window */
+static void sbl_fec_window_rates_set(struct sbl_inst *sbl, int port_num,
+		const struct sbl_pcs_fec_cntrs *prev,
+		const struct sbl_pcs_fec_cntrs *curr)
 {
 	struct sbl_link *link = sbl->link + port_num;
 	struct fec_data *fec_data = link->fec_data;
 	struct sbl_fec *fec_prmts = fec_data->fec_prmts;
-	bool ucw_err;
-	bool ccw_err	 = false;
-	bool stp_ccw_err = false;
-	u32 ucw_thresh_adj;
-	u32 ccw_thresh_adj;
-	u32 stp_ccw_thresh_adj;
+	unsigned long tdiff = curr->time - prev->time;
 	int i;
 
-	spin_lock(&fec_prmts->fec_cw_lock);
-	ucw_thresh_adj = fec_prmts->fec_ucw_up_thresh_adj;
-	ccw_thresh_adj = fec_prmts->fec_ccw_up_thresh_adj;
-	stp_ccw_thresh_adj = fec_prmts->fec_stp_ccw_up_thresh_adj;
-	spin_unlock(&fec_prmts->fec_cw_lock);
+	spin_lock(&fec_prmts->fec_cnt_lock);
+	fec_prmts->fec_rates->ccw = sbl_fec_rate_calc(sbl, port_num,
+			curr->ccw, prev->ccw, tdiff);
+	fec_prmts->fec_rates->ucw = sbl_fec_rate_calc(sbl, port_num,
+			curr->ucw, prev->ucw, tdiff);
+	fec_prmts->fec_rates->llr_tx_replay = sbl_fec_rate_calc(sbl, port_num,
+			curr->llr_tx_replay, prev->llr_tx_replay, tdiff);
+	for (i = 0; i < SBL_PCS_NUM_FECL_CNTRS; ++i)
+		fec_prmts->fec_rates->fecl[i] = sbl_fec_rate_calc(sbl, port_num,
+				curr->fecl[i], prev->fecl[i], tdiff);
+	fec_prmts->fec_rates->time = jiffies_to_msecs(tdiff);
+	spin_unlock(&fec_prmts->fec_cnt_lock);
+}
 
-	/* initial measurement */
-	msleep(SBL_FEC_UP_SETTLE_PERIOD); /* time for fec rates to settle */
-	sbl_fec_counts_get(sbl, port_num, fec_prmts->fec_curr_cnts);
+/* start the sequential check from the initial measurement */
+static void sbl_fec_up_seq_begin(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct fec_data *fec_data = link->fec_data;
+	struct sbl_fec *fec_prmts = fec_data->fec_prmts;
+	struct sbl_fec_up *up = &fec_prmts->fec_up;
+	u64 hwm;
 
-	for (i = 0; i < (link->blattr.options & SBL_OPT_FABRIC_LINK ?
-			 SBL_FEC_UP_COUNT_FABRIC : SBL_FEC_UP_COUNT_EDGE); ++i) {
+	sbl_fec_ucw_bad_get(fec_prmts, &up->ucw_bad, &hwm);
+	sbl_fec_ccw_bad_get(fec_prmts, up->use_stp_thresh, &up->ccw_bad, &hwm);
+	up->ucw_bad = up->ucw_bad * up->ucw_thresh_adj / 100;
+	up->ccw_bad = up->ccw_bad * up->ccw_thresh_adj / 100;
 
-		msleep(SBL_FEC_UP_WINDOW);
-		sbl_fec_rates_update(sbl, port_num, SBL_FEC_UP_WINDOW);
+	spin_lock(&fec_prmts->fec_cnt_lock);
+	up->base = *fec_prmts->fec_curr_cnts;
+	spin_unlock(&fec_prmts->fec_cnt_lock);
+	up->window = up->base;
 
-		ucw_err = sbl_fec_ucw_rate_bad(sbl, port_num, ucw_thresh_adj);
-		if (ucw_err)
-			sbl_dev_err(sbl->dev, "%d: fec up check: ucw fail", port_num);
+	up->last_jiffy = up->base.time +
+		msecs_to_jiffies(up->count * SBL_FEC_UP_WINDOW);
+}
 
-		if ((link->dfe_tune_count == SBL_DFE_USED_SAVED_PARAMS) && (stp_ccw_thresh_adj > 0))
-			stp_ccw_err = sbl_fec_ccw_rate_bad(sbl, port_num, stp_ccw_thresh_adj, true);
-		else
-			ccw_err = sbl_fec_ccw_rate_bad(sbl, port_num, ccw_thresh_adj, false);
+/* take one sequential check sample, waiting for the next one until the
+ * rates are clearly good or bad or the full (fixed window) check time
+ * has expired
+ *
+ * Every SBL_FEC_UP_WINDOW the rates over that window are also checked
+ * as the fixed window check does, so a burst of errors in one window
+ * still fails the check even when the average over the whole
+ * measurement is good.
+ */
+static int sbl_fec_up_check_seq(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct fec_data *fec_data = link->fec_data;
+	struct sbl_fec *fec_prmts = fec_data->fec_prmts;
+	struct sbl_fec_up *up = &fec_prmts->fec_up;
+	struct sbl_pcs_fec_cntrs sample;
+	unsigned long elapsed;
+	unsigned long irq_flags;
+	bool discard;
+	int ucw_res;
+	int ccw_res;
+	int err;
+
+	sbl_fec_counts_get(sbl, port_num, &sample);
+
+	/* restart the measurement if the counts are being discarded */
+	spin_lock_irqsave(&link->fec_discard_lock, irq_flags);
+	discard = (link->fec_discard_time >= up->base.time) &&
+		(link->fec_discard_time < sample.time);
+	spin_unlock_irqrestore(&link->fec_discard_lock, irq_flags);
+
+	if (discard && time_is_after_jiffies(up->last_jiffy)) {
+		sbl_dev_dbg(sbl->dev, "%d: fec up check: restarting after discard", port_num);
+		spin_lock(&fec_prmts->fec_cnt_lock);
+		*fec_prmts->fec_curr_cnts = sample;
+		spin_unlock(&fec_prmts->fec_cnt_lock);
+		up->base = sample;
+		up->window = sample;
+		return sbl_start_wait(sbl, port_num, SBL_FEC_UP_SEQ_INTERVAL);
+	}
+
+	if (time_after_eq(sample.time, up->window.time +
+			msecs_to_jiffies(SBL_FEC_UP_WINDOW))) {
+		sbl_fec_window_rates_set(sbl, port_num, &up->window, &sample);
+		err = sbl_fec_up_rates_check(sbl, port_num, up->ucw_thresh_adj,
+				up->ccw_thresh_adj, up->use_stp_thresh);
+		if (err)
+			return err;
+		up->window = sample;
+	}
+
+	if (time_is_after_jiffies(up->last_jiffy)) {
+
+		elapsed = jiffies_to_msecs(sample.time - up->base.time);
+
+		ucw_res = sbl_fec_seq_test(sbl_fec_count_diff(sample.ucw, up->base.ucw),
+				up->ucw_bad, elapsed, up->confidence);
+		ccw_res = sbl_fec_seq_test(sbl_fec_count_diff(sample.ccw, up->base.ccw),
+				up->ccw_bad, elapsed, up->confidence);
+
+		/* undecided - sample again */
+		if ((ucw_res != SBL_FEC_SEQ_BAD) && (ccw_res != SBL_FEC_SEQ_BAD) &&
+				((ucw_res == SBL_FEC_SEQ_MORE) || (ccw_res == SBL_FEC_SEQ_MORE)))
+			return sbl_start_wait(sbl, port_num, SBL_FEC_UP_SEQ_INTERVAL);
+	}
+
+	sbl_dev_dbg(sbl->dev, "%d: fec up check: decided after %ums", port_num,
+			jiffies_to_msecs(jiffies - up->base.time));
+
+	/* the rates over the whole measurement make the final decision */
+	sbl_fec_rates_update(sbl, port_num, SBL_FEC_UP_SEQ_INTERVAL);
+
+	return sbl_fec_up_rates_check(sbl, port_num, up->ucw_thresh_adj,
+			up->ccw_thresh_adj, up->use_stp_thresh);
+}
+
+/**
+ * sbl_fec_up_check() - Check fec rates are good enough to bring the link up
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @resume: carry on with a check which returned -EINPROGRESS
+ *
+ * After a settle period the fec counters are sampled every
+ * SBL_FEC_UP_SEQ_INTERVAL and the check finishes as soon as the ucw and
+ * ccw rates are below (or any is above) the up thresholds with the
+ * configured confidence. Each full window is still checked on its own.
+ * It never takes longer than the fixed window check, which is still used
+ * if the confidence is set to zero.
+ *
+ * The check never sleeps. Whenever it has to wait it returns -EINPROGRESS
+ * with the wait set by sbl_start_wait(), and is called again with @resume
+ * once the wait is over.
+ *
+ * Context: Process context, busy_mtx held
+ *
+ * Return: 0 on success, -EINPROGRESS to be resumed later, -EOVERFLOW if
+ *         the rates are too high
+ */
+int sbl_fec_up_check(struct sbl_inst *sbl, int port_num, bool resume)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct fec_data *fec_data = link->fec_data;
+	struct sbl_fec *fec_prmts = fec_data->fec_prmts;
+	struct sbl_fec_up *up = &fec_prmts->fec_up;
+	u32 stp_ccw_thresh_adj;
+	int err;
+
+	if (!resume) {
+		spin_lock(&fec_prmts->fec_cw_lock);
+		up->ucw_thresh_adj = fec_prmts->fec_ucw_up_thresh_adj;
+		up->ccw_thresh_adj = fec_prmts->fec_ccw_up_thresh_adj;
+		stp_ccw_thresh_adj = fec_prmts->fec_stp_ccw_up_thresh_adj;
+		up->confidence = fec_prmts->fec_up_seq_confidence;
+		spin_unlock(&fec_prmts->fec_cw_lock);
+
+		up->use_stp_thresh = (link->dfe_tune_count == SBL_DFE_USED_SAVED_PARAMS) &&
+			(stp_ccw_thresh_adj > 0);
+		if (up->use_stp_thresh)
+			up->ccw_thresh_adj = stp_ccw_thresh_adj;
+
+		up->count = (link->blattr.options & SBL_OPT_FABRIC_LINK) ?
+			SBL_FEC_UP_COUNT_FABRIC : SBL_FEC_UP_COUNT_EDGE;
+
+		/* time for fec rates to settle */
+		up->state = SBL_FEC_UP_STATE_SETTLE;
+		return sbl_start_wait(sbl, port_num, SBL_FEC_UP_SETTLE_PERIOD);
+	}
+
+	switch (up->state) {
 
-		if (ccw_err)
-			sbl_dev_err(sbl->dev, "%d: fec up check: ccw fail", port_num);
-		else if (stp_ccw_err)
-			sbl_dev_err(sbl->dev, "%d: fec up check: stp ccw fail", port_num);
+	case SBL_FEC_UP_STATE_SETTLE:
+		/* initial measurement */
+		sbl_fec_counts_get(sbl, port_num, fec_prmts->fec_curr_cnts);
 
-		if (ucw_err || ccw_err || stp_ccw_err) {
-			sbl_link_counters_incr(sbl, port_num, fec_up_fail);
-			return -EOVERFLOW;
+		if (up->confidence) {
+			sbl_fec_up_seq_begin(sbl, port_num);
+			up->state = SBL_FEC_UP_STATE_SEQ;
+			return sbl_start_wait(sbl, port_num, SBL_FEC_UP_SEQ_INTERVAL);
 		}
+
+		up->windows_done = 0;
+		up->state = SBL_FEC_UP_STATE_WINDOW;
+		return sbl_start_wait(sbl, port_num, SBL_FEC_UP_WINDOW);
+
+	case SBL_FEC_UP_STATE_WINDOW:
+		sbl_fec_rates_update(sbl, port_num, SBL_FEC_UP_WINDOW);
+
+		err = sbl_fec_up_rates_check(sbl, port_num, up->ucw_thresh_adj,
+				up->ccw_thresh_adj, up->use_stp_thresh);
+		if (err)
+			return err;
+
+		if (++up->windows_done < up->count)
+			return sbl_start_wait(sbl, port_num, SBL_FEC_UP_WINDOW);
+		return 0;
+
+	case SBL_FEC_UP_STATE_SEQ:
+		return sbl_fec_up_check_seq(sbl, port_num);
+
+	default:
+		sbl_dev_err(sbl->dev, "%d: fec up check: bad state %d", port_num, up->state);
+		return -EINVAL;
 	}
+}
+
+/**
+ * sbl_fec_up_confidence_set() - set the fec up check confidence
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @confidence: z-score x100 needed for an early decision, zero for the
+ *              fixed window check
+ *
+ * Context: Process context, Acquires lock and release fec_cw_lock <spin_lock>
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_fec_up_confidence_set(struct sbl_inst *sbl, int port_num,
+		u32 confidence)
+{
+	struct sbl_link *link;
+	struct fec_data *fec_data;
+	struct sbl_fec *fec_prmts;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	link = sbl->link + port_num;
+	fec_data = link->fec_data;
+	fec_prmts = fec_data->fec_prmts;
+
+	spin_lock(&fec_prmts->fec_cw_lock);
+	fec_prmts->fec_up_seq_confidence = confidence;
+	spin_unlock(&fec_prmts->fec_cw_lock);
+
+	sbl_dev_dbg(sbl->dev, "%d: Setting fec up confidence %d",
+			port_num, confidence);
 
 	return 0;
 }
+EXPORT_SYMBOL(sbl_fec_up_confidence_set);
 
 void sbl_fec_counts_get(struct sbl_inst *sbl, int port_num,
 		struct sbl_pcs_fec_cntrs *cntrs)
@@ -623,6 +892,7 @@ void sbl_fec_timer_work(struct work_struct *work)
 			if (sbl_fec_ucw_rate_bad(sbl, port_num, ucw_thresh_adj)) {
 				/* take the link down */
 				down_origin = SBL_LINK_DOWN_ORIGIN_UCW;
+				sbl_tp_quality_monitor(sbl, port_num, true);
 				sbl_pml_link_down_async_alert(sbl, port_num, down_origin);
 				return;
 			}
@@ -630,6 +900,7 @@ void sbl_fec_timer_work(struct work_struct *work)
 			if (sbl_fec_ccw_rate_bad(sbl, port_num, ccw_thresh_adj, false)) {
 				/* take the link down */
 				down_origin = SBL_LINK_DOWN_ORIGIN_CCW;
+				sbl_tp_quality_monitor(sbl, port_num, true);
 				sbl_pml_link_down_async_alert(sbl, port_num, down_origin);
 				return;
 			}
@@ -637,10 +908,12 @@ void sbl_fec_timer_work(struct work_struct *work)
 			if (sbl_fec_txr_rate_bad(sbl, port_num, 0)) {
 				/* take the link down */
 				down_origin = SBL_LINK_DOWN_ORIGIN_LLR_TX_REPLAY;
+				sbl_tp_quality_monitor(sbl, port_num, true);
 				sbl_pml_link_down_async_alert(sbl, port_num, down_origin);
 				return;
 			}
 			sbl_fec_rates_warnings(sbl, port_num, &warning_count);
+			sbl_tp_quality_monitor(sbl, port_num, false);
 
 		}
 
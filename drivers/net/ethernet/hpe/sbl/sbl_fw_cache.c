@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/firmware.h>
+#include <linux/kref.h>
+#include <linux/mm.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include "sbl_sbm_serdes.h"
+#include "sbl_serdes_fn.h"
+#include "sbl_internal.h"
+
+/*
+ * Resident firmware image cache
+ *
+ * The sbus master and serdes images are requested once per instance and
+ * kept, already encoded as spico burst words, until the instance file
+ * names change or the instance is deleted. Images are refcounted so a
+ * flash in progress keeps its image even if the cache moves on.
+ */
+
+static void sbl_fw_image_release(struct kref *ref)
+{
+	struct sbl_fw_image *image = container_of(ref, struct sbl_fw_image, ref);
+
+	kfree(image->fname);
+	kvfree(image->data);
+	kvfree(image);
+}
+
+/**
+ * sbl_fw_image_put() - Release a firmware image
+ * @image: image from sbl_sbm_fw_image_get() or sbl_serdes_fw_image_get()
+ */
+void sbl_fw_image_put(struct sbl_fw_image *image)
+{
+	if (image)
+		kref_put(&image->ref, sbl_fw_image_release);
+}
+
+static struct sbl_fw_image *sbl_fw_image_load(struct sbl_inst *sbl,
+		const char *fname)
+{
+	struct sbl_fw_image *image;
+	const struct firmware *fw;
+	int num_words;
+	int err;
+
+	err = request_firmware(&fw, fname, sbl->dev);
+	if (err) {
+		sbl_dev_err(sbl->dev, "firmware request failed [%d]", err);
+		return ERR_PTR(err);
+	}
+	sbl_dev_dbg(sbl->dev, "loaded fw %s (size %zd)", fname, fw->size);
+
+	num_words = SBL_SPICO_BURST_WORDS(fw->size);
+	image = kvzalloc(struct_size(image, words, num_words), GFP_KERNEL);
+	if (!image) {
+		err = -ENOMEM;
+		goto out_release;
+	}
+
+	kref_init(&image->ref);
+	image->fname = kstrdup(fname, GFP_KERNEL);
+	image->data = kvmalloc(fw->size, GFP_KERNEL);
+	if (!image->fname || !image->data) {
+		err = -ENOMEM;
+		goto out_free;
+	}
+
+	err = sbl_parse_version_string(sbl, image->fname, &image->fw_rev,
+				       &image->fw_build);
+	if (err)
+		goto out_free;
+
+	memcpy(image->data, fw->data, fw->size);
+	image->size = fw->size;
+	image->num_words = sbl_spico_burst_encode(fw->size, fw->data, image->words);
+
+	release_firmware(fw);
+
+	sbl_dev_dbg(sbl->dev, "cached fw %s (rev 0x%x build 0x%x, %d words)",
+		    image->fname, image->fw_rev, image->fw_build, image->num_words);
+
+	return image;
+
+ out_free:
+	sbl_fw_image_put(image);
+ out_release:
+	release_firmware(fw);
+	return ERR_PTR(err);
+}
+
+/* get the cached image for fname, (re)loading it if needed */
+static struct sbl_fw_image *sbl_fw_image_get(struct sbl_inst *sbl,
+		struct sbl_fw_image **cached, const char *fname)
+{
+	struct sbl_fw_image *image;
+
+	mutex_lock(&sbl->fw_image_mtx);
+
+	if (*cached && strcmp((*cached)->fname, fname)) {
+		sbl_dev_dbg(sbl->dev, "fw %s replaced by %s", (*cached)->fname, fname);
+		sbl_fw_image_put(*cached);
+		*cached = NULL;
+	}
+
+	if (!*cached) {
+		image = sbl_fw_image_load(sbl, fname);
+		if (IS_ERR(image))
+			goto out;
+		*cached = image;
+	}
+
+	image = *cached;
+	kref_get(&image->ref);
+
+ out:
+	mutex_unlock(&sbl->fw_image_mtx);
+	return image;
+}
+
+/**
+ * sbl_sbm_fw_image_get() - Get the sbus master firmware image
+ * @sbl: A slingshot base link device instance
+ *
+ * Context: Process context. May request firmware.
+ *
+ * Return: referenced image on success, ERR_PTR on failure
+ */
+struct sbl_fw_image *sbl_sbm_fw_image_get(struct sbl_inst *sbl)
+{
+	return sbl_fw_image_get(sbl, &sbl->sbm_fw_image, sbl->iattr.sbm_fw_fname);
+}
+
+/**
+ * sbl_serdes_fw_image_get() - Get the serdes firmware image
+ * @sbl: A slingshot base link device instance
+ *
+ * Context: Process context. May request firmware.
+ *
+ * Return: referenced image on success, ERR_PTR on failure
+ */
+struct sbl_fw_image *sbl_serdes_fw_image_get(struct sbl_inst *sbl)
+{
+	return sbl_fw_image_get(sbl, &sbl->serdes_fw_image, sbl->iattr.serdes_fw_fname);
+}
+
+/**
+ * sbl_fw_image_cache_flush() - Drop the cached firmware images
+ * @sbl: A slingshot base link device instance
+ *
+ * Images still held by a flash are freed when it puts them.
+ */
+void sbl_fw_image_cache_flush(struct sbl_inst *sbl)
+{
+	mutex_lock(&sbl->fw_image_mtx);
+	sbl_fw_image_put(sbl->sbm_fw_image);
+	sbl->sbm_fw_image = NULL;
+	sbl_fw_image_put(sbl->serdes_fw_image);
+	sbl->serdes_fw_image = NULL;
+	mutex_unlock(&sbl->fw_image_mtx);
+}
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/jiffies.h>
+#include <linux/bitops.h>
+#include <linux/workqueue.h>
+
+#include <linux/hpe/sbl/sbl.h>
+#include <linux/hpe/sbl/sbl_test.h>
+
+#include <uapi/ethernet/sbl_sbm_constants.h>
+
+#include "sbl_constants.h"
+#include "sbl_sbm_serdes.h"
+#include "sbl_serdes_fn.h"
+#include "sbl_internal.h"
+
+/*
+ * SerDes firmware crc check cache
+ *
+ * A good crc check is remembered per port and serdes together with the
+ * firmware reload counts at the time of the check. It is trusted at link
+ * start for SBL_FW_CRC_CACHE_TIMEOUT unless either the serdes or any sbus
+ * master firmware has been reloaded since.
+ */
+
+/* any sbus master reload invalidates all cached serdes checks */
+static int sbl_fw_crc_sbm_gen(struct sbl_inst *sbl)
+{
+	int sbus_ring;
+	int gen = 0;
+
+	for (sbus_ring = 0; sbus_ring < sbl->switch_info->num_sbus_rings; ++sbus_ring)
+		gen += atomic_read(&sbl->sbm_fw_reload_count[sbus_ring]);
+
+	return gen;
+}
+
+static int sbl_fw_crc_reload_gen(struct sbl_inst *sbl, int port_num, int serdes)
+{
+	return sbl_link_counters_read(sbl, port_num, serdes0_fw_reload + serdes);
+}
+
+/*
+ * sbl_serdes_fw_crc_cached() - Check for a recent good fw crc check
+ *
+ * Only used when the link has the fw crc cache option set. An injected
+ * test crc failure always forces a real check.
+ */
+bool sbl_serdes_fw_crc_cached(struct sbl_inst *sbl, int port_num, int serdes)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_fw_crc *fw_crc = link->fw_crc + serdes;
+	bool cached;
+
+	if (!(link->blattr.options & SBL_OPT_FW_CRC_CACHE))
+		return false;
+
+	if (sbl_test_serdes_fw_crc_failure_injected())
+		return false;
+
+	spin_lock(&link->fw_crc_lock);
+	cached = fw_crc->valid &&
+		(fw_crc->reload_gen == sbl_fw_crc_reload_gen(sbl, port_num, serdes)) &&
+		(fw_crc->sbm_gen == sbl_fw_crc_sbm_gen(sbl)) &&
+		time_before(jiffies, fw_crc->jiffies +
+			msecs_to_jiffies(SBL_FW_CRC_CACHE_TIMEOUT));
+	spin_unlock(&link->fw_crc_lock);
+
+	return cached;
+}
+
+/* remember a good fw crc check */
+void sbl_serdes_fw_crc_record(struct sbl_inst *sbl, int port_num, int serdes)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_fw_crc *fw_crc = link->fw_crc + serdes;
+
+	spin_lock(&link->fw_crc_lock);
+	fw_crc->valid = true;
+	fw_crc->jiffies = jiffies;
+	fw_crc->reload_gen = sbl_fw_crc_reload_gen(sbl, port_num, serdes);
+	fw_crc->sbm_gen = sbl_fw_crc_sbm_gen(sbl);
+	spin_unlock(&link->fw_crc_lock);
+}
+
+/* forget all fw crc checks for a port */
+void sbl_serdes_fw_crc_invalidate(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int serdes;
+
+	spin_lock(&link->fw_crc_lock);
+	for (serdes = 0; serdes < SBL_SERDES_LANES_PER_PORT; ++serdes)
+		link->fw_crc[serdes].valid = false;
+	spin_unlock(&link->fw_crc_lock);
+}
+
+/*
+ * Background firmware scrubber
+ *
+ * Periodically re-checks the serdes fw crc on idle ports which use the
+ * fw crc cache, and the sbus master fw crc on their rings, so a start
+ * normally finds a recent good result. A busy port or sbus master is
+ * skipped until the next pass, and a port's busy mutex is held for one
+ * serdes at a time. That serdes crc check still takes the sbus ring, so
+ * a start can wait for one crc check, including any wait for the ring.
+ * Failures only invalidate the cache so the next start does the full
+ * check (and reload); no firmware is flashed from here.
+ */
+
+static void sbl_fw_scrub_port(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int serdes;
+	int err;
+
+	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+		if (!mutex_trylock(&link->busy_mtx))
+			return;
+
+		if ((link->blstate != SBL_BASE_LINK_STATUS_DOWN) ||
+				(link->sstate == SBL_SERDES_STATUS_ERROR)) {
+			mutex_unlock(&link->busy_mtx);
+			return;
+		}
+
+		err = sbl_validate_serdes_fw_crc(sbl, port_num, serdes);
+		if (err) {
+			sbl_dev_warn(sbl->dev, "p%ds%d: fw scrub: crc check failed [%d]\n",
+					port_num, serdes, err);
+			sbl_serdes_fw_crc_invalidate(sbl, port_num);
+			mutex_unlock(&link->busy_mtx);
+			return;
+		}
+		sbl_serdes_fw_crc_record(sbl, port_num, serdes);
+
+		mutex_unlock(&link->busy_mtx);
+		cond_resched();
+	}
+}
+
+static void sbl_fw_scrub_ring(struct sbl_inst *sbl, int sbus_ring)
+{
+	u32 sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_SBM_SPICO);
+	u32 crc_result;
+	int port_num;
+	int err;
+
+	if (!sbl_sbus_ring_trylock(sbl, sbus_ring, SBL_SBUS_PRIO_TELEMETRY))
+		return;
+
+	err = sbl_sbm_spico_int(sbl, sbus_addr, SPICO_INT_SBMS_DO_CRC,
+				SPICO_INT_DATA_NONE, &crc_result);
+
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
+
+	if (!err && (crc_result == SPICO_RESULT_SBR_CRC_PASS))
+		return;
+
+	sbl_dev_warn(sbl->dev, "r%d: fw scrub: sbm crc check failed [%d] (result 0x%x)\n",
+			sbus_ring, err, err ? 0 : crc_result);
+
+	for (port_num = 0; port_num < sbl->switch_info->num_ports; ++port_num) {
+		if (sbl->switch_info->ports[port_num].serdes[0].sbus_ring == sbus_ring)
+			sbl_serdes_fw_crc_invalidate(sbl, port_num);
+	}
+}
+
+/**
+ * sbl_fw_scrub_work() - Background firmware scrub pass
+ * @work: the instance fw_scrub_work
+ *
+ * Context: Process context (instance workqueue). Only ever trylocks
+ * the port busy mutex; the serdes crc checks wait for the sbus ring.
+ */
+void sbl_fw_scrub_work(struct work_struct *work)
+{
+	struct sbl_inst *sbl = container_of(to_delayed_work(work),
+			struct sbl_inst, fw_scrub_work);
+	unsigned long rings = 0;
+	int port_num;
+	int sbus_ring;
+
+	for (port_num = 0; port_num < sbl->switch_info->num_ports; ++port_num) {
+		if (sbl->link[port_num].blattr.options & SBL_OPT_FW_CRC_CACHE)
+			__set_bit(sbl->switch_info->ports[port_num].serdes[0].sbus_ring,
+					&rings);
+	}
+
+	if (rings) {
+		for_each_set_bit(sbus_ring, &rings, BITS_PER_LONG)
+			sbl_fw_scrub_ring(sbl, sbus_ring);
+
+		for (port_num = 0; port_num < sbl->switch_info->num_ports; ++port_num) {
+			if (!(sbl->link[port_num].blattr.options & SBL_OPT_FW_CRC_CACHE))
+				continue;
+			sbl_fw_scrub_port(sbl, port_num);
+			cond_resched();
+		}
+	}
+
+	queue_delayed_work(sbl->workq, &sbl->fw_scrub_work,
+			msecs_to_jiffies(SBL_FW_SCRUB_INTERVAL));
+}
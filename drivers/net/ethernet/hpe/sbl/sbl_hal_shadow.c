@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/bitops.h>
+#include <linux/spinlock.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include <uapi/ethernet/sbl_sbm_constants.h>
+
+#include "sbl_constants.h"
+#include "sbl_sbm_serdes.h"
+#include "sbl_internal.h"
+
+/*
+ * SerDes HAL shadow
+ *
+ * A HAL value is set by a HAL_READ of its select address, which returns
+ * the current value and selects it, followed by a HAL_WRITE of the new
+ * value. For the few HAL values SBL owns (the firmware never changes
+ * them), each lane remembers the last value read or written so setting
+ * a value the lane already has costs no interrupts at all.
+ *
+ * The shadow is kept up to date by watching every serdes spico interrupt,
+ * so HAL writes made outside sbl_serdes_hal_set() are not missed. Anything
+ * unexpected, a failed interrupt, a SPICO or PLL reset, or a firmware
+ * reload invalidates it.
+ */
+
+static const u16 sbl_hal_shadow_sel[SBL_HAL_SHADOW_NUM] = {
+	[SBL_HAL_SHADOW_ICAL_EFFORT] = SPICO_INT_DATA_ICAL_EFFORT_SEL,
+	[SBL_HAL_SHADOW_EID_FILTER]  = SPICO_INT_DATA_EID_FILTER_SEL,
+};
+
+/* shadow register for a HAL select address, or -1 */
+static int sbl_hal_shadow_reg(u16 sel)
+{
+	int reg;
+
+	for (reg = 0; reg < SBL_HAL_SHADOW_NUM; ++reg) {
+		if (sbl_hal_shadow_sel[reg] == sel)
+			return reg;
+	}
+
+	return -1;
+}
+
+/**
+ * sbl_hal_shadow_update() - Track a serdes spico interrupt in the HAL shadow
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @serdes: serdes lane
+ * @code: interrupt code
+ * @data: interrupt data
+ * @err: result of the interrupt
+ * @result: interrupt result, or NULL if it was not returned
+ *
+ * Called for every serdes spico interrupt issued on hardware.
+ */
+void sbl_hal_shadow_update(struct sbl_inst *sbl, int port_num, int serdes,
+		int code, int data, int err, const u16 *result)
+{
+	struct sbl_link *link;
+	struct sbl_hal_shadow *shadow;
+	int reg;
+
+	if (port_num < 0 || port_num >= sbl->switch_info->num_ports ||
+	    serdes < 0 || serdes >= SBL_SERDES_LANES_PER_PORT)
+		return;
+
+	link = sbl->link + port_num;
+	shadow = link->hal_shadow + serdes;
+
+	spin_lock(&link->hal_shadow_lock);
+
+	if (err) {
+		/* don't know what the lane did */
+		shadow->sel_valid = false;
+		shadow->valid = 0;
+		goto out;
+	}
+
+	switch (code) {
+	case SPICO_INT_CM4_HAL_READ:
+		shadow->sel = data;
+		shadow->sel_valid = true;
+		reg = sbl_hal_shadow_reg(data);
+		if ((reg >= 0) && result) {
+			shadow->value[reg] = *result;
+			__set_bit(reg, &shadow->valid);
+		}
+		break;
+
+	case SPICO_INT_CM4_HAL_WRITE:
+		if (!shadow->sel_valid) {
+			/* written somewhere unknown */
+			shadow->valid = 0;
+			break;
+		}
+		reg = sbl_hal_shadow_reg(shadow->sel);
+		if (reg >= 0) {
+			if (result && (*result == SPICO_INT_CM4_HAL_READ)) {
+				shadow->value[reg] = data;
+				__set_bit(reg, &shadow->valid);
+			} else {
+				__clear_bit(reg, &shadow->valid);
+			}
+		}
+		/* don't assume the selection survives a write */
+		shadow->sel_valid = false;
+		break;
+
+	default:
+		shadow->sel_valid = false;
+		break;
+	}
+
+ out:
+	spin_unlock(&link->hal_shadow_lock);
+}
+
+/**
+ * sbl_hal_shadow_invalidate() - Forget the shadowed HAL values
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @lane_mask: serdes lanes to forget
+ */
+void sbl_hal_shadow_invalidate(struct sbl_inst *sbl, int port_num, u32 lane_mask)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	unsigned long lanes = lane_mask;
+	int serdes;
+
+	spin_lock(&link->hal_shadow_lock);
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		link->hal_shadow[serdes].sel_valid = false;
+		link->hal_shadow[serdes].valid = 0;
+	}
+	spin_unlock(&link->hal_shadow_lock);
+}
+
+/**
+ * sbl_serdes_hal_set_lanes() - Set a shadowed HAL value on several lanes
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @lane_mask: serdes lanes to set
+ * @reg: shadowed HAL value to set
+ * @value: new value
+ *
+ * Lanes the shadow says already have the value are skipped. The rest are
+ * read, which selects the value, and only written if the value differs.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_hal_set_lanes(struct sbl_inst *sbl, int port_num, u32 lane_mask,
+		enum sbl_hal_shadow_reg reg, u16 value)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	u16 results[SBL_SERDES_LANES_PER_PORT];
+	u16 sel = sbl_hal_shadow_sel[reg];
+	struct sbl_hal_shadow *shadow;
+	unsigned long lanes = lane_mask;
+	unsigned long reads = 0;
+	unsigned long writes = 0;
+	int serdes;
+	int err;
+
+	if (!sbl->is_hw)
+		return 0;
+
+	spin_lock(&link->hal_shadow_lock);
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		shadow = link->hal_shadow + serdes;
+		if (test_bit(reg, &shadow->valid) && (shadow->value[reg] == value))
+			continue;
+		__set_bit(serdes, &reads);
+	}
+	spin_unlock(&link->hal_shadow_lock);
+
+	if (!reads) {
+		DEV_TRACE2(sbl->dev, "p%d: HAL 0x%x already 0x%x (lanes 0x%x)",
+			   port_num, sel, value, lane_mask);
+		return 0;
+	}
+
+	err = sbl_serdes_spico_int_lanes(sbl, port_num, reads,
+					 SPICO_INT_CM4_HAL_READ, sel,
+					 results, SPICO_INT_RETURN_RESULT);
+	if (err)
+		return err;
+
+	for_each_set_bit(serdes, &reads, SBL_SERDES_LANES_PER_PORT) {
+		if (results[serdes] == value)
+			continue;
+		DEV_TRACE2(sbl->dev, "p%ds%d: Updating HAL 0x%x from 0x%x to 0x%x",
+			   port_num, serdes, sel, results[serdes], value);
+		__set_bit(serdes, &writes);
+	}
+	if (!writes)
+		return 0;
+
+	err = sbl_serdes_spico_int_lanes(sbl, port_num, writes,
+					 SPICO_INT_CM4_HAL_WRITE, value,
+					 results, SPICO_INT_RETURN_RESULT);
+	if (err)
+		return err;
+
+	for_each_set_bit(serdes, &writes, SBL_SERDES_LANES_PER_PORT) {
+		if (results[serdes] != SPICO_INT_CM4_HAL_READ) {
+			sbl_dev_err(sbl->dev, "p%ds%d: Failed updating HAL 0x%x to 0x%x!",
+				    port_num, serdes, sel, value);
+			return -EBADE;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * sbl_serdes_hal_set() - Set a shadowed HAL value
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @serdes: serdes lane
+ * @reg: shadowed HAL value to set
+ * @value: new value
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_hal_set(struct sbl_inst *sbl, int port_num, int serdes,
+		enum sbl_hal_shadow_reg reg, u16 value)
+{
+	return sbl_serdes_hal_set_lanes(sbl, port_num, BIT(serdes), reg, value);
+}
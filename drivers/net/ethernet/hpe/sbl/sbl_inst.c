@@ -15,6 +15,7 @@
 
 #include "sbl_constants.h"
 #include "sbl_serdes.h"
+#include "sbl_serdes_fn.h"
 #include "sbl_config_list.h"
 #include "sbl_serdes_map.h"
 #include "sbl_pml_fn.h"
@@ -58,6 +59,7 @@ static struct sbl_link *sbl_create_link_db(struct sbl_switch_info *switch_info)
 		link[i].loopback_mode = SBL_LOOPBACK_MODE_INVALID;
 		link[i].llr_mode      = SBL_LLR_MODE_INVALID;
 		link[i].llr_loop_time = 0;
+		link[i].llr_loop_time_cached = 0;
 		link[i].pcs_config = false;
 		link[i].intr_err_flgs = 0ULL;
 		link[i].an_rx_count = 0;
@@ -66,15 +68,21 @@ static struct sbl_link *sbl_create_link_db(struct sbl_switch_info *switch_info)
 		link[i].lp_subtype = SBL_LP_SUBTYPE_INVALID;
 		link[i].tuning_params.tp_state_hash0 = 0;
 		link[i].tuning_params.tp_state_hash1 = 0;
+		link[i].tp_active_slot = -1;
 		link[i].last_start_jiffy = jiffies;
 		link[i].start_cancelled = false;
 		link[i].dfe_tune_count = 0;
+		link[i].dfe_effort = SBL_DFE_EFFORT_NUM;
+		link[i].dfe_effort_runs = 0;
+		link[i].dfe_effort_pending = false;
 		link[i].optical_delay_active = false;
 		link[i].dfe_predelay_active = false;
 		link[i].pcal_running = false;
 		link[i].tune_param_oob_count = 0;
 		link[i].reload_serdes_fw = false;
 		link[i].pcs_recovery_flag = false;
+		link[i].pcs_lock_time_avg = 0;
+		link[i].pcs_align_time_avg = 0;
 		link[i].pml_recovery.started = false;
 		link[i].pml_recovery.rl_window_start = 0;
 		link[i].fec_discard_time = 0;
@@ -82,6 +90,10 @@ static struct sbl_link *sbl_create_link_db(struct sbl_switch_info *switch_info)
 
 		spin_lock_init(&link[i].lock);
 		spin_lock_init(&link[i].timeout_lock);
+		spin_lock_init(&link[i].phase_stats_lock);
+		spin_lock_init(&link[i].fw_crc_lock);
+		spin_lock_init(&link[i].hal_shadow_lock);
+		spin_lock_init(&link[i].dfe_effort_lock);
 		spin_lock_init(&link[i].pcs_recovery_lock);
 		spin_lock_init(&link[i].is_degraded_lock);
 		spin_lock_init(&link[i].fec_discard_lock);
@@ -108,6 +120,10 @@ out_free_sbl_link_counters:
 		error = true; \
 	}
 
+/* Optional operations can be left out by the caller */
+#define SBL_SETUP_OPT_OP_TBL_ENTRY(e)  \
+	(sbl->ops.e = ops->e)
+
 static int sbl_setup_ops(struct sbl_inst *sbl, const struct sbl_ops *ops)
 {
 	bool error = false;
@@ -131,6 +147,10 @@ static int sbl_setup_ops(struct sbl_inst *sbl, const struct sbl_ops *ops)
 	SBL_SETUP_OP_TBL_ENTRY(sbl_pml_remove_intr_handler);
 	SBL_SETUP_OP_TBL_ENTRY(sbl_async_alert);
 
+	/* optional operations */
+	SBL_SETUP_OPT_OP_TBL_ENTRY(sbl_link_start_complete);
+	SBL_SETUP_OPT_OP_TBL_ENTRY(sbl_sbus_op_batch);
+
 	if (error)
 		return -ENOENT;
 	else
@@ -143,6 +163,7 @@ static int sbl_setup_serdes_configs(struct sbl_inst *sbl)
 
 	spin_lock_init(&sbl->serdes_config_lock);
 	INIT_LIST_HEAD(&sbl->serdes_config_list);
+	seqcount_init(&sbl->serdes_config_seq);
 
 	default_config = (struct sbl_serdes_config)SBL_SERDES_CONFIG_INITIALIZER;
 
@@ -189,6 +210,7 @@ static int sbl_fec_init(struct sbl_inst *sbl)
 		link->fec_data->fec_prmts->fec_stp_ccw_up_thresh_adj = 100;
 		link->fec_data->fec_prmts->fec_ccw_hwm = 0;
 		link->fec_data->fec_prmts->fecl_warn = 0;
+		link->fec_data->fec_prmts->fec_up_seq_confidence = SBL_FEC_UP_SEQ_CONFIDENCE_DFLT;
 
 		spin_lock_init(&link->fec_data->fec_prmts->fec_cw_lock);
 		timer_setup(&link->fec_data->fec_timer, sbl_fec_timer, 0);
@@ -281,6 +303,7 @@ struct sbl_inst *sbl_new_instance(void *accessor, void *pci_accessor,
 	sbl->sbus_op_flags = SBL_DFLT_SBUS_OP_FLAGS_SLOW;
 
 	sbl->workq = alloc_workqueue("%s", WQ_MEM_RECLAIM | WQ_UNBOUND, 0, "sbl-fec");
+	sbl->ring_workq = alloc_workqueue("%s", WQ_MEM_RECLAIM | WQ_UNBOUND, 0, "sbl-ring");
 
 	/* Initialize the hardware-specific map */
 	err = sbl_switch_info_get(sbl, init_attr);
@@ -319,25 +342,55 @@ struct sbl_inst *sbl_new_instance(void *accessor, void *pci_accessor,
 		goto out_free_reload_sbm;
 	}
 
+	sbl->sbus_op_log =
+		kcalloc(sbl->switch_info->num_sbus_rings, sizeof(struct sbl_sbus_op_log), GFP_KERNEL);
+	if (!sbl->sbus_op_log) {
+		err = -ENOMEM;
+		goto out_free_sbm_fw_reload_count;
+	}
+
+	sbl->sbus_prof =
+		kcalloc(sbl->switch_info->num_sbus_rings, sizeof(struct sbl_sbus_prof), GFP_KERNEL);
+	if (!sbl->sbus_prof) {
+		err = -ENOMEM;
+		goto out_free_sbus_op_log;
+	}
+
+	sbl->sbus_arb =
+		kcalloc(sbl->switch_info->num_sbus_rings, sizeof(struct sbl_sbus_arb), GFP_KERNEL);
+	if (!sbl->sbus_arb) {
+		err = -ENOMEM;
+		goto out_free_sbus_prof;
+	}
+
+	sbl->spico_prof = kcalloc(SBL_SPICO_PROF_NUM, sizeof(struct sbl_spico_prof), GFP_KERNEL);
+	if (!sbl->spico_prof) {
+		err = -ENOMEM;
+		goto out_free_sbus_arb;
+	}
+	for (i = 0; i < SBL_SPICO_PROF_NUM; ++i)
+		sbl_spico_prof_init(sbl->spico_prof + i);
+
 	for (i = 0; i < sbl->switch_info->num_sbus_rings; ++i) {
 		mutex_init(&sbl->sbus_ring_mtx[i]);
 		mutex_init(&sbl->sbm_fw_mtx[i]);
 		sbl->reload_sbm_fw[i] = false;
 		atomic_set(&sbl->sbm_fw_reload_count[i], 0);
+		sbl_sbus_arb_init(&sbl->sbus_arb[i]);
 	}
 
 	/* setup the op table */
 	err = sbl_setup_ops(sbl, ops);
 	if (err) {
 		sbl_dev_err(sbl->dev, "op table setup failed [%d]\n", err);
-		goto out_free_sbm_fw_reload_count;
+		goto out_free_spico_prof;
 	}
 
 	/* setup serdes lock, configuration list and add default */
 	err = sbl_setup_serdes_configs(sbl);
 	if (err) {
 		sbl_dev_err(sbl->dev, "serdes setup failed [%d]\n", err);
-		goto out_free_sbm_fw_reload_count;
+		goto out_free_spico_prof;
 	}
 
 	/* create link database */
@@ -350,18 +403,44 @@ struct sbl_inst *sbl_new_instance(void *accessor, void *pci_accessor,
 
 	sbl_fec_init(sbl);
 
+	INIT_DELAYED_WORK(&sbl->fw_scrub_work, sbl_fw_scrub_work);
+	mutex_init(&sbl->fw_image_mtx);
+
 	for (i = 0; i < sbl->switch_info->num_ports; ++i) {
 		/* ensure no valid saved tuning params */
 		sbl_serdes_invalidate_tuning_params(sbl, i);
 
 		/* set default values for PML */
 		sbl_pml_set_defaults(sbl, i);
+
+		/* setup for non-blocking start */
+		sbl->link[i].start_async.sbl = sbl;
+		sbl->link[i].start_async.port_num = i;
+		INIT_DELAYED_WORK(&sbl->link[i].start_async.work,
+				sbl_base_link_start_async_work);
+
+		/* setup spico interrupt profile */
+		sbl_spico_prof_init(&sbl->link[i].spico_prof);
+
+		/* setup for background llr loop time re-measurement */
+		sbl->link[i].llr_remeasure.sbl = sbl;
+		sbl->link[i].llr_remeasure.port_num = i;
+		INIT_DELAYED_WORK(&sbl->link[i].llr_remeasure.work,
+				sbl_pml_llr_remeasure_work);
 	}
 
 	return sbl;
 
 out_free_configs:
 	sbl_serdes_clear_all_configs(sbl, true /* clear default */);
+out_free_spico_prof:
+	kfree(sbl->spico_prof);
+out_free_sbus_arb:
+	kfree(sbl->sbus_arb);
+out_free_sbus_prof:
+	kfree(sbl->sbus_prof);
+out_free_sbus_op_log:
+	kfree(sbl->sbus_op_log);
 out_free_sbm_fw_reload_count:
 	kfree(sbl->sbm_fw_reload_count);
 out_free_reload_sbm:
@@ -382,7 +461,8 @@ EXPORT_SYMBOL(sbl_new_instance);
  * @sbl: A slingshot base link device instance
  *
  * This function clears the config and frees all
- * memory associated with an SBL.
+ * memory associated with an SBL. A non-blocking start still in
+ * progress is completed with -ECANCELED.
  *
  * Return: 0 on success, negative error code on failure
  */
@@ -396,9 +476,17 @@ int sbl_delete_instance(struct sbl_inst *sbl)
 	if (err)
 		return err;
 
+	cancel_delayed_work_sync(&sbl->fw_scrub_work);
+
 	for (i = 0; i < sbl->switch_info->num_ports; ++i) {
 		link = sbl->link + i;
+		sbl_base_link_start_async_cancel(sbl, i);
+		cancel_delayed_work_sync(&link->llr_remeasure.work);
 		sbl_link_counters_term(link);
+		kfree(link->serdes_script);
+		link->serdes_script = NULL;
+		kfree(link->tp_history);
+		link->tp_history = NULL;
 		if (link->pml_recovery.started)
 			sbl_pml_recovery_cancel(sbl, i);
 	}
@@ -417,12 +505,19 @@ int sbl_delete_instance(struct sbl_inst *sbl)
 
 	kfree(sbl->link);
 	sbl_serdes_clear_all_configs(sbl, true /* clear default */);
+	sbl_fw_image_cache_flush(sbl);
+	kfree(sbl->spico_prof);
+	kfree(sbl->sbus_arb);
+	kfree(sbl->sbus_prof);
+	kfree(sbl->sbus_op_log);
 	kfree(sbl->sbm_fw_reload_count);
 	kfree(sbl->reload_sbm_fw);
 	kfree(sbl->sbm_fw_mtx);
 	kfree(sbl->sbus_ring_mtx);
 	flush_workqueue(sbl->workq);
 	destroy_workqueue(sbl->workq);
+	if (sbl->ring_workq)
+		destroy_workqueue(sbl->ring_workq);
 	sbl->magic = 0;   /* paranoia */
 	kfree(sbl);
 
@@ -462,6 +557,11 @@ int sbl_initialise_instance(struct sbl_inst *sbl, struct sbl_instance_attr *attr
 	}
 	sbl_dev_err(sbl->dev, "serdes fw loaded");
 
+	/* start the background fw scrubber */
+	if (sbl->is_hw)
+		queue_delayed_work(sbl->workq, &sbl->fw_scrub_work,
+				msecs_to_jiffies(SBL_FW_SCRUB_INTERVAL));
+
 	return 0;
 
 }
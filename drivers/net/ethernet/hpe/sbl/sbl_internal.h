@@ -7,8 +7,11 @@
 
 #include <linux/version.h>
 #include <linux/completion.h>
+#include <linux/workqueue.h>
+#include <linux/kref.h>
 
 #include <uapi/ethernet/sbl_serdes.h>
+#include <uapi/ethernet/sbl_sbm_constants.h>
 
 
 #ifdef TRACE2
@@ -50,6 +53,31 @@
 #define SBL_ASIC_TX_DELAY                              25  /* ns */
 #define SBL_ASIC_RX_DELAY                              91  /* ns */
 
+/* How long a good serdes fw crc check is trusted at link start and
+ * how often the background scrubber re-checks idle ports and rings.
+ */
+#define SBL_FW_CRC_CACHE_TIMEOUT                    60000  /* ms */
+#define SBL_FW_SCRUB_INTERVAL                       30000  /* ms */
+
+/* hybrid serdes op completion polling */
+#define SBL_SERDES_OP_SPIN_MIN_NS                    5000  /* ns */
+#define SBL_SERDES_OP_SPIN_MAX_NS                  100000  /* ns */
+#define SBL_SERDES_OP_SLEEP_MIN_US                     20  /* us */
+#define SBL_SERDES_OP_LEARN_WEIGHT                      8  /* 1/8 of each new sample */
+
+/* tuning params quality ranking */
+#define SBL_TP_QUALITY_EARLY_PERIOD                300000  /* ms, early part of a link up */
+#define SBL_TP_SCORE_EYE                              100  /* per unit of smallest eye height */
+#define SBL_TP_SCORE_UP_MIN                            50  /* per minute up, up to an hour */
+#define SBL_TP_SCORE_FAIL                           10000  /* scaled by the early link down ratio */
+#define SBL_TP_SCORE_CCW                              200  /* per doubling of the worst ccw rate */
+#define SBL_TP_SCORE_UCW                             5000  /* any ucw seen */
+
+/* adaptive dfe tune effort, the prior is worth SBL_DFE_EFFORT_PRIOR_TRIES tunes */
+#define SBL_DFE_EFFORT_PRIOR_TRIES                      4
+#define SBL_DFE_EFFORT_ESCALATE                         3  /* failed tunes before max effort */
+#define SBL_DFE_EFFORT_EXPLORE                         16  /* tunes between tries of a lower effort */
+
 #define SBL_PML_REC_POLL_INTERVAL                       4  /* ms */
 #define SBL_PML_REC_LLR_TIMEOUT_OFFSET                  8  /* ms */
 
@@ -77,6 +105,287 @@ struct sbl_pml_recovery {
 	__u64 rl_window_start;
 	int rl_time_remaining;
 };
+
+/* non-blocking base link start */
+struct sbl_start_async {
+	struct sbl_inst *sbl;
+	int port_num;
+	int phase;                                /* next start phase to run */
+	bool resume;                              /* phase is waiting to be resumed */
+	bool in_flight;                           /* start queued and not yet completed (busy_mtx) */
+	struct delayed_work work;
+};
+
+/* resumable pml start progress */
+struct sbl_pml_wait {
+	int state;                                /* enum sbl_pml_wait_state */
+	ktime_t begin;                            /* when the pcs wait or llr start began */
+	unsigned long start_jiffy;                /* when the current wait began */
+	unsigned long restart_jiffy;              /* last pcs lock restart */
+	unsigned long check_jiffy;                /* last pcs serdes health check */
+	unsigned int lock_restart;                /* pcs lock restart time (ms) */
+	unsigned int align_restart;               /* pcs align restart time (ms) */
+	int no_fault_count;                       /* consecutive polls without a pcs fault */
+	bool llr_remeasure;                       /* re-measure the cached llr loop time once up */
+};
+
+/* resumable serdes start progress */
+struct sbl_serdes_wait {
+	int state;                                /* enum sbl_serdes_wait_state */
+	unsigned long last_jiffy;                 /* end of the optical lock delay or dfe tune wait */
+	int pre_delay_left;                       /* dfe pre delay still to wait (s) */
+	bool is_retune;                           /* tuning from saved params */
+	bool is_seeded;                           /* tuning from a peer's params */
+	u64 tune_start_ns;                        /* when the current tune started */
+	u8 serdes_mask;                           /* lanes being tuned */
+	u8 in_progress_mask;                      /* lanes still tuning */
+	u8 tuned_mask;                            /* lanes which have tuned */
+};
+
+/* background llr loop time re-measurement */
+struct sbl_llr_remeasure {
+	struct sbl_inst *sbl;
+	int port_num;
+	bool stopped;                             /* llr stopped, don't touch it */
+	struct delayed_work work;
+};
+
+/* binary sbus op log, decoded to strings only when read or dumped */
+#define SBL_SBUS_OP_LOG_SIZE      256             /* records per ring (power of 2) */
+#define SBL_SBUS_OP_LOG_DUMP        8             /* records dumped when an op fails */
+
+struct sbl_sbus_op_rec {
+	u64 seq;                                  /* op number, 0 while being written */
+	u64 ns;                                   /* ktime when the op completed */
+	u32 req_data;
+	u32 rsp_data;
+	u16 sbus_addr;
+	u8  reg_addr;
+	u8  command;
+	u8  result_code;
+	u8  overrun;
+	s16 rc;
+};
+
+struct sbl_sbus_op_log {
+	u64 head;                                 /* number of ops logged */
+	struct sbl_sbus_op_rec rec[SBL_SBUS_OP_LOG_SIZE];
+};
+
+/* sbus ring arbitration, most urgent class first */
+enum sbl_sbus_prio {
+	SBL_SBUS_PRIO_RECOVERY,                   /* link recovery and serdes reset */
+	SBL_SBUS_PRIO_BRINGUP,                    /* link and serdes bring-up */
+	SBL_SBUS_PRIO_FIRMWARE,                   /* firmware check and upload */
+	SBL_SBUS_PRIO_TELEMETRY,                  /* version reads and background checks */
+	SBL_SBUS_PRIO_NUM,
+};
+
+struct sbl_sbus_arb {
+	spinlock_t lock;
+	bool busy;                                /* ring granted */
+	enum sbl_sbus_prio prio;                  /* class of the current holder */
+	unsigned long waiting;                    /* classes with waiters */
+	struct list_head waiters[SBL_SBUS_PRIO_NUM];
+};
+
+/* sbus ring lock and op profile */
+#define SBL_SBUS_PROF_HIST_SIZE    24             /* log2 us buckets, last one open ended */
+#define SBL_SBUS_PROF_HOLDERS       8             /* call sites tracked per ring */
+
+struct sbl_sbus_prof_holder {
+	unsigned long ip;                         /* call site that took the ring lock */
+	u64 count;
+	u64 wait_ns;
+	u64 hold_ns;
+};
+
+struct sbl_sbus_prof {
+	u64 lock_count;
+	u64 contended;                            /* lock calls which had to wait */
+	u64 yields;                               /* ring given up to a more urgent class */
+	u64 wait_hist[SBL_SBUS_PROF_HIST_SIZE];
+	u64 hold_hist[SBL_SBUS_PROF_HIST_SIZE];
+	u64 wait_max_ns;
+	u64 hold_max_ns;
+	u64 op_count;
+	u64 op_hist[SBL_SBUS_PROF_HIST_SIZE];
+	u64 op_max_ns;
+	u64 retry_count;
+	u64 reset_count;
+	u64 sec_start_ns;                         /* start of current ops per second window */
+	u32 sec_ops;
+	u32 ops_per_sec;                          /* ops in the last full window */
+	u32 ops_per_sec_max;
+	struct sbl_sbus_prof_holder holders[SBL_SBUS_PROF_HOLDERS];
+	/* current holder */
+	unsigned long hold_ip;
+	u64 hold_start_ns;
+	u64 hold_wait_ns;
+};
+
+/* spico interrupt profile by interrupt code */
+#define SBL_SPICO_PROF_CODES       32             /* codes tracked per table */
+#define SBL_SPICO_PROF_HIST_SIZE   20             /* log2 us buckets, last one open ended */
+
+enum sbl_spico_prof_table {
+	SBL_SPICO_PROF_SERDES,                    /* instance serdes interrupts */
+	SBL_SPICO_PROF_SBM,                       /* instance sbus master interrupts */
+	SBL_SPICO_PROF_NUM,
+};
+
+struct sbl_spico_prof_entry {
+	int code;
+	u32 count;
+	u32 errors;
+	u32 timeouts;
+	u64 total_ns;
+	u64 max_ns;
+	u32 hist[SBL_SPICO_PROF_HIST_SIZE];
+};
+
+struct sbl_spico_prof {
+	spinlock_t lock;
+	int num_codes;
+	u32 overflow;                             /* interrupts with an untracked code */
+	struct sbl_spico_prof_entry entry[SBL_SPICO_PROF_CODES];
+};
+
+/* resident firmware image, pre-encoded as spico burst words */
+struct sbl_fw_image {
+	struct kref ref;
+	char *fname;                              /* file the image was loaded from */
+	int fw_rev;                               /* rev parsed from the file name */
+	int fw_build;                             /* build parsed from the file name */
+	size_t size;                              /* image size (bytes) */
+	u8 *data;                                 /* raw image */
+	int num_words;                            /* number of burst words */
+	u32 words[];                              /* encoded burst words */
+};
+
+/* result of the last good serdes fw crc check */
+struct sbl_fw_crc {
+	bool valid;
+	unsigned long jiffies;                    /* when the check passed */
+	int reload_gen;                           /* serdes fw reload count at the check */
+	int sbm_gen;                              /* sbm fw reload count at the check */
+};
+
+/* SBL owned HAL values shadowed for each serdes lane */
+enum sbl_hal_shadow_reg {
+	SBL_HAL_SHADOW_ICAL_EFFORT,
+	SBL_HAL_SHADOW_EID_FILTER,
+	SBL_HAL_SHADOW_NUM,
+};
+
+/* write-through shadow of a serdes lane's HAL values */
+struct sbl_hal_shadow {
+	bool sel_valid;                           /* is the selected HAL address known */
+	u16 sel;                                  /* selected HAL address */
+	unsigned long valid;                      /* map of valid values */
+	u16 value[SBL_HAL_SHADOW_NUM];            /* last value read or written */
+};
+
+/* dfe tune effort levels, in increasing effort */
+enum sbl_dfe_effort {
+	SBL_DFE_EFFORT_MIN,
+	SBL_DFE_EFFORT_MED,
+	SBL_DFE_EFFORT_MAX,
+	SBL_DFE_EFFORT_NUM,
+};
+
+#define SBL_DFE_EFFORT_MEDIA_NUM        (SBL_LINK_MEDIA_OPTICAL + 1)
+
+/* tunes at one effort level */
+struct sbl_dfe_effort_stats {
+	u32 tries;
+	u32 good;
+	u64 total_ms;                             /* time of all tries, good or not */
+};
+
+/* compiled serdes config, see sbl_serdes_config() */
+#define SBL_SERDES_SCRIPT_MAX_OPS       192
+
+enum sbl_serdes_script_op_type {
+	SBL_SCRIPT_OP_INT,                        /* spico interrupt, result validated */
+	SBL_SCRIPT_OP_INT_CONFIG,                 /* config list interrupt, result only logged */
+	SBL_SCRIPT_OP_HAL_WRITE,                  /* select HAL address code, write data */
+	SBL_SCRIPT_OP_MEM_RMW,                    /* rmw serdes memory address code with data, mask arg */
+	SBL_SCRIPT_OP_ENABLE,                     /* set tx/rx/txo enables, data is SBL_SCRIPT_EN_* */
+	SBL_SCRIPT_OP_DATA_SEL,                   /* set tx data select to data */
+	SBL_SCRIPT_OP_DELAY,                      /* sleep for data us */
+};
+
+#define SBL_SCRIPT_EN_TX                BIT(0)
+#define SBL_SCRIPT_EN_RX                BIT(1)
+#define SBL_SCRIPT_EN_TXO               BIT(2)
+
+struct sbl_serdes_script_op {
+	u8 type;
+	u8 lanes;                                 /* serdes lanes to apply to */
+	u16 code;
+	u16 data;
+	u16 arg;
+};
+
+/* everything a compiled serdes config depends on */
+struct sbl_serdes_script_key {
+	bool allow_an;
+	u32 an_mode;
+	u32 link_mode;
+	u32 loopback_mode;
+	u32 link_partner;
+	u32 tuning_pattern;
+	u32 precoding;
+	u32 options;
+	u32 debug_config;
+	u32 rx_phase_slip_cnt;
+	u32 config_seq;                           /* serdes config list sequence */
+	u64 tp_state_hash0;                       /* media and mode hash */
+	u64 tp_state_hash1;
+};
+
+struct sbl_serdes_script {
+	struct sbl_serdes_script_key key;
+	bool set_precoding;                       /* update link precoding_enabled */
+	bool precoding_enabled;
+	bool overflow;                            /* ran out of ops while compiling */
+	int num_ops;
+	struct sbl_serdes_script_op ops[SBL_SERDES_SCRIPT_MAX_OPS];
+};
+
+/* tuning params saved for an earlier configuration */
+#define SBL_TP_HISTORY_SLOTS            4
+#define SBL_TP_HISTORY_CANDIDATES       2         /* sets kept for the same tp state hashes */
+
+/* how well a set of tuning params has worked */
+struct sbl_tp_quality {
+	s16 min_eye;                              /* smallest eye height when saved */
+	u32 up_count;                             /* fec up checks passed */
+	u32 fail_count;                           /* early link downs */
+	u64 up_ccw;                               /* worst fec up check ccw rate */
+	u64 up_ucw;                               /* worst fec up check ucw rate */
+	u64 early_ccw;                            /* worst ccw rate early in a link up */
+	u64 early_ucw;                            /* worst ucw rate early in a link up */
+	unsigned long up_ms;                      /* longest time up */
+};
+
+struct sbl_tp_slot {
+	u64 last_used;                            /* tp_history_clock when last stored or restored */
+	struct sbl_tp_quality quality;
+	struct sbl_tuning_params tp;
+};
+
+/* memoised serdes config lookup for a lane */
+struct sbl_sc_memo {
+	bool valid;
+	u32 config_seq;                           /* serdes config list sequence */
+	u64 tp_state_hash0;                       /* media and mode hash looked up */
+	u64 tp_state_hash1;
+	int rc;                                   /* result of the lookup */
+	struct sbl_sc_values vals;                /* values found */
+};
+
 /* link database record */
 struct sbl_link {
 	int num;                                  /* link/port number */
@@ -106,6 +415,8 @@ struct sbl_link {
 	ktime_t tune_time_begin;                  /* timestamp when serdes started tuning (for sysfs) */
 	struct timespec64 tune_time;              /* time for serdes tuning attempt to complete (for sysfs) */
 	struct timespec64 total_tune_time;        /* total time for serdes tuning to complete (for sysfs) */
+	struct sbl_link_phase_stats phase_stats[SBL_LINK_PHASE_NUM]; /* bring-up phase latencies */
+	spinlock_t phase_stats_lock;              /* protect phase latencies */
 
 	u32 active_rx_lanes;                      /* pcs rx lanes in use for the current mode */
 	u32 active_fec_lanes;                     /* fec lanes in use for the current mode */
@@ -118,16 +429,35 @@ struct sbl_link {
 	u32 an_try_count;                         /* number of autoneg attempts */
 	u32 an_nonce;                             /* The nonce used for autoneg */
 	struct completion an_hw_change;           /* signal an hw err flag has been set */
+	int an_wait_state;                        /* enum sbl_an_wait_state */
+	unsigned long an_last_jiffy;              /* end of the base page wait */
 	bool an_timeout_active;                   /* are we using the autoneg timeout */
 	bool an_100cr4_fixup_applied;             /* have applied this fixup */
 	u32 an_options;                           /* actual an options received */
 	int lp_subtype;                           /* link partner subtype */
 
 	bool reload_serdes_fw;                    /* do we need to reload the serdes fw */
+	struct sbl_fw_crc fw_crc[SBL_SERDES_LANES_PER_PORT]; /* cached serdes fw crc checks */
+	spinlock_t fw_crc_lock;                   /* protect cached fw crc checks */
+
+	struct sbl_spico_prof spico_prof;         /* serdes spico interrupt profile */
+
+	struct sbl_hal_shadow hal_shadow[SBL_SERDES_LANES_PER_PORT]; /* shadowed serdes HAL values */
+	spinlock_t hal_shadow_lock;               /* protect shadowed HAL values */
+	struct sbl_serdes_script *serdes_script;  /* compiled serdes config */
+	struct sbl_sc_memo sc_memo[SBL_SERDES_LANES_PER_PORT]; /* last serdes config lookups */
 	bool lp_detected;                         /* has link partner been detected */
 	int lpd_try_count;                        /* count of lp detect attempts */
 
 	int dfe_tune_count;                       /* track the number of dfe tuning attempts */
+	int dfe_effort;                           /* chosen effort for this tune, or SBL_DFE_EFFORT_NUM */
+	u32 dfe_effort_runs;                      /* tunings since the last try of a lower effort */
+	bool dfe_effort_pending;                  /* good tune waiting for the fec up check */
+	u16 dfe_effort_pending_ical;              /* ICAL effort of the pending tune */
+	u64 dfe_effort_pending_ns;                /* ktime the pending tune started */
+	struct sbl_dfe_effort_stats dfe_effort_stats[SBL_DFE_EFFORT_MEDIA_NUM][SBL_DFE_EFFORT_NUM];
+	spinlock_t dfe_effort_lock;               /* protect dfe effort stats */
+	struct sbl_serdes_wait serdes_wait;       /* serdes start wait progress */
 	bool optical_delay_active;                /* waiting in dfe-pre-delay before serdes tuning */
 	bool dfe_predelay_active;                 /* waiting in dfe-pre-delay before serdes tuning */
 	bool pcal_running;                        /* periodic calibration running */
@@ -136,7 +466,14 @@ struct sbl_link {
 	u32 ical_effort;                          /* serdes tuning effort level */
 	struct sbl_tuning_params tuning_params;   /* saved serdes tuning parameters */
 	struct mutex tuning_params_mtx;           /* lock tuning params */
+	struct sbl_tp_slot *tp_history;           /* tuning params for other configurations */
+	u64 tp_history_clock;                     /* tuning params history lru clock */
+	int tp_active_slot;                       /* history slot of the active params, or -1 */
+	unsigned long tp_up_jiffies;              /* when the link came up on the active params */
 	bool start_cancelled;                     /* starting procedure was cancelled */
+	struct sbl_start_async start_async;       /* non-blocking start state */
+	ktime_t start_phase_begin;                /* when the running start phase began */
+	u32 start_wait_ms;                        /* wait before resuming the running start phase */
 
 	u32 link_mode;                            /* actual link mode to use after AN */
 	u32 ifg_config;                           /* actual ifg config */
@@ -145,11 +482,19 @@ struct sbl_link {
 	u32 llr_mode;                             /* actual llr mode used */
 	u32 llr_options;                          /* actual llr options used */
 	u64 llr_loop_time;                        /* the measured llr round trip time (ns) */
+	u64 llr_loop_time_cached;                 /* last llr round trip time measured (ns) */
+	struct sbl_media_attr llr_loop_mattr;     /* media the cached loop time was measured with */
+	u32 llr_loop_loopback_mode;               /* loopback mode the cached loop time was measured in */
+	struct sbl_llr_remeasure llr_remeasure;   /* background loop time re-measurement */
 
 	u64 intr_err_flgs;                        /* error flags registered with handler */
 	struct mutex serdes_mtx;                  /* lock for serdes operations */
 	atomic_t debug_config;                    /* debug flags */
 
+	struct sbl_pml_wait pml_wait;             /* pml start wait progress */
+	u32 pcs_lock_time_avg;                    /* average time for the pcs to lock (ms) */
+	u32 pcs_align_time_avg;                   /* average time for the pcs to align once locked (ms) */
+
 	bool       pcs_recovery_flag;             /* PCS recovery flag */
 	spinlock_t pcs_recovery_lock;             /* PCS recovery lock */
 
@@ -188,6 +533,8 @@ bool sbl_start_timeout(struct sbl_inst *sbl, int port_num);
 void sbl_start_timeout_ensure_remaining(struct sbl_inst *sbl, int port_num,
 		unsigned int remaining_s);
 u32  sbl_get_start_timeout(struct sbl_inst *sbl, int port_num);
+int  sbl_start_wait(struct sbl_inst *sbl, int port_num, unsigned int wait_ms);
+void sbl_start_wait_sleep(struct sbl_inst *sbl, int port_num);
 int  sbl_link_start_elapsed(struct sbl_inst *sbl, int port_num);
 void sbl_link_start_record_timespec(struct sbl_inst *sbl, int port_num);
 void sbl_link_up_begin(struct sbl_inst *sbl, int port_num);
@@ -196,9 +543,60 @@ void sbl_link_tune_begin(struct sbl_inst *sbl, int port_num);
 int  sbl_link_tune_elapsed(struct sbl_inst *sbl, int port_num);
 void sbl_link_tune_zero_total_timespec(struct sbl_inst *sbl, int port_num);
 void sbl_link_tune_update_total_timespec(struct sbl_inst *sbl, int port_num);
+void sbl_link_phase_record(struct sbl_inst *sbl, int port_num, int phase,
+		ktime_t begin, int err);
 int sbl_switch_info_get(struct sbl_inst *sbl, struct sbl_init_attr *init_attr);
 
 
+/* sbus ring arbitration */
+void sbl_sbus_arb_init(struct sbl_sbus_arb *arb);
+bool sbl_sbus_arb_acquire(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio);
+bool sbl_sbus_arb_tryacquire(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio);
+void sbl_sbus_arb_release(struct sbl_inst *sbl, int sbus_ring);
+bool sbl_sbus_arb_preempted(struct sbl_inst *sbl, int sbus_ring);
+enum sbl_sbus_prio sbl_sbus_arb_prio(struct sbl_inst *sbl, int sbus_ring);
+
+
+/* sbus ring lock with arbitration and profiling */
+void sbl_sbus_ring_lock(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio);
+bool sbl_sbus_ring_trylock(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio);
+void sbl_sbus_ring_unlock(struct sbl_inst *sbl, int sbus_ring);
+void sbl_sbus_ring_yield(struct sbl_inst *sbl, int sbus_ring);
+void sbl_sbus_prof_ops(struct sbl_inst *sbl, int sbus_ring, int num_ops, u64 start_ns);
+void sbl_sbus_prof_retry(struct sbl_inst *sbl, int sbus_ring);
+void sbl_sbus_prof_reset(struct sbl_inst *sbl, int sbus_ring);
+
+
+/* spico interrupt profiling */
+void sbl_spico_prof_init(struct sbl_spico_prof *prof);
+void sbl_spico_prof_serdes(struct sbl_inst *sbl, int port_num, int code,
+		u64 start_ns, int err, int num_lanes);
+void sbl_spico_prof_sbm(struct sbl_inst *sbl, int code, u64 start_ns, int err);
+
+
+/* serdes HAL shadow */
+void sbl_hal_shadow_update(struct sbl_inst *sbl, int port_num, int serdes,
+		int code, int data, int err, const u16 *result);
+void sbl_hal_shadow_invalidate(struct sbl_inst *sbl, int port_num, u32 lane_mask);
+int sbl_serdes_hal_set(struct sbl_inst *sbl, int port_num, int serdes,
+		enum sbl_hal_shadow_reg reg, u16 value);
+int sbl_serdes_hal_set_lanes(struct sbl_inst *sbl, int port_num, u32 lane_mask,
+		enum sbl_hal_shadow_reg reg, u16 value);
+
+
+/* adaptive dfe tune effort */
+int sbl_dfe_effort_choose(struct sbl_inst *sbl, int port_num);
+u16 sbl_dfe_effort_ical(int effort);
+void sbl_dfe_effort_record(struct sbl_inst *sbl, int port_num, u16 ical_effort,
+		int err, u64 start_ns);
+void sbl_dfe_effort_up_check(struct sbl_inst *sbl, int port_num, int err);
+
+
+/* non-blocking start */
+void sbl_base_link_start_async_work(struct work_struct *work);
+void sbl_base_link_start_async_cancel(struct sbl_inst *sbl, int port_num);
+
+
 /* misc */
 int sbl_validate_port_num(struct sbl_inst *sbl, int port_num);
 const char *sbl_an_state_str(int state);
@@ -246,6 +644,14 @@ static inline int sbl_sbus_op_reset(struct sbl_inst *sbl, int ring)
 	return (*sbl->ops.sbl_sbus_op_reset)(sbl->accessor, ring);
 }
 
+static inline int sbl_sbus_op_batch(struct sbl_inst *sbl, int ring,
+		struct sbl_sbus_op_desc *desc, int num_ops,
+		int timeout, unsigned int flags)
+{
+	return (*sbl->ops.sbl_sbus_op_batch)(sbl->accessor, ring,
+			desc, num_ops, timeout, flags);
+}
+
 /* misc other functions */
 static inline bool sbl_is_fabric_link(struct sbl_inst *sbl, int port_num)
 {
@@ -262,6 +668,12 @@ static inline void sbl_async_alert(struct sbl_inst *sbl, int port_num, int alert
 {
 	(*sbl->ops.sbl_async_alert)(sbl->accessor, port_num, alert_type, alert_data, size);
 }
+
+static inline void sbl_link_start_complete(struct sbl_inst *sbl, int port_num, int err)
+{
+	if (sbl->ops.sbl_link_start_complete)
+		(*sbl->ops.sbl_link_start_complete)(sbl->accessor, port_num, err);
+}
 void sbl_llr_max_data_get(struct sbl_inst *sbl, int port_num,
 				u64 *cap_data_max, u64 *cap_seq_max);
 int sbl_frame_size(struct sbl_inst *sbl, int port_num);
@@ -6,6 +6,8 @@
 #include <linux/kernel.h>
 #include <linux/device.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_an.h>
@@ -53,6 +55,10 @@ static int sbl_base_link_check_fix_fw(struct sbl_inst *sbl, int port_num)
 	int err;
 
 	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+		/* trust a recent good check if the fw has not been reloaded */
+		if (sbl_serdes_fw_crc_cached(sbl, port_num, serdes))
+			continue;
+
 		err = sbl_validate_serdes_fw_crc(sbl, port_num, serdes);
 		if (err) {
 			/* Any lane with corrputed FW will cause all lanes for
@@ -60,6 +66,7 @@ static int sbl_base_link_check_fix_fw(struct sbl_inst *sbl, int port_num)
 			 */
 			goto reload_fw;
 		}
+		sbl_serdes_fw_crc_record(sbl, port_num, serdes);
 	}
 	return 0;
 
@@ -74,11 +81,12 @@ static int sbl_base_link_check_fix_fw(struct sbl_inst *sbl, int port_num)
 	return err;
 }
 
-static int sbl_link_get_mode_electrical(struct sbl_inst *sbl, int port_num)
+static int sbl_link_get_mode_electrical(struct sbl_inst *sbl, int port_num, bool resume)
 {
-	sbl_dev_dbg(sbl->dev, "bl %d: elec get mode", port_num);
+	if (!resume)
+		sbl_dev_dbg(sbl->dev, "bl %d: elec get mode", port_num);
 
-	return sbl_link_autoneg(sbl, port_num);
+	return sbl_link_autoneg(sbl, port_num, resume);
 }
 
 /* For now we will just use the configured speed */
@@ -94,7 +102,7 @@ static int sbl_link_get_mode_optical(struct sbl_inst *sbl, int port_num)
 }
 
 /* determine the link mode (speed) */
-static int sbl_base_link_get_mode(struct sbl_inst *sbl, int port_num)
+static int sbl_base_link_get_mode(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link = sbl->link + port_num;
 	int err = 0;
@@ -109,7 +117,7 @@ static int sbl_base_link_get_mode(struct sbl_inst *sbl, int port_num)
 	switch (link->mattr.media) {
 
 	case SBL_LINK_MEDIA_ELECTRICAL:
-		err = sbl_link_get_mode_electrical(sbl, port_num);
+		err = sbl_link_get_mode_electrical(sbl, port_num, resume);
 		break;
 
 	case SBL_LINK_MEDIA_OPTICAL:
@@ -348,62 +356,21 @@ int sbl_base_link_config(struct sbl_inst *sbl, int port_num, struct sbl_base_lin
 }
 EXPORT_SYMBOL(sbl_base_link_config);
 
-/**
- * sbl_base_link_start() - Initialize and bring up links
- * @sbl: A slingshot base link device instance
- * @port_num: port number
- *
- * This function performs full sequence to bring up serdes link.
- * It handles firmware validation, link mode detection, alignment,
- * SerDes startup and link integrity checks. This process ensures
- * link partner is detected and all lanes are properly initialized
- * and active before reporting the link is up
- *
- * Context: Process, May sleep. Uses mutex_lock_interruptible
- *
- * Return: 0 on success, negative error code on failure
- */
-int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
+/* check the link is in a state to be started (busy_mtx held) */
+static int sbl_base_link_start_check(struct sbl_inst *sbl, int port_num)
 {
+	struct sbl_link *link = sbl->link + port_num;
 	int err;
-	int tmp_err;
-	u32 base = SBL_PML_BASE(port_num);
-	u64 cfg_pcs_reg;
-	u64 sts_pcs_lane_degrade_reg;
-	struct lane_degrade lanes;
-	u32 ucw_adj = 100;
-	u32 ccw_adj = 0;
-	s32 ucw_in = SBL_LINK_FEC_HPE;
-	s32 ccw_in = SBL_LINK_FEC_HPE;
-	struct sbl_link *link;
-
-	err = sbl_validate_instance(sbl);
-	if (err)
-		return err;
-
-	err = sbl_validate_port_num(sbl, port_num);
-	if (err)
-		return err;
-
-	sbl_dev_dbg(sbl->dev, "bl %d: start\n", port_num);
-
-	link = sbl->link + port_num;
-
-	err = mutex_lock_interruptible(&link->busy_mtx);
-	if (err)
-		return -ERESTARTSYS;
 
 	if (link->blstate == SBL_BASE_LINK_STATUS_UP) {
 		/* link came up while waiting for the mutex */
-		mutex_unlock(&link->busy_mtx);
-		return 0;
+		return -EALREADY;
 	}
 
 	if (link->blstate != SBL_BASE_LINK_STATUS_DOWN) {
 
 		sbl_dev_err(sbl->dev, "bl %d: wrong state (%s) for start", port_num,
 			sbl_link_state_str(link->blstate));
-		mutex_unlock(&link->busy_mtx);
 		return -EUCLEAN;
 	}
 
@@ -412,11 +379,18 @@ int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
 		err = sbl_media_validate_config(sbl, port_num);
 		if (err) {
 			sbl_dev_err(sbl->dev, "bl %d: config unsuitable for media type", port_num);
-			mutex_unlock(&link->busy_mtx);
 			return err;
 		}
 	}
 
+	return 0;
+}
+
+/* move the link into the starting state (busy_mtx held) */
+static void sbl_base_link_start_init(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
 	link->blstate = SBL_BASE_LINK_STATUS_STARTING;
 
 	/* check for loopback mode change */
@@ -434,104 +408,48 @@ int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
 
 	/* reset state */
 	link->lp_detected = false;
+}
 
-	/* validate serdes firmwares are (still) uncorrupted, recover them if
-	 * needed
-	 */
-	err = sbl_base_link_check_fix_fw(sbl, port_num);
-	if (err) {
-		sbl_base_link_report_err(sbl, "ensure_healthly", port_num, err);
-		goto out;
-	}
-
-	/* determine the link mode
-	 * this may do autoneg for electrical links
-	 */
-	err = sbl_base_link_get_mode(sbl, port_num);
-	if (err) {
-		if (sbl_base_link_an_timed_out(sbl, port_num, err))
-			sbl_dev_dbg(sbl->dev, "bl %d: autoneg timeout", port_num);
-		else
-			sbl_base_link_report_err(sbl, "get_mode", port_num, err);
-		goto out;
-	}
-
-	/* start sending alignment markers for lp to tune against */
-	err = sbl_pml_pcs_am_start(sbl, port_num);
-	if (err) {
-		sbl_dev_err(sbl->dev, "bl %d: am_start failed [%d]\n", port_num, err);
-		goto out;
-	}
-
-	/* wait until we detect the link partner */
-	err = sbl_base_link_lp_detect(sbl, port_num);
-	if (err) {
-		sbl_base_link_report_err(sbl, "lpd", port_num, err);
-		goto out;
-	}
-
-	/* record when we really start to bring up the link */
-	sbl_link_up_begin(sbl, port_num);
-
-	/* start the serdes */
-	err = sbl_serdes_start(sbl, port_num);
-	if (err) {
-		sbl_base_link_report_err(sbl, "serdes_start", port_num, err);
-		goto out;
-	}
-
-	/* start the pml block (pcs,mac,llr) */
-	err = sbl_pml_start(sbl, port_num);
-	if (err) {
-		sbl_base_link_report_err(sbl, "pml_start", port_num, err);
-		goto out_serdes;
-	}
+/* setup thresholds and adjustments for fec monitoring */
+static int sbl_base_link_fec_setup(struct sbl_inst *sbl, int port_num)
+{
+	u32 ucw_adj = 100;
+	u32 ccw_adj = 0;
+	s32 ucw_in = SBL_LINK_FEC_HPE;
+	s32 ccw_in = SBL_LINK_FEC_HPE;
+	int err;
 
 	/* clearing fec values before start */
 	sbl_zero_all_fec_counts(sbl, port_num);
 
-	/* setup thresholds and adjustments for fec monitoring */
 	err = sbl_fec_thresholds_set(sbl, port_num, ucw_in, ccw_in);
 	if (err) {
 		sbl_dev_err(sbl->dev, "%d: setting fec thresholds failed [%d]",
 				port_num, err);
-		goto out_pcs;
+		return err;
 	}
 
 	err = sbl_fec_adjustments_set(sbl, port_num, ucw_adj, ccw_adj);
 	if (err) {
 		sbl_dev_err(sbl->dev, "%d: setting fec adjustments failed [%d]",
 				port_num, err);
-		goto out_pcs;
+		return err;
 	}
 
-	/* start fec checking */
-	err = sbl_fec_up_check(sbl, port_num);
-	if (err) {
-		sbl_serdes_invalidate_tuning_params(sbl, port_num);
-		sbl_dev_info(sbl->dev, "%d: failed start fec check", err);
-
-		/* SSHOTPLAT-5697 forces a maximum effort tune
-		 * straight away after FEC up check fails.
-		 */
-		sbl_dev_dbg(sbl->dev, "bl %d: forcing a maximum effort tune for next retry", port_num);
-		link->blattr.options |= SBL_OPT_DFE_ALWAYS_MAX_EFFORT;
-
-		goto out_pcs;
-	}
+	return 0;
+}
 
-	/* start monitoring for link faults */
-	err = sbl_link_fault_monitor_start(sbl, port_num);
-	if (err) {
-		sbl_dev_err(sbl->dev, "bl %d: link fault detect start failed [%d]\n", port_num, err);
-		goto out_pcs;
-	}
+/* final check the link is still up and all lanes remain active */
+static int sbl_base_link_up_check(struct sbl_inst *sbl, int port_num)
+{
+	u32 base = SBL_PML_BASE(port_num);
+	u64 cfg_pcs_reg;
+	u64 sts_pcs_lane_degrade_reg;
+	struct lane_degrade lanes;
 
-	/* final check the link is still up and all lanes remain active */
 	if (!sbl_pml_pcs_up(sbl, port_num)) {
 		sbl_dev_err(sbl->dev, "bl %d: link failed during startup\n", port_num);
-		err = -ENETDOWN;
-		goto out_fm;
+		return -ENETDOWN;
 	}
 
 	cfg_pcs_reg = sbl_read64(sbl, base | SBL_PML_CFG_PCS_OFFSET);
@@ -544,11 +462,141 @@ int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
 		if (lanes.tx != SBL_LINK_ALL_LANES || lanes.rx != SBL_LINK_ALL_LANES) {
 			sbl_dev_err(sbl->dev, "bl %d: lane failed during startup - TX: 0x%llx - RX: 0x%llx",
 				    port_num, lanes.tx, lanes.rx);
-			err = -ENETDOWN;
-			goto out_fm;
+			return -ENETDOWN;
 		}
 	}
 
+	return 0;
+}
+
+/* run a single phase of the start sequence (busy_mtx held)
+ *
+ * returns -EINPROGRESS if the phase has to wait, it is then run again
+ * with resume set after link->start_wait_ms
+ */
+static int sbl_base_link_start_phase(struct sbl_inst *sbl, int port_num, int phase,
+		bool resume)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int err = 0;
+
+	if (!resume)
+		link->start_phase_begin = ktime_get();
+
+	switch (phase) {
+
+	case SBL_START_PHASE_FW_CHECK:
+		/* validate serdes firmwares are (still) uncorrupted, recover them if
+		 * needed
+		 */
+		err = sbl_base_link_check_fix_fw(sbl, port_num);
+		if (err)
+			sbl_base_link_report_err(sbl, "ensure_healthly", port_num, err);
+		break;
+
+	case SBL_START_PHASE_GET_MODE:
+		/* determine the link mode
+		 * this may do autoneg for electrical links
+		 */
+		err = sbl_base_link_get_mode(sbl, port_num, resume);
+		if (err && (err != -EINPROGRESS)) {
+			if (sbl_base_link_an_timed_out(sbl, port_num, err))
+				sbl_dev_dbg(sbl->dev, "bl %d: autoneg timeout", port_num);
+			else
+				sbl_base_link_report_err(sbl, "get_mode", port_num, err);
+		}
+		break;
+
+	case SBL_START_PHASE_AM_START:
+		/* start sending alignment markers for lp to tune against */
+		err = sbl_pml_pcs_am_start(sbl, port_num);
+		if (err)
+			sbl_dev_err(sbl->dev, "bl %d: am_start failed [%d]\n", port_num, err);
+		break;
+
+	case SBL_START_PHASE_LPD:
+		/* wait until we detect the link partner */
+		err = sbl_base_link_lp_detect(sbl, port_num);
+		if (err) {
+			sbl_base_link_report_err(sbl, "lpd", port_num, err);
+			break;
+		}
+
+		/* record when we really start to bring up the link */
+		sbl_link_up_begin(sbl, port_num);
+		break;
+
+	case SBL_START_PHASE_SERDES_START:
+		/* start the serdes */
+		err = sbl_serdes_start(sbl, port_num, resume);
+		if (err && (err != -EINPROGRESS))
+			sbl_base_link_report_err(sbl, "serdes_start", port_num, err);
+		break;
+
+	case SBL_START_PHASE_PML_START:
+		/* start the pml block (pcs,mac,llr) */
+		err = sbl_pml_start(sbl, port_num, resume);
+		if (err && (err != -EINPROGRESS))
+			sbl_base_link_report_err(sbl, "pml_start", port_num, err);
+		break;
+
+	case SBL_START_PHASE_FEC_SETUP:
+		err = sbl_base_link_fec_setup(sbl, port_num);
+		break;
+
+	case SBL_START_PHASE_FEC_UP_CHECK:
+		/* start fec checking */
+		err = sbl_fec_up_check(sbl, port_num, resume);
+		if (err == -EINPROGRESS)
+			return err;
+		sbl_dfe_effort_up_check(sbl, port_num, err);
+		if (err) {
+			sbl_serdes_invalidate_tuning_params(sbl, port_num);
+			sbl_dev_info(sbl->dev, "%d: failed start fec check", err);
+
+			/* SSHOTPLAT-5697 forces a maximum effort tune
+			 * straight away after FEC up check fails.
+			 * An adaptive effort link has counted the failure
+			 * against the effort it used instead.
+			 */
+			if (!(link->blattr.options & SBL_OPT_DFE_ADAPTIVE_EFFORT)) {
+				sbl_dev_dbg(sbl->dev, "bl %d: forcing a maximum effort tune for next retry", port_num);
+				link->blattr.options |= SBL_OPT_DFE_ALWAYS_MAX_EFFORT;
+			}
+		} else {
+			sbl_tp_quality_up(sbl, port_num);
+		}
+		break;
+
+	case SBL_START_PHASE_FAULT_MON:
+		/* start monitoring for link faults */
+		err = sbl_link_fault_monitor_start(sbl, port_num);
+		if (err)
+			sbl_dev_err(sbl->dev, "bl %d: link fault detect start failed [%d]\n", port_num, err);
+		break;
+
+	case SBL_START_PHASE_LINK_CHECK:
+		err = sbl_base_link_up_check(sbl, port_num);
+		break;
+
+	default:
+		sbl_dev_err(sbl->dev, "bl %d: bad start phase %d\n", port_num, phase);
+		return -EINVAL;
+	}
+
+	if (err == -EINPROGRESS)
+		return err;
+
+	sbl_link_phase_record(sbl, port_num, phase, link->start_phase_begin, err);
+
+	return err;
+}
+
+/* the link is up (busy_mtx held) */
+static void sbl_base_link_start_done(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
 	/* success ! */
 	sbl_link_up_record_timespec(sbl, port_num);
 	sbl_link_start_record_timespec(sbl, port_num);
@@ -558,20 +606,27 @@ int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
 
 	sbl_dev_dbg(sbl->dev, "starting timer port_num:%d ", port_num);
 	mod_timer(&link->fec_data->fec_timer, jiffies + msecs_to_jiffies(SBL_FEC_MON_PERIOD));
-	mutex_unlock(&link->busy_mtx);
+}
 
-	return 0;
+/* undo all the phases before the failed one (busy_mtx held) */
+static void sbl_base_link_start_fail(struct sbl_inst *sbl, int port_num, int phase, int err)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int tmp_err;
+
+	if (phase > SBL_START_PHASE_FAULT_MON)
+		sbl_link_fault_monitor_stop(sbl, port_num);
+
+	if (phase > SBL_START_PHASE_PML_START) {
+		if (!sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_CLEANUP))
+			sbl_pml_link_down(sbl, port_num);
+	}
+
+	if (phase > SBL_START_PHASE_SERDES_START) {
+		if (!sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_CLEANUP))
+			sbl_serdes_stop(sbl, port_num);
+	}
 
-	/* failed */
-out_fm:
-	sbl_link_fault_monitor_stop(sbl, port_num);
-out_pcs:
-	if (!sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_CLEANUP))
-		sbl_pml_link_down(sbl, port_num);
-out_serdes:
-	if (!sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_CLEANUP))
-		sbl_serdes_stop(sbl, port_num);
-out:
 	if (sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_CLEANUP) ||
 			sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_RELOAD_FW))
 		link->reload_serdes_fw = false;
@@ -593,12 +648,366 @@ out:
 	}
 	link->blstate = SBL_BASE_LINK_STATUS_ERROR;
 	link->blerr = err;
-	mutex_unlock(&link->busy_mtx);
+}
+
+/* is the phase mostly sbus work */
+static bool sbl_base_link_start_phase_uses_sbus(int phase)
+{
+	return (phase == SBL_START_PHASE_FW_CHECK) ||
+		(phase == SBL_START_PHASE_SERDES_START);
+}
+
+/* run one step of a phase, holding the ring gate (if any) for sbus phases */
+static int sbl_base_link_start_gated_phase(struct sbl_inst *sbl, int port_num,
+		int phase, bool resume, struct mutex *ring_gate)
+{
+	int err;
+
+	if (!ring_gate || !sbl_base_link_start_phase_uses_sbus(phase))
+		return sbl_base_link_start_phase(sbl, port_num, phase, resume);
+
+	mutex_lock(ring_gate);
+	err = sbl_base_link_start_phase(sbl, port_num, phase, resume);
+	mutex_unlock(ring_gate);
 
 	return err;
 }
+
+/* blocking start, see sbl_base_link_start_many() for the ring gate */
+static int sbl_base_link_start_gated(struct sbl_inst *sbl, int port_num,
+		struct mutex *ring_gate)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int phase;
+	int err;
+
+	err = mutex_lock_interruptible(&link->busy_mtx);
+	if (err)
+		return -ERESTARTSYS;
+
+	err = sbl_base_link_start_check(sbl, port_num);
+	if (err) {
+		mutex_unlock(&link->busy_mtx);
+		return (err == -EALREADY) ? 0 : err;
+	}
+
+	sbl_base_link_start_init(sbl, port_num);
+
+	for (phase = 0; phase < SBL_START_PHASE_NUM; ++phase) {
+		err = sbl_base_link_start_gated_phase(sbl, port_num, phase, false, ring_gate);
+		while (err == -EINPROGRESS) {
+			sbl_start_wait_sleep(sbl, port_num);
+			err = sbl_base_link_start_gated_phase(sbl, port_num, phase, true, ring_gate);
+		}
+		if (err) {
+			sbl_base_link_start_fail(sbl, port_num, phase, err);
+			mutex_unlock(&link->busy_mtx);
+			return err;
+		}
+	}
+
+	sbl_base_link_start_done(sbl, port_num);
+	mutex_unlock(&link->busy_mtx);
+
+	return 0;
+}
+
+/**
+ * sbl_base_link_start() - Initialize and bring up links
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * This function performs full sequence to bring up serdes link.
+ * It handles firmware validation, link mode detection, alignment,
+ * SerDes startup and link integrity checks. This process ensures
+ * link partner is detected and all lanes are properly initialized
+ * and active before reporting the link is up
+ *
+ * Context: Process, May sleep. Uses mutex_lock_interruptible
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_base_link_start(struct sbl_inst *sbl, int port_num)
+{
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	sbl_dev_dbg(sbl->dev, "bl %d: start\n", port_num);
+
+	return sbl_base_link_start_gated(sbl, port_num, NULL);
+}
 EXPORT_SYMBOL(sbl_base_link_start);
 
+/*
+ * Non-blocking start
+ *
+ * The start sequence is run one phase per work item invocation, and a
+ * phase which has to wait returns instead of sleeping and is resumed by
+ * requeueing the work with the wait as its delay. The busy mutex is
+ * dropped between invocations so no thread is held for the whole start,
+ * or for any of its waits; the link stays in the starting state so
+ * nothing else can start or stop it in the meantime.
+ */
+void sbl_base_link_start_async_work(struct work_struct *work)
+{
+	struct sbl_start_async *start_async =
+		container_of(to_delayed_work(work), struct sbl_start_async, work);
+	struct sbl_inst *sbl = start_async->sbl;
+	int port_num = start_async->port_num;
+	struct sbl_link *link = sbl->link + port_num;
+	int err;
+
+	mutex_lock(&link->busy_mtx);
+
+	/* cancelled - whoever cleared in_flight reports it */
+	if (!start_async->in_flight) {
+		mutex_unlock(&link->busy_mtx);
+		return;
+	}
+
+	/* a waiting phase checks for cancel itself so it can clean up */
+	if (!start_async->resume && sbl_base_link_start_cancelled(sbl, port_num))
+		err = -ECANCELED;
+	else
+		err = sbl_base_link_start_phase(sbl, port_num, start_async->phase,
+				start_async->resume);
+	if (err == -EINPROGRESS) {
+		start_async->resume = true;
+		queue_delayed_work(sbl->workq, &start_async->work,
+				msecs_to_jiffies(link->start_wait_ms));
+		mutex_unlock(&link->busy_mtx);
+		return;
+	}
+	start_async->resume = false;
+	if (err) {
+		sbl_base_link_start_fail(sbl, port_num, start_async->phase, err);
+		goto out;
+	}
+
+	if (++start_async->phase < SBL_START_PHASE_NUM) {
+		mutex_unlock(&link->busy_mtx);
+		queue_delayed_work(sbl->workq, &start_async->work, 0);
+		return;
+	}
+
+	sbl_base_link_start_done(sbl, port_num);
+
+out:
+	start_async->in_flight = false;
+	mutex_unlock(&link->busy_mtx);
+
+	sbl_dev_dbg(sbl->dev, "bl %d: start async done [%d]\n", port_num, err);
+	sbl_link_start_complete(sbl, port_num, err);
+}
+
+/**
+ * sbl_base_link_start_async() - Start a link without blocking
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Runs the same sequence as sbl_base_link_start() from a delayed work
+ * item on the instance workqueue, one phase at a time, without holding
+ * a worker while any phase waits. When the start
+ * finishes the sbl_link_start_complete() op (if provided) is called with
+ * the result; the link state can also be polled with
+ * sbl_base_link_get_status().
+ *
+ * Context: Process, May sleep. Uses mutex_lock_interruptible
+ *
+ * Return: 0 if the start was queued, -EALREADY if the link is already up,
+ *         negative error code on failure
+ */
+int sbl_base_link_start_async(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	sbl_dev_dbg(sbl->dev, "bl %d: start async\n", port_num);
+
+	link = sbl->link + port_num;
+
+	err = mutex_lock_interruptible(&link->busy_mtx);
+	if (err)
+		return -ERESTARTSYS;
+
+	err = sbl_base_link_start_check(sbl, port_num);
+	if (err) {
+		mutex_unlock(&link->busy_mtx);
+		return err;
+	}
+
+	sbl_base_link_start_init(sbl, port_num);
+
+	link->start_async.phase = 0;
+	link->start_async.resume = false;
+	link->start_async.in_flight = true;
+	queue_delayed_work(sbl->workq, &link->start_async.work, 0);
+
+	mutex_unlock(&link->busy_mtx);
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_base_link_start_async);
+
+/*
+ * stop a non-blocking start and report it as cancelled
+ *
+ * in_flight is tested and cleared under the busy mutex both here and
+ * when the work completes the start, so exactly one of them reports the
+ * result. Once it is cleared the work will not run another phase, so
+ * the sync cancel only has to wait out a phase already running.
+ */
+void sbl_base_link_start_async_cancel(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	bool in_flight;
+
+	mutex_lock(&link->busy_mtx);
+	in_flight = link->start_async.in_flight;
+	link->start_async.in_flight = false;
+	mutex_unlock(&link->busy_mtx);
+
+	cancel_delayed_work_sync(&link->start_async.work);
+
+	if (in_flight) {
+		sbl_dev_dbg(sbl->dev, "bl %d: start async cancelled\n", port_num);
+		sbl_link_start_complete(sbl, port_num, -ECANCELED);
+	}
+}
+
+/* one link start run on the instance workqueue */
+struct sbl_base_link_start_work {
+	struct sbl_inst *sbl;
+	int port_num;
+	struct mutex *ring_gate;
+	int err;
+	struct work_struct work;
+};
+
+static void sbl_base_link_start_worker(struct work_struct *work)
+{
+	struct sbl_base_link_start_work *start_work =
+		container_of(work, struct sbl_base_link_start_work, work);
+
+	sbl_dev_dbg(start_work->sbl->dev, "bl %d: start\n", start_work->port_num);
+
+	start_work->err = sbl_base_link_start_gated(start_work->sbl,
+			start_work->port_num, start_work->ring_gate);
+}
+
+/**
+ * sbl_base_link_start_many() - Bring up a set of links concurrently
+ * @sbl: A slingshot base link device instance
+ * @port_mask: bit mask of the ports to start
+ * @results: optional array (one entry per port) for per port results
+ *
+ * Each selected port is started as by sbl_base_link_start() from its own
+ * work item on the instance workqueue, so the time to bring up the whole
+ * set is that of the slowest link rather than the sum of all of them.
+ *
+ * The sbus bound phases (firmware check and serdes start) are gated per
+ * sbus ring: only one port of the set runs a step of them on a ring at a
+ * time, and the gate is dropped while the step waits, so ports on the
+ * same ring interleave their sbus work with each other's waits while
+ * ports on other rings run alongside. Starts from outside the set are
+ * not gated.
+ *
+ * Entries of @results for ports not in @port_mask are left untouched.
+ *
+ * Context: Process, May sleep. Waits for all the starts to complete
+ *
+ * Return: 0 if all links started, otherwise the error of the lowest
+ *         numbered port that failed
+ */
+int sbl_base_link_start_many(struct sbl_inst *sbl, u64 port_mask, int *results)
+{
+	struct sbl_base_link_start_work *start_work;
+	struct mutex *ring_gate;
+	int num_rings;
+	int num_ports;
+	int sbus_ring;
+	int err;
+	int i;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	num_ports = sbl->switch_info->num_ports;
+	if (num_ports < 64)
+		port_mask &= BIT_ULL(num_ports) - 1;
+	if (!port_mask)
+		return -EINVAL;
+
+	sbl_dev_dbg(sbl->dev, "bl: start many 0x%llx\n", port_mask);
+
+	start_work = kcalloc(num_ports, sizeof(*start_work), GFP_KERNEL);
+	if (!start_work)
+		return -ENOMEM;
+
+	num_rings = sbl->switch_info->num_sbus_rings;
+	ring_gate = kcalloc(num_rings, sizeof(*ring_gate), GFP_KERNEL);
+	if (!ring_gate) {
+		kfree(start_work);
+		return -ENOMEM;
+	}
+	for (sbus_ring = 0; sbus_ring < num_rings; ++sbus_ring)
+		mutex_init(&ring_gate[sbus_ring]);
+
+	for (i = 0; i < num_ports; ++i) {
+		if (!(port_mask & BIT_ULL(i)))
+			continue;
+
+		start_work[i].sbl = sbl;
+		start_work[i].port_num = i;
+		start_work[i].ring_gate =
+			&ring_gate[sbl->switch_info->ports[i].serdes[0].sbus_ring];
+		INIT_WORK(&start_work[i].work, sbl_base_link_start_worker);
+		queue_work(sbl->workq, &start_work[i].work);
+	}
+
+	/* collect the results */
+	for (i = 0; i < num_ports; ++i) {
+		if (!(port_mask & BIT_ULL(i)))
+			continue;
+
+		flush_work(&start_work[i].work);
+
+		if (results)
+			results[i] = start_work[i].err;
+
+		if (start_work[i].err) {
+			sbl_dev_dbg(sbl->dev, "bl %d: start many failed [%d]\n",
+					i, start_work[i].err);
+			if (!err)
+				err = start_work[i].err;
+		}
+	}
+
+	for (sbus_ring = 0; sbus_ring < num_rings; ++sbus_ring)
+		mutex_destroy(&ring_gate[sbus_ring]);
+	kfree(ring_gate);
+	kfree(start_work);
+
+	return err;
+}
+EXPORT_SYMBOL(sbl_base_link_start_many);
+
 /**
  * sbl_ignore_save_tuning_param() - Config ignore save tuning parameters
  * @sbl: A slingshot base link device instance
@@ -659,6 +1068,73 @@ void sbl_disable_pml_recovery(struct sbl_inst *sbl, int port_num, bool disable)
 }
 EXPORT_SYMBOL(sbl_disable_pml_recovery);
 
+/**
+ * sbl_enable_opt_fw_crc_cache() - Enable the serdes fw crc cache
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @enable: if set then trust recent good fw crc checks at start
+ *
+ * When enabled, link start skips the serdes fw crc check for lanes
+ * which passed a check (at start or by the background scrubber)
+ * recently and have not had their firmware reloaded since.
+ */
+void sbl_enable_opt_fw_crc_cache(struct sbl_inst *sbl, int port_num, bool enable)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	if (enable)
+		link->blattr.options |= SBL_OPT_FW_CRC_CACHE;
+	else {
+		link->blattr.options &= ~SBL_OPT_FW_CRC_CACHE;
+		sbl_serdes_fw_crc_invalidate(sbl, port_num);
+	}
+}
+EXPORT_SYMBOL(sbl_enable_opt_fw_crc_cache);
+
+/**
+ * sbl_enable_opt_dfe_adaptive_effort() - Enable adaptive dfe tune effort
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @enable: if set then choose the tune effort from past tunes
+ *
+ * When enabled, each dfe tune uses the ICAL effort with the smallest
+ * expected time to a good tune on this port and media, instead of the
+ * fixed medium then max effort ladder. The SBL_OPT_DFE_ALWAYS_* options
+ * still take precedence.
+ */
+void sbl_enable_opt_dfe_adaptive_effort(struct sbl_inst *sbl, int port_num, bool enable)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	if (enable)
+		link->blattr.options |= SBL_OPT_DFE_ADAPTIVE_EFFORT;
+	else
+		link->blattr.options &= ~SBL_OPT_DFE_ADAPTIVE_EFFORT;
+}
+EXPORT_SYMBOL(sbl_enable_opt_dfe_adaptive_effort);
+
+/**
+ * sbl_enable_opt_dfe_peer_seed() - Enable seeding tuning from peer ports
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @enable: if set then start a cold tune from a peer port's params
+ *
+ * When enabled, a port with no saved params for its configuration applies
+ * the params of a port which is up with the same tp state hashes and then
+ * does a min effort tune, rather than a full tune from scratch. Only used
+ * where saved params would be.
+ */
+void sbl_enable_opt_dfe_peer_seed(struct sbl_inst *sbl, int port_num, bool enable)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	if (enable)
+		link->blattr.options |= SBL_OPT_DFE_PEER_SEED;
+	else
+		link->blattr.options &= ~SBL_OPT_DFE_PEER_SEED;
+}
+EXPORT_SYMBOL(sbl_enable_opt_dfe_peer_seed);
+
 /**
  * sbl_set_degraded_flag() - Set degraded flag
  * @sbl: A slingshot base link device instance
@@ -912,6 +1388,9 @@ int sbl_base_link_reset(struct sbl_inst *sbl, int port_num)
 	link = sbl->link + port_num;
 	fec_data = link->fec_data;
 
+	/* stop any non-blocking start in progress */
+	sbl_base_link_start_async_cancel(sbl, port_num);
+
 	err = mutex_lock_interruptible(&link->busy_mtx);
 	if (err)
 		return -ERESTARTSYS;
@@ -1679,6 +2158,12 @@ int sbl_base_link_dump_attr(struct sbl_inst *sbl, int port_num, char *buf, size_
 			s += snprintf(buf+s, size-s, " enable-lane-degrade");
 		if (attr->options & SBL_DISABLE_PML_RECOVERY)
 			s += snprintf(buf+s, size-s, " disable-pml-recovery");
+		if (attr->options & SBL_OPT_FW_CRC_CACHE)
+			s += snprintf(buf+s, size-s, " fw-crc-cache");
+		if (attr->options & SBL_OPT_DFE_ADAPTIVE_EFFORT)
+			s += snprintf(buf+s, size-s, " adaptive-effort");
+		if (attr->options & SBL_OPT_DFE_PEER_SEED)
+			s += snprintf(buf+s, size-s, " peer-seed");
 	}
 	s += snprintf(buf+s, size-s, "\n");
 	s += snprintf(buf+s, size-s, "start_timeout %d\n", attr->start_timeout);
@@ -8,7 +8,16 @@
 
 
 /* link mode auto negotiation */
-int sbl_link_autoneg(struct sbl_inst *sbl, int port_num);
+int sbl_link_autoneg(struct sbl_inst *sbl, int port_num, bool resume);
+
+/* autoneg start waits, resumed rather than slept in */
+enum sbl_an_wait_state {
+	SBL_AN_WAIT_BASE_PAGE,
+	SBL_AN_WAIT_RETRY,
+};
+
+/* base page completion poll period (ms) */
+#define SBL_AN_BASE_PAGE_POLL    5
 
 /* state info flags for trace/debug */
 enum sbl_link_info_flags {
@@ -303,13 +303,10 @@ static int sbl_an_pml_setup(struct sbl_inst *sbl, int port_num)
  *    26 Feb 2021 - added SM exchange to work around rosetta interrupt bug
  *
  */
-static int sbl_an_exchange(struct sbl_inst *sbl, int port_num)
+static int sbl_an_exchange_begin(struct sbl_inst *sbl, int port_num)
 {
 	struct sbl_link *link = sbl->link + port_num;
-	u32 base = SBL_PML_BASE(port_num);
 	unsigned long timeout = msecs_to_jiffies(1000*link->blattr.pec.an_retry_timeout);
-	unsigned long remaining_jiffies;
-	u64 sts_autoneg_base_reg;
 	int err;
 
 	sbl_dev_dbg(sbl->dev, "an %d: exchange start", port_num);
@@ -338,9 +335,36 @@ static int sbl_an_exchange(struct sbl_inst *sbl, int port_num)
 		return err;
 
 	sbl_an_send_base_page(sbl, port_num);
+	link->an_last_jiffy = jiffies + timeout;
+
+	return 0;
+}
+
+/*
+ * wait for the base page
+ *
+ *   The completion is polled so the wait can be resumed rather than slept
+ *   in. Returns -EINPROGRESS while the base page is still awaited.
+ */
+static int sbl_an_exchange_wait(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	u32 base = SBL_PML_BASE(port_num);
+	unsigned long remaining_jiffies;
+	u64 sts_autoneg_base_reg;
+	int err;
+
+	if (!sbl->is_hw)
+		return 0;
+
+	if (!try_wait_for_completion(&link->an_hw_change)) {
+
+		if (sbl_base_link_start_cancelled(sbl, port_num))
+			return -ECANCELED;
+
+		if (time_before(jiffies, link->an_last_jiffy))
+			return sbl_start_wait(sbl, port_num, SBL_AN_BASE_PAGE_POLL);
 
-	remaining_jiffies = wait_for_completion_timeout(&link->an_hw_change, timeout);
-	if (remaining_jiffies == 0) {
 		sbl_dev_dbg(sbl->dev, "an %d: base page exchange timeout (nonce %.2x, sm_state %s)",
 			port_num, link->an_nonce, sbl_an_get_sm_state(sbl, port_num));
 		sbl_an_dump_state(sbl, port_num);
@@ -352,6 +376,12 @@ static int sbl_an_exchange(struct sbl_inst *sbl, int port_num)
 		return -ETIME;
 	}
 
+	/* what is left of the timeout carries over to the next pages */
+	if (time_before(jiffies, link->an_last_jiffy))
+		remaining_jiffies = link->an_last_jiffy - jiffies;
+	else
+		remaining_jiffies = 1;
+
 	/* check it is a base page */
 	if (!sbl_an_is_base_page(sbl, port_num)) {
 		sbl_dev_err(sbl->dev, "an %d: missing base page indication", port_num);
@@ -617,7 +647,7 @@ static bool sbl_an_100cr4_fixup(struct sbl_inst *sbl, int port_num)
 	return true;
 }
 
-int sbl_link_autoneg(struct sbl_inst *sbl, int port_num)
+int sbl_link_autoneg(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link;
 	u32 base = SBL_PML_BASE(port_num);
@@ -625,6 +655,12 @@ int sbl_link_autoneg(struct sbl_inst *sbl, int port_num)
 	u64 cfg_pcs_reg;
 	int err;
 
+	if (resume) {
+		/* carry on from where we were waiting */
+		link = sbl->link + port_num;
+		goto negotiate;
+	}
+
 	err = sbl_validate_instance(sbl);
 	if (err)
 		return err;
@@ -690,8 +726,15 @@ int sbl_link_autoneg(struct sbl_inst *sbl, int port_num)
 
 	/* try to negotiate */
 	link->an_try_count = 0;
+negotiate:
 	while (1) {
 
+		if (resume && (link->an_wait_state == SBL_AN_WAIT_BASE_PAGE)) {
+			/* carry on waiting for the base page */
+			err = sbl_an_exchange_wait(sbl, port_num);
+			goto exchanged;
+		}
+
 		link->an_try_count++;
 
 		/* keep trying until up timeout expires or cancelled */
@@ -715,7 +758,15 @@ int sbl_link_autoneg(struct sbl_inst *sbl, int port_num)
 			break;
 
 		/* try to exchange pages */
-		err = sbl_an_exchange(sbl, port_num);
+		link->an_wait_state = SBL_AN_WAIT_BASE_PAGE;
+		err = sbl_an_exchange_begin(sbl, port_num);
+		if (!err)
+			err = sbl_an_exchange_wait(sbl, port_num);
+exchanged:
+		if (err == -EINPROGRESS)
+			return err;
+		resume = false;
+
 		if (err == -EPROTO) {
 			/* we have received an unexpected base page
 			 * The lp must have restarted autoneg and we should too
@@ -743,8 +794,8 @@ int sbl_link_autoneg(struct sbl_inst *sbl, int port_num)
 				/* Random delay of 1-5 before retry */
 				get_random_bytes(&random, sizeof(random));
 				random = 1u + (random % 5u);
-				msleep(random);
-				continue;
+				link->an_wait_state = SBL_AN_WAIT_RETRY;
+				return sbl_start_wait(sbl, port_num, random);
 			} else {
 				/* give up */
 				break;
@@ -447,6 +447,32 @@ const char *sbl_down_origin_str(enum sbl_link_down_origin down_origin)
 }
 EXPORT_SYMBOL(sbl_down_origin_str);
 
+/**
+ * sbl_link_phase_str() - Get link bring-up phase as string
+ * @phase: Value used to find the phase
+ *
+ * Return: Link bring-up phase as string
+ */
+const char *sbl_link_phase_str(int phase)
+{
+	switch (phase) {
+	case SBL_START_PHASE_FW_CHECK:             return "fw_check";
+	case SBL_START_PHASE_GET_MODE:             return "get_mode";
+	case SBL_START_PHASE_AM_START:             return "am_start";
+	case SBL_START_PHASE_LPD:                  return "lpd";
+	case SBL_START_PHASE_SERDES_START:         return "serdes_start";
+	case SBL_START_PHASE_PML_START:            return "pml_start";
+	case SBL_START_PHASE_FEC_SETUP:            return "fec_setup";
+	case SBL_START_PHASE_FEC_UP_CHECK:         return "fec_up_check";
+	case SBL_START_PHASE_FAULT_MON:            return "fault_mon";
+	case SBL_START_PHASE_LINK_CHECK:           return "link_check";
+	case SBL_LINK_PHASE_PML_PCS_WAIT:          return "pml_pcs_wait";
+	case SBL_LINK_PHASE_PML_LLR_START:         return "pml_llr_start";
+	default:                                   return "unrecognized";
+	}
+}
+EXPORT_SYMBOL(sbl_link_phase_str);
+
 /**
  * sbl_flags_get_poll_interval_from_flags() - Get interval for sbus operations
  * @flags: Value
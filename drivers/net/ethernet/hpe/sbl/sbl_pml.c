@@ -22,51 +22,62 @@
 #include "sbl_internal.h"
 #include "sbl_serdes_fn.h"
 
-/* Bring-up PML block of a link */
-int sbl_pml_start(struct sbl_inst *sbl, int port_num)
+/* Bring-up PML block of a link
+ *
+ * The pcs and llr waits return -EINPROGRESS rather than sleeping, and
+ * the bring-up carries on from the wait when called with resume set.
+ */
+int sbl_pml_start(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_pml_wait *pml_wait = &link->pml_wait;
 	int err;
 
-	sbl_dev_dbg(sbl->dev, "%d: pml bring-up starting", port_num);
+	if (!resume) {
+		sbl_dev_dbg(sbl->dev, "%d: pml bring-up starting", port_num);
 
-	/* serdes must be up */
-	if (link->sstate != SBL_SERDES_STATUS_RUNNING) {
-		sbl_dev_err(sbl->dev, "%d: pml serdes not running", port_num);
-		err = -ENOLINK;
-		goto out_err;
-	}
+		/* serdes must be up */
+		if (link->sstate != SBL_SERDES_STATUS_RUNNING) {
+			sbl_dev_err(sbl->dev, "%d: pml serdes not running", port_num);
+			err = -ENOLINK;
+			goto out_err;
+		}
 
-	/* pcs must be sending am so link partner can tune */
-	if (!(link->link_info & SBL_LINK_INFO_PCS_TX_AM)) {
-		sbl_dev_err(sbl->dev, "%d: pml pcs not tx am", port_num);
-		err = -ENODATA;
-		goto out_err;
-	}
+		/* pcs must be sending am so link partner can tune */
+		if (!(link->link_info & SBL_LINK_INFO_PCS_TX_AM)) {
+			sbl_dev_err(sbl->dev, "%d: pml pcs not tx am", port_num);
+			err = -ENODATA;
+			goto out_err;
+		}
 
-	/* make sure we have time left */
-	 sbl_start_timeout_ensure_remaining(sbl, port_num,
-			 SBL_PML_MIN_START_TIME);
+		/* make sure we have time left */
+		sbl_start_timeout_ensure_remaining(sbl, port_num,
+				SBL_PML_MIN_START_TIME);
 
-	/* make sure am locking is enabled */
-	if (!(link->link_info & SBL_LINK_INFO_PCS_ALIGN_EN))
-		sbl_pml_pcs_enable_alignment(sbl, port_num);
+		/* make sure am locking is enabled */
+		if (!(link->link_info & SBL_LINK_INFO_PCS_ALIGN_EN))
+			sbl_pml_pcs_enable_alignment(sbl, port_num);
 
-	err = sbl_pml_mac_config(sbl, port_num);
-	if (err) {
-		sbl_dev_err(sbl->dev, "%d: pml mac config failed [%d]", port_num, err);
-		goto out_err;
-	}
+		err = sbl_pml_mac_config(sbl, port_num);
+		if (err) {
+			sbl_dev_err(sbl->dev, "%d: pml mac config failed [%d]", port_num, err);
+			goto out_err;
+		}
 
-	sbl_pml_llr_config(sbl, port_num);
+		sbl_pml_llr_config(sbl, port_num);
+
+		pml_wait->state = SBL_PML_WAIT_PCS_LOCK;
+		pml_wait->begin = ktime_get();
+	}
 
-	/* keep trying to get the PML block up until
-	 * we succeed, timeout or have a fatal error
-	 */
-	while (true) {
+	if (pml_wait->state != SBL_PML_WAIT_LLR_READY) {
 
 		/* wait for the pcs to come up  */
-		err = sbl_pml_pcs_wait(sbl, port_num);
+		err = sbl_pml_pcs_wait(sbl, port_num, resume);
+		if (err == -EINPROGRESS)
+			return err;
+		sbl_link_phase_record(sbl, port_num, SBL_LINK_PHASE_PML_PCS_WAIT,
+				pml_wait->begin, err);
 		switch (err) {
 		case 0:
 			/* good - carry on with mac */
@@ -87,25 +98,32 @@ int sbl_pml_start(struct sbl_inst *sbl, int port_num)
 		/* start mac */
 		sbl_pml_mac_start(sbl, port_num);
 
-		/* start llr */
-		err = sbl_pml_llr_start(sbl, port_num);
-		switch (err) {
-		case 0:
-			/* all good */
-			goto out_done;
-		case -ECANCELED:
-			sbl_dev_dbg(sbl->dev, "%d: pml llr start cancelled", port_num);
-			goto out_err;
-		case -ETIMEDOUT:
-			sbl_dev_dbg(sbl->dev, "%d: pml llr start timeout", port_num);
-			goto out_err;
-		default:
-			sbl_dev_dbg(sbl->dev, "%d: pml llr start failed [%d]", port_num, err);
-			goto out_err;
-		}
-	};
+		/* llr start from the beginning */
+		pml_wait->begin = ktime_get();
+		resume = false;
+	}
+
+	/* start llr */
+	err = sbl_pml_llr_start(sbl, port_num, resume);
+	if (err == -EINPROGRESS)
+		return err;
+	sbl_link_phase_record(sbl, port_num, SBL_LINK_PHASE_PML_LLR_START,
+			pml_wait->begin, err);
+	switch (err) {
+	case 0:
+		/* all good */
+		break;
+	case -ECANCELED:
+		sbl_dev_dbg(sbl->dev, "%d: pml llr start cancelled", port_num);
+		goto out_err;
+	case -ETIMEDOUT:
+		sbl_dev_dbg(sbl->dev, "%d: pml llr start timeout", port_num);
+		goto out_err;
+	default:
+		sbl_dev_dbg(sbl->dev, "%d: pml llr start failed [%d]", port_num, err);
+		goto out_err;
+	}
 
-out_done:
 	/* clear any PML errors which might have been set during startup */
 	sbl_pml_err_flgs_clear_all(sbl, port_num);
 
@@ -9,8 +9,26 @@
 #define SBL_PML_MIN_START_TIME                2 /* s */
 
 /* pcs alignment */
+#define SBL_PML_PCS_LOCK_TIMEOUT           1000 /* ms */
 #define SBL_PML_PCS_ALIGN_TIMEOUT          1000 /* ms */
-#define SBL_PML_PCS_ALIGN_SLOW_POLL_DELAY  1000 /* ms */
+
+/* pcs lock/alignment polling and restart adaption
+ * poll fast until well past the usual lock/align time for the port then
+ * back off, and restart locking at a multiple of the usual time
+ */
+#define SBL_PML_PCS_FAST_POLL_PERIOD          1 /* ms */
+#define SBL_PML_PCS_FAST_POLL_TIME           50 /* ms */
+#define SBL_PML_PCS_SLOW_POLL_PERIOD        100 /* ms */
+#define SBL_PML_PCS_RESTART_MIN             100 /* ms */
+#define SBL_PML_PCS_RESTART_FACTOR            4
+
+/* pml start waits, resumed rather than slept in */
+enum sbl_pml_wait_state {
+	SBL_PML_WAIT_PCS_LOCK,
+	SBL_PML_WAIT_PCS_ALIGN,
+	SBL_PML_WAIT_PCS_FAULT,
+	SBL_PML_WAIT_LLR_READY,
+};
 
 /* number of times we see no fault to decide pcs is up */
 #define SBL_PML_REQUIRED_NO_FAULT_COUNT       2
@@ -30,6 +48,14 @@
 #define SBL_PML_LLR_TIMING_PERIOD        2000ULL /* ns for 200m */
 #define SBL_PML_LLR_TIMING_RETRY_DELAY       200
 
+/* delay after llr start before re-measuring a cached loop time (ms) */
+#define SBL_PML_LLR_REMEASURE_DELAY     1000
+/* change in the re-measured loop time worth reprogramming llr for (percent) */
+#define SBL_PML_LLR_REMEASURE_TOLERANCE    5
+
+/* LLR ready poll period */
+#define SBL_PML_LLR_READY_POLL        5 /* ms */
+
 /* LLR detect timing */
 #define SBL_PML_LLR_DETECT_DELAY    100 /* ms */
 #define SBL_PML_LLR_DETECT_TIMEOUT 1000 /* ms */
@@ -70,7 +96,7 @@
 					 SBL_PML_ERR_FLG_PCS_RX_DEGRADE_FAILURE_SET(1ULL))
 
 /* general PML */
-int  sbl_pml_start(struct sbl_inst *sbl, int port_num);
+int  sbl_pml_start(struct sbl_inst *sbl, int port_num, bool resume);
 int  sbl_pml_link_down(struct sbl_inst *sbl, int port_num);
 void sbl_pml_set_defaults(struct sbl_inst *sbl, int port_num);
 bool sbl_pml_err_flgs_test(struct sbl_inst *sbl, int port_num, u64 err_flgs);
@@ -90,7 +116,7 @@ bool  sbl_pml_pcs_high_serdes_error(struct sbl_inst *sbl, int port_num);
 bool  sbl_pml_pcs_up(struct sbl_inst *sbl, int port_num);
 void  sbl_pml_pcs_enable_alignment(struct sbl_inst *sbl, int port_num);
 void  sbl_pml_pcs_disable_alignment(struct sbl_inst *sbl, int port_num);
-int   sbl_pml_pcs_wait(struct sbl_inst *sbl, int port_num);
+int   sbl_pml_pcs_wait(struct sbl_inst *sbl, int port_num, bool resume);
 void  sbl_pml_pcs_start(struct sbl_inst *sbl, int port_num);
 void  sbl_pml_pcs_stop(struct sbl_inst *sbl, int port_num);
 void  sbl_pml_pcs_ordered_sets(struct sbl_inst *sbl, int port_num, int enable);
@@ -111,7 +137,8 @@ void sbl_pml_mac_hpc_set(struct sbl_inst *sbl, int port_num);
 
 /* LLR */
 void sbl_pml_llr_config(struct sbl_inst *sbl, int port_num);
-int  sbl_pml_llr_start(struct sbl_inst *sbl, int port_num);
+int  sbl_pml_llr_start(struct sbl_inst *sbl, int port_num, bool resume);
+void sbl_pml_llr_remeasure_work(struct work_struct *work);
 u64  sbl_pml_llr_link_down_behaviour(struct sbl_inst *sbl, int port_num);
 
 /* TODO: update the values below to reflect changes in the draft
@@ -8,6 +8,7 @@
 #include <linux/device.h>
 #include <linux/delay.h>
 #include <linux/sched.h>
+#include <linux/workqueue.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_an.h>
@@ -20,33 +21,33 @@
 #include "sbl_internal.h"
 
 
+/* wait for llr to reach the advance state
+ *
+ * returns -EINPROGRESS until the next poll is due
+ */
 static int sbl_pml_llr_ready_wait(struct sbl_inst *sbl, int port_num)
 {
-	int err = -1;
-
-	sbl_dev_dbg(sbl->dev, "%d: LLR ready wait", port_num);
+	int err;
 
-	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_LLR_WAIT);
-
-	while (sbl_pml_llr_get_state(sbl, port_num) != SBL_PML_LLR_STATE_ADVANCE) {
-
-		if (sbl_start_timeout(sbl, port_num)) {
-			sbl_dev_err(sbl->dev, "%d: LLR ready wait timeout", port_num);
-			err = -ETIMEDOUT;
-			goto out;
-		}
+	if (sbl_pml_llr_get_state(sbl, port_num) == SBL_PML_LLR_STATE_ADVANCE) {
+		err = 0;
+		goto out;
+	}
 
-		if (sbl_base_link_start_cancelled(sbl, port_num)) {
-			sbl_dev_err(sbl->dev, "%d: LLR ready wait cancelled", port_num);
-			err = -ECANCELED;
-			goto out;
-		}
+	if (sbl_start_timeout(sbl, port_num)) {
+		sbl_dev_err(sbl->dev, "%d: LLR ready wait timeout", port_num);
+		err = -ETIMEDOUT;
+		goto out;
+	}
 
-		/* should be relatively well synchronised by this point */
-		usleep_range(5000, 6000);
+	if (sbl_base_link_start_cancelled(sbl, port_num)) {
+		sbl_dev_err(sbl->dev, "%d: LLR ready wait cancelled", port_num);
+		err = -ECANCELED;
+		goto out;
 	}
 
-	err = 0;
+	/* should be relatively well synchronised by this point */
+	return sbl_start_wait(sbl, port_num, SBL_PML_LLR_READY_POLL);
 
 out:
 	sbl_link_info_clear(sbl, port_num, SBL_LINK_INFO_LLR_WAIT);
@@ -56,9 +57,13 @@ out:
 /* calculate the loop time
  *
  * try to make a number of measurements or timeout/cancelled
+ *
+ * when re-measuring on a running link (!starting) there is no start to
+ * time out or cancel, and a failed measurement is just reported rather
+ * than falling back to the calculated max
  */
 static int sbl_pml_llr_measure_loop_time_ns(struct sbl_inst *sbl, int port_num,
-		u64 *llr_loop_time)
+		bool starting, u64 *llr_loop_time)
 {
 	struct sbl_link *link;
 	u32              base;
@@ -98,13 +103,13 @@ static int sbl_pml_llr_measure_loop_time_ns(struct sbl_inst *sbl, int port_num,
 	/* measure loop time */
 	for (x = 0; x < SBL_PML_LLR_TIMING_LOOPS; ++x) {
 
-		if (sbl_start_timeout(sbl, port_num)) {
+		if (starting && sbl_start_timeout(sbl, port_num)) {
 			sbl_dev_err(sbl->dev, "%d: LLR measure loop time timeout", port_num);
 			err = -ETIMEDOUT;
 			goto out;
 		}
 
-		if (sbl_base_link_start_cancelled(sbl, port_num)) {
+		if (starting && sbl_base_link_start_cancelled(sbl, port_num)) {
 			sbl_dev_err(sbl->dev, "%d: LLR measure loop time cancelled", port_num);
 			err = -ECANCELED;
 			goto out;
@@ -135,6 +140,12 @@ static int sbl_pml_llr_measure_loop_time_ns(struct sbl_inst *sbl, int port_num,
 
 	/* check result here */
 	if (*llr_loop_time == SBL_PML_LLR_MAX_LOOP_TIME) {
+		if (!starting) {
+			sbl_dev_dbg(sbl->dev, "%d: LLR re-measure loop time failed (last = %lld)",
+				port_num, time64);
+			err = -ENODATA;
+			goto out;
+		}
 		if (sbl_debug_option(sbl, port_num, SBL_DEBUG_ALLOW_LOOP_TIME_FAIL)) {
 			sbl_dev_err(sbl->dev, "%d: LLR measure loop time failed (min = %lld, max = %lld, last = %lld)",
 				port_num, min_loop_time, max_loop_time, time64);
@@ -211,6 +222,66 @@ static void sbl_pml_llr_calculate_capacity(struct sbl_inst *sbl, int port_num,
 		port_num, *max_data, *max_seq);
 }
 
+/* program the llr settings that are sized from the loop time */
+static void sbl_pml_llr_loop_time_config(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	u32 base = SBL_PML_BASE(port_num);
+	u64 llr_max_data;
+	u64 llr_max_seq;
+	u64 val64;
+
+	/* set max replay time from loop-back time */
+	val64 = sbl_read64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET);
+	if (link->blattr.options & SBL_DISABLE_PML_RECOVERY)
+		val64 = SBL_PML_CFG_LLR_SM_REPLAY_CT_MAX_UPDATE(val64, SBL_DFLT_REPLAY_CT_MAX);
+	else
+		val64 = SBL_PML_CFG_LLR_SM_REPLAY_CT_MAX_UPDATE(val64, SBL_LLR_REPLAY_CT_MAX_UNLIMITED);
+	val64 = SBL_PML_CFG_LLR_SM_REPLAY_TIMER_MAX_UPDATE(val64,
+			3 * link->llr_loop_time + 500);
+	sbl_write64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET, val64);
+	sbl_read64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET);  /* flush */
+
+	/* capacity configuration */
+	if (link->blattr.options & SBL_OPT_FABRIC_LINK) {
+		/* these can be set to their defaults for fabric links */
+		sbl_write64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET,
+				SBL_PML_CFG_LLR_CAPACITY_DFLT);
+		sbl_read64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET);  /* flush */
+	} else {
+		sbl_pml_llr_calculate_capacity(sbl, port_num, &llr_max_data, &llr_max_seq);
+		val64 = SBL_PML_CFG_LLR_CAPACITY_MAX_DATA_SET(llr_max_data) |
+			SBL_PML_CFG_LLR_CAPACITY_MAX_SEQ_SET(llr_max_seq);
+		sbl_write64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET, val64);
+		sbl_read64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET);  /* flush */
+	}
+}
+
+/*
+ * llr loop time cache
+ *
+ * The last measured loop time is kept together with the media attributes
+ * and loopback mode it was measured with. A start with the same media and
+ * loopback mode brings llr up straight away from the cached time and then
+ * re-measures it in the background once the link is up.
+ */
+static bool sbl_pml_llr_loop_time_cache_match(struct sbl_link *link)
+{
+	return link->llr_loop_time_cached &&
+		(link->llr_loop_loopback_mode == link->loopback_mode) &&
+		(link->llr_loop_mattr.media  == link->mattr.media) &&
+		(link->llr_loop_mattr.len    == link->mattr.len) &&
+		(link->llr_loop_mattr.info   == link->mattr.info) &&
+		(link->llr_loop_mattr.vendor == link->mattr.vendor);
+}
+
+static void sbl_pml_llr_loop_time_cache_set(struct sbl_link *link, u64 llr_loop_time)
+{
+	link->llr_loop_time_cached = llr_loop_time;
+	link->llr_loop_mattr = link->mattr;
+	link->llr_loop_loopback_mode = link->loopback_mode;
+}
+
 /* enable llr timing measurements */
 static void sbl_pml_llr_enable_loop_timing(struct sbl_inst *sbl, int port_num)
 {
@@ -459,18 +530,25 @@ void sbl_pml_llr_config(struct sbl_inst *sbl, int port_num)
 }
 
 
-/* start */
-int sbl_pml_llr_start(struct sbl_inst *sbl, int port_num)
+/* start
+ *
+ * returns -EINPROGRESS while waiting for llr to be ready, call again
+ * with resume set once the start wait has passed
+ */
+int sbl_pml_llr_start(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link = sbl->link + port_num;
 	u32 base = SBL_PML_BASE(port_num);
-	u64 llr_max_data;
-	u64 llr_max_seq;
 	u64 val64;
 	int err = -1;
 
+	if (resume)
+		goto ready_wait;
+
 	sbl_dev_dbg(sbl->dev, "%d: LLR start", port_num);
 
+	link->pml_wait.llr_remeasure = false;
+
 	sbl_link_info_clear(sbl, port_num, SBL_LINK_INFO_LLR_DISABLED);
 
 	sbl_pml_llr_enable_loop_timing(sbl, port_num);
@@ -494,38 +572,24 @@ int sbl_pml_llr_start(struct sbl_inst *sbl, int port_num)
 	sbl_pml_pcs_ordered_sets(sbl, port_num, true);
 
 	/* measure llr loop time if we don't have it already */
-	if (!link->llr_loop_time) {
-		err = sbl_pml_llr_measure_loop_time_ns(sbl, port_num, &link->llr_loop_time);
+	if (!link->llr_loop_time && sbl_pml_llr_loop_time_cache_match(link)) {
+		link->llr_loop_time = link->llr_loop_time_cached;
+		sbl_dev_dbg(sbl->dev, "%d: LLR using cached loop time = %lldns",
+			port_num, link->llr_loop_time);
+	}
+	if (link->llr_loop_time) {
+		link->pml_wait.llr_remeasure = true;
+	} else {
+		err = sbl_pml_llr_measure_loop_time_ns(sbl, port_num, true, &link->llr_loop_time);
 		if (err) {
 			sbl_dev_err(sbl->dev, "%d: LLR loop measurement failed [%d]", port_num, err);
 			goto out_err;
 		}
+		sbl_pml_llr_loop_time_cache_set(link, link->llr_loop_time);
 	}
 
-	/* set max replay time from loop-back time */
-	val64 = sbl_read64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET);
-	if (link->blattr.options & SBL_DISABLE_PML_RECOVERY)
-		val64 = SBL_PML_CFG_LLR_SM_REPLAY_CT_MAX_UPDATE(val64, SBL_DFLT_REPLAY_CT_MAX);
-	else
-		val64 = SBL_PML_CFG_LLR_SM_REPLAY_CT_MAX_UPDATE(val64, SBL_LLR_REPLAY_CT_MAX_UNLIMITED);
-	val64 = SBL_PML_CFG_LLR_SM_REPLAY_TIMER_MAX_UPDATE(val64,
-			3 * link->llr_loop_time + 500);
-	sbl_write64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET, val64);
-	sbl_read64(sbl, base|SBL_PML_CFG_LLR_SM_OFFSET);  /* flush */
-
-	/* capacity configuration */
-	if (link->blattr.options & SBL_OPT_FABRIC_LINK) {
-		/* these can be set to their defaults for fabric links */
-		sbl_write64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET,
-				SBL_PML_CFG_LLR_CAPACITY_DFLT);
-		sbl_read64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET);  /* flush */
-	} else {
-		sbl_pml_llr_calculate_capacity(sbl, port_num, &llr_max_data, &llr_max_seq);
-		val64 = SBL_PML_CFG_LLR_CAPACITY_MAX_DATA_SET(llr_max_data) |
-			SBL_PML_CFG_LLR_CAPACITY_MAX_SEQ_SET(llr_max_seq);
-		sbl_write64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET, val64);
-		sbl_read64(sbl, base|SBL_PML_CFG_LLR_CAPACITY_OFFSET);  /* flush */
-	}
+	/* replay timer and capacity */
+	sbl_pml_llr_loop_time_config(sbl, port_num);
 
 	/* set max data age timer & link down timer */
 	if (link->blattr.options & SBL_DISABLE_PML_RECOVERY)
@@ -549,7 +613,14 @@ int sbl_pml_llr_start(struct sbl_inst *sbl, int port_num)
 	sbl_pml_llr_mode_set(sbl, port_num, link->llr_mode);
 
 	/* wait for llr to start */
+	sbl_dev_dbg(sbl->dev, "%d: LLR ready wait", port_num);
+	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_LLR_WAIT);
+	link->pml_wait.state = SBL_PML_WAIT_LLR_READY;
+
+ready_wait:
 	err = sbl_pml_llr_ready_wait(sbl, port_num);
+	if (err == -EINPROGRESS)
+		return err;
 	if (err) {
 		sbl_dev_err(sbl->dev, "%d: LLR ready wait failed [%d]", port_num, err);
 		goto out_err;
@@ -559,16 +630,95 @@ int sbl_pml_llr_start(struct sbl_inst *sbl, int port_num)
 	sbl_dev_dbg(sbl->dev, "%d: LLR running", port_num);
 	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_LLR_RUN);
 
+	/* check a loop time we didn't measure now the link is running */
+	if (link->pml_wait.llr_remeasure) {
+		WRITE_ONCE(link->llr_remeasure.stopped, false);
+		queue_delayed_work(sbl->workq, &link->llr_remeasure.work,
+				msecs_to_jiffies(SBL_PML_LLR_REMEASURE_DELAY));
+	}
+
 out:
 	sbl_pml_llr_disable_loop_timing(sbl, port_num);
 	return 0;
 
 out_err:
+	/* dont trust a loop time llr failed to start with */
+	if (link->pml_wait.llr_remeasure)
+		link->llr_loop_time_cached = 0;
 	sbl_pml_llr_disable_loop_timing(sbl, port_num);
 	sbl_pml_llr_stop(sbl, port_num);
 	return err;
 }
 
+/**
+ * sbl_pml_llr_remeasure_work() - Re-measure the llr loop time of a running link
+ * @work: the link llr_remeasure work
+ *
+ * Used when llr was started from a cached or previous loop time. The loop
+ * time is measured again on the running link and the replay timer and
+ * capacity are only reprogrammed if the measurement has moved by more
+ * than SBL_PML_LLR_REMEASURE_TOLERANCE percent. The work is skipped if
+ * the link is no longer up or llr has been stopped, and retried later if
+ * the link is busy.
+ *
+ * Context: Process context (instance workqueue). Only ever trylocks the
+ * port busy mutex.
+ */
+void sbl_pml_llr_remeasure_work(struct work_struct *work)
+{
+	struct sbl_llr_remeasure *llr_remeasure =
+		container_of(to_delayed_work(work), struct sbl_llr_remeasure, work);
+	struct sbl_inst *sbl = llr_remeasure->sbl;
+	int port_num = llr_remeasure->port_num;
+	struct sbl_link *link = sbl->link + port_num;
+	u64 llr_loop_time;
+	u64 diff;
+	int err;
+
+	if (READ_ONCE(llr_remeasure->stopped))
+		return;
+
+	if (!mutex_trylock(&link->busy_mtx)) {
+		queue_delayed_work(sbl->workq, &llr_remeasure->work,
+				msecs_to_jiffies(SBL_PML_LLR_REMEASURE_DELAY));
+		return;
+	}
+
+	if (link->blstate == SBL_BASE_LINK_STATUS_STARTING) {
+		mutex_unlock(&link->busy_mtx);
+		queue_delayed_work(sbl->workq, &llr_remeasure->work,
+				msecs_to_jiffies(SBL_PML_LLR_REMEASURE_DELAY));
+		return;
+	}
+
+	if (llr_remeasure->stopped || (link->blstate != SBL_BASE_LINK_STATUS_UP) ||
+			!(link->link_info & SBL_LINK_INFO_LLR_RUN))
+		goto out;
+
+	sbl_pml_llr_enable_loop_timing(sbl, port_num);
+	err = sbl_pml_llr_measure_loop_time_ns(sbl, port_num, false, &llr_loop_time);
+	sbl_pml_llr_disable_loop_timing(sbl, port_num);
+	if (err)
+		goto out;
+
+	sbl_pml_llr_loop_time_cache_set(link, llr_loop_time);
+
+	/* measurements are noisy, only reprogram for a real move */
+	diff = (llr_loop_time > link->llr_loop_time) ?
+		llr_loop_time - link->llr_loop_time : link->llr_loop_time - llr_loop_time;
+	if (diff * 100 <= link->llr_loop_time * SBL_PML_LLR_REMEASURE_TOLERANCE)
+		goto out;
+
+	sbl_dev_dbg(sbl->dev, "%d: LLR loop time moved %lldns -> %lldns",
+		port_num, link->llr_loop_time, llr_loop_time);
+
+	link->llr_loop_time = llr_loop_time;
+	sbl_pml_llr_loop_time_config(sbl, port_num);
+
+out:
+	mutex_unlock(&link->busy_mtx);
+}
+
 /**
  * sbl_pml_llr_get_state() - Get pml llr state
  * @sbl: A slingshot base link device instance
@@ -607,7 +757,9 @@ EXPORT_SYMBOL(sbl_pml_llr_get_state);
  * @sbl: A slingshot base link device instance
  * @port_num: port number
  *
- * Configure various pml llr registers to stop functionality
+ * Configure various pml llr registers to stop functionality. Any pending
+ * loop time re-measurement is abandoned; one already running sees the
+ * stop once it has the port busy mutex.
  */
 void sbl_pml_llr_stop(struct sbl_inst *sbl, int port_num)
 {
@@ -617,6 +769,9 @@ void sbl_pml_llr_stop(struct sbl_inst *sbl, int port_num)
 
 	sbl_dev_dbg(sbl->dev, "%d: LLR stop", port_num);
 
+	WRITE_ONCE(link->llr_remeasure.stopped, true);
+	cancel_delayed_work(&link->llr_remeasure.work);
+
 	link->llr_mode = SBL_LLR_MODE_OFF;
 
 	val64 = sbl_read64(sbl, base|SBL_PML_CFG_LLR_OFFSET);
@@ -146,17 +146,80 @@ static void sbl_pml_pcs_stop_lock(struct sbl_inst *sbl, int port_num)
 	sbl_read64(sbl, base|SBL_PML_CFG_RX_PCS_OFFSET);
 }
 
-/* wait for the pcs to become aligned */
-static int sbl_pml_pcs_alignment_wait(struct sbl_inst *sbl, int port_num)
+/* time until the next poll (ms)
+ *
+ * no pml flag signals lock or alignment being gained, so polling is all
+ * there is - poll fast while the port would usually get there and then
+ * back off
+ */
+static unsigned int sbl_pml_pcs_poll_period(unsigned int elapsed, u32 time_avg)
 {
-	unsigned long start_jiffy;
-	int elapsed;
-	int err = 0;
+	unsigned int fast_poll_time = max_t(unsigned int, SBL_PML_PCS_FAST_POLL_TIME, 2 * time_avg);
+
+	if (elapsed <= fast_poll_time)
+		return SBL_PML_PCS_FAST_POLL_PERIOD;
+	else
+		return SBL_PML_PCS_SLOW_POLL_PERIOD;
+}
+
+/* restart locking after a multiple of the usual time for this port */
+static unsigned int sbl_pml_pcs_restart_time(u32 time_avg, unsigned int max_time)
+{
+	if (!time_avg)
+		return max_time;
+
+	return clamp_t(unsigned int, SBL_PML_PCS_RESTART_FACTOR * time_avg,
+			SBL_PML_PCS_RESTART_MIN, max_time);
+}
+
+static void sbl_pml_pcs_time_avg_update(u32 *time_avg, unsigned int elapsed)
+{
+	if (*time_avg)
+		*time_avg = (3 * *time_avg + elapsed) / 4;
+	else
+		*time_avg = max_t(unsigned int, elapsed, 1);
+}
+
+/* (re)start waiting for the pcs to lock */
+static void sbl_pml_pcs_lock_wait_restart(struct sbl_pml_wait *pml_wait)
+{
+	pml_wait->state = SBL_PML_WAIT_PCS_LOCK;
+	pml_wait->start_jiffy = jiffies;
+	pml_wait->restart_jiffy = pml_wait->start_jiffy;
+	pml_wait->check_jiffy = pml_wait->start_jiffy;
+}
+
+static void sbl_pml_pcs_alignment_wait_begin(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_pml_wait *pml_wait = &link->pml_wait;
 
 	sbl_dev_dbg(sbl->dev, "%d: pml pcs alignment wait\n", port_num);
 
 	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_PCS_A_WAIT);
 
+	pml_wait->lock_restart = sbl_pml_pcs_restart_time(link->pcs_lock_time_avg,
+			SBL_PML_PCS_LOCK_TIMEOUT);
+	pml_wait->align_restart = sbl_pml_pcs_restart_time(link->pcs_align_time_avg,
+			SBL_PML_PCS_ALIGN_TIMEOUT);
+
+	sbl_pml_pcs_lock_wait_restart(pml_wait);
+}
+
+/* wait for the pcs to become aligned
+ *
+ * returns -EINPROGRESS until the next poll is due
+ */
+static int sbl_pml_pcs_alignment_wait(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_pml_wait *pml_wait = &link->pml_wait;
+	int elapsed;
+	int err = 0;
+
+	if (pml_wait->state == SBL_PML_WAIT_PCS_ALIGN)
+		goto align;
+
 	 /*   poll for all lanes to get bitlock
 	  *
 	  *   This might be a very long time as the other end obviously needs to
@@ -168,9 +231,8 @@ static int sbl_pml_pcs_alignment_wait(struct sbl_inst *sbl, int port_num)
 	  *   Occasionally the pcs seems to get stuck and some lanes never come up.
 	  *   Restarting locking seems to clear this.
 	  */
-restart:
-	start_jiffy = jiffies;
-	while (!sbl_pml_pcs_locked(sbl, port_num)) {
+lock:
+	if (!sbl_pml_pcs_locked(sbl, port_num)) {
 
 		if (sbl_start_timeout(sbl, port_num)) {
 			sbl_dev_dbg(sbl->dev, "%d: pcs lock wait timeout\n",
@@ -186,8 +248,9 @@ restart:
 			goto out;
 		}
 
-		elapsed = jiffies_to_msecs(jiffies - start_jiffy);
-		if (elapsed > 1000) {
+		elapsed = jiffies_to_msecs(jiffies - pml_wait->check_jiffy);
+		if (elapsed > SBL_PML_PCS_LOCK_TIMEOUT) {
+			pml_wait->check_jiffy = jiffies;
 
 			/* if we have a high serdes error, we will never align  */
 			if (sbl_pml_pcs_high_serdes_error(sbl, port_num)) {
@@ -202,22 +265,29 @@ restart:
 				sbl_dev_warn(sbl->dev, "%d: pcs lock some eyes have gone bad", port_num);
 				goto out;
 			}
+		}
 
+		elapsed = jiffies_to_msecs(jiffies - pml_wait->restart_jiffy);
+		if (elapsed > pml_wait->lock_restart) {
 			/* restart locking in case it's locked up */
 			sbl_pml_pcs_stop_lock(sbl, port_num);
 			sbl_pml_pcs_start_lock(sbl, port_num);
+			pml_wait->restart_jiffy = jiffies;
+			elapsed = 0;
+		}
 
-			msleep(SBL_PML_PCS_ALIGN_SLOW_POLL_DELAY);
-		} else if (elapsed > 50)
-			msleep(100);
-		else
-			usleep_range(10000, 11000);
+		return sbl_start_wait(sbl, port_num,
+				sbl_pml_pcs_poll_period(elapsed, link->pcs_lock_time_avg));
 	}
+	sbl_pml_pcs_time_avg_update(&link->pcs_lock_time_avg,
+			jiffies_to_msecs(jiffies - pml_wait->restart_jiffy));
 
 	/* poll for lane alignment */
-	start_jiffy = jiffies;
+	pml_wait->state = SBL_PML_WAIT_PCS_ALIGN;
+	pml_wait->start_jiffy = jiffies;
 
-	while (!sbl_pml_pcs_aligned(sbl, port_num)) {
+align:
+	if (!sbl_pml_pcs_aligned(sbl, port_num)) {
 
 		if (sbl_start_timeout(sbl, port_num)) {
 			sbl_dev_dbg(sbl->dev, "%d: pcs align wait timeout\n",
@@ -236,23 +306,27 @@ restart:
 		/* if we lose lock restart trying to lock again  */
 		if (!sbl_pml_pcs_locked(sbl, port_num)) {
 			sbl_dev_warn(sbl->dev, "%d: pcs align - lost lock\n", port_num);
-			goto restart;
+			sbl_pml_pcs_lock_wait_restart(pml_wait);
+			goto lock;
 		}
 
-		elapsed = jiffies_to_msecs(jiffies - start_jiffy);
-		if (elapsed > SBL_PML_PCS_ALIGN_TIMEOUT) {
+		elapsed = jiffies_to_msecs(jiffies - pml_wait->start_jiffy);
+		if (elapsed > pml_wait->align_restart) {
 
 			/* we should have got alignment by now
 			 * give up, restart locking and try again
 			 */
 			sbl_pml_pcs_stop_lock(sbl, port_num);
 			sbl_pml_pcs_start_lock(sbl, port_num);
-			goto restart;
-		} else if (elapsed > 50)
-			msleep(100);
-		else
-			usleep_range(10000, 11000);
+			sbl_pml_pcs_lock_wait_restart(pml_wait);
+			goto lock;
+		}
+
+		return sbl_start_wait(sbl, port_num,
+				sbl_pml_pcs_poll_period(elapsed, link->pcs_align_time_avg));
 	}
+	sbl_pml_pcs_time_avg_update(&link->pcs_align_time_avg,
+			jiffies_to_msecs(jiffies - pml_wait->start_jiffy));
 
 out:
 	sbl_link_info_clear(sbl, port_num, SBL_LINK_INFO_PCS_A_WAIT);
@@ -272,71 +346,78 @@ static bool sbl_pml_pcs_no_faults(struct sbl_inst *sbl, int port_num)
 	return (faults == 0ULL);
 }
 
+static void sbl_pml_pcs_fault_clear_wait_begin(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_pml_wait *pml_wait = &sbl->link[port_num].pml_wait;
+
+	sbl_dev_dbg(sbl->dev, "%d: pml pcs fault clear wait\n", port_num);
+
+	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_PCS_F_WAIT);
+
+	pml_wait->state = SBL_PML_WAIT_PCS_FAULT;
+	pml_wait->start_jiffy = jiffies;
+	pml_wait->no_fault_count = 0;
+}
+
 /* wait for pcs faults to clear
  *
  * we wait for fault to stay clear as it is momentarily set sometimes
+ *
+ * returns -EINPROGRESS until the next poll is due
  */
 static int sbl_pml_pcs_fault_clear_wait(struct sbl_inst *sbl, int port_num)
 {
-	unsigned long start_jiffy = jiffies;
-	int no_fault_count = 0;
+	struct sbl_pml_wait *pml_wait = &sbl->link[port_num].pml_wait;
 	int elapsed;
 	int err;
 
-	sbl_dev_dbg(sbl->dev, "%d: pml pcs fault clear wait\n", port_num);
-
-	sbl_link_info_set(sbl, port_num, SBL_LINK_INFO_PCS_F_WAIT);
-
-	while (true) {
+	/* check for timeout */
+	if (sbl_start_timeout(sbl, port_num)) {
+		sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait timeout\n",
+				port_num);
+		err = -ETIMEDOUT;
+		goto out;
+	}
 
-		/* check for timeout */
-		if (sbl_start_timeout(sbl, port_num)) {
-			sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait timeout\n",
-					port_num);
-			err = -ETIMEDOUT;
-			goto out;
-		}
+	if (sbl_base_link_start_cancelled(sbl, port_num)) {
+		sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait cancelled\n",
+				port_num);
+		err = -ECANCELED;
+		goto out;
+	}
 
-		if (sbl_base_link_start_cancelled(sbl, port_num)) {
-			sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait cancelled\n",
-					port_num);
-			err = -ECANCELED;
-			goto out;
-		}
+	/* check we are still aligned */
+	if (!sbl_pml_pcs_aligned(sbl, port_num)) {
+		sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait lost alignment\n",
+				port_num);
+		err = -ENOLCK;
+		goto out;
+	}
 
-		/* check we are still aligned */
-		if (!sbl_pml_pcs_aligned(sbl, port_num)) {
-			sbl_dev_dbg(sbl->dev, "%d: pml fault clear wait lost alignment\n",
-					port_num);
-			err = -ENOLCK;
+	/* check for no fault
+	 * we need multiple good tests to be sure it is up
+	 */
+	if (sbl_pml_pcs_no_faults(sbl, port_num)) {
+		++pml_wait->no_fault_count;
+		if (pml_wait->no_fault_count == SBL_PML_REQUIRED_NO_FAULT_COUNT) {
+			/* done */
+			err = 0;
 			goto out;
+		} else {
+			/* poll fast and check again */
+			pml_wait->start_jiffy = jiffies;
 		}
-
-		/* check for no fault
-		 * we need multiple good tests to be sure it is up
-		 */
-		if (sbl_pml_pcs_no_faults(sbl, port_num)) {
-			++no_fault_count;
-			if (no_fault_count == SBL_PML_REQUIRED_NO_FAULT_COUNT) {
-				/* done */
-				err = 0;
-				goto out;
-			} else {
-				/* poll fast and check again */
-				start_jiffy = jiffies;
-			}
-		} else
-			no_fault_count = 0;
-
-		/* wait with backoff */
-		elapsed = jiffies_to_msecs(jiffies - start_jiffy);
-		if (elapsed > 5000)
-			msleep(1000);
-		else if (elapsed > 100)
-			msleep(100);
-		else
-			usleep_range(10000, 11000);
-	}
+	} else
+		pml_wait->no_fault_count = 0;
+
+	/* wait with backoff */
+	elapsed = jiffies_to_msecs(jiffies - pml_wait->start_jiffy);
+	if (elapsed > 5000)
+		return sbl_start_wait(sbl, port_num, 1000);
+	else if (elapsed > 100)
+		return sbl_start_wait(sbl, port_num, 100);
+	else
+		return sbl_start_wait(sbl, port_num, 10);
 
 out:
 	sbl_link_info_clear(sbl, port_num, SBL_LINK_INFO_PCS_F_WAIT);
@@ -662,47 +743,61 @@ void sbl_pml_pcs_clear_tx_rf(struct sbl_inst *sbl, int port_num)
  *
  *   i.e for it to be locked and aligned and faults to have cleared
  *
- *
+ *   returns -EINPROGRESS while waiting, call again with resume set
+ *   once the start wait has passed
  */
-int sbl_pml_pcs_wait(struct sbl_inst *sbl, int port_num)
+int sbl_pml_pcs_wait(struct sbl_inst *sbl, int port_num, bool resume)
 {
+	struct sbl_pml_wait *pml_wait = &sbl->link[port_num].pml_wait;
 	char pcs_state_str[SBL_PCS_STATE_STR_LEN];
 	int err;
 
-	sbl_dev_dbg(sbl->dev, "%d: pcs wait", port_num);
+	if (!resume) {
+		sbl_dev_dbg(sbl->dev, "%d: pcs wait", port_num);
 
-	/* start locking */
-	sbl_pml_pcs_start_lock(sbl, port_num);
+		/* start locking */
+		sbl_pml_pcs_start_lock(sbl, port_num);
 
-	/* clear forcing remote fault.
-	 * (it will continue to be set until PCS is actually ready)
-	 */
-	sbl_pml_pcs_clear_tx_rf(sbl, port_num);
+		/* clear forcing remote fault.
+		 * (it will continue to be set until PCS is actually ready)
+		 */
+		sbl_pml_pcs_clear_tx_rf(sbl, port_num);
+
+		sbl_pml_pcs_alignment_wait_begin(sbl, port_num);
+	}
 
 	/* keep trying to bring the pcs up until we timeout */
 	while (true) {
 
-		/* wait for alignment */
-		err = sbl_pml_pcs_alignment_wait(sbl, port_num);
-		switch (err) {
-		case 0:
-			break;
+		if (pml_wait->state != SBL_PML_WAIT_PCS_FAULT) {
 
-		case -ETIMEDOUT:
-			/* out of time, dump state and give up  */
-			sbl_dev_err(sbl->dev, "%d: pcs_wait alignment timeout (%s)\n", port_num,
-					sbl_pml_pcs_state_str(sbl, port_num, pcs_state_str,
-							SBL_PCS_STATE_STR_LEN));
-			goto out;
+			/* wait for alignment */
+			err = sbl_pml_pcs_alignment_wait(sbl, port_num);
+			switch (err) {
+			case 0:
+				break;
 
-		case -ECANCELED:
-			sbl_dev_dbg(sbl->dev, "%d: pcs_wait alignment failed [%d]\n", port_num, err);
-			goto out;
+			case -EINPROGRESS:
+				return err;
 
-		default:
-			/* something unexpected */
-			sbl_dev_err(sbl->dev, "%d: pcs_wait alignment failed [%d]\n", port_num, err);
-			goto out;
+			case -ETIMEDOUT:
+				/* out of time, dump state and give up  */
+				sbl_dev_err(sbl->dev, "%d: pcs_wait alignment timeout (%s)\n", port_num,
+						sbl_pml_pcs_state_str(sbl, port_num, pcs_state_str,
+								SBL_PCS_STATE_STR_LEN));
+				goto out;
+
+			case -ECANCELED:
+				sbl_dev_dbg(sbl->dev, "%d: pcs_wait alignment failed [%d]\n", port_num, err);
+				goto out;
+
+			default:
+				/* something unexpected */
+				sbl_dev_err(sbl->dev, "%d: pcs_wait alignment failed [%d]\n", port_num, err);
+				goto out;
+			}
+
+			sbl_pml_pcs_fault_clear_wait_begin(sbl, port_num);
 		}
 
 		/* wait for faults to clear */
@@ -712,11 +807,15 @@ int sbl_pml_pcs_wait(struct sbl_inst *sbl, int port_num)
 		case 0:
 			goto out;
 
+		case -EINPROGRESS:
+			return err;
+
 		case -ENOLCK:
 			/* alignment lost - try to align again  */
 			sbl_dev_warn(sbl->dev, "%d: pcs_wait alignment lost - restart (%s)\n", port_num,
 					sbl_pml_pcs_state_str(sbl, port_num, pcs_state_str,
 							SBL_PCS_STATE_STR_LEN));
+			sbl_pml_pcs_alignment_wait_begin(sbl, port_num);
 			continue;
 
 		case -ETIMEDOUT:
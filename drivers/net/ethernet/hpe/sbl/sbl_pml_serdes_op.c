@@ -7,6 +7,8 @@
 #include <linux/slab.h>
 #include <linux/device.h>
 #include <linux/delay.h>
+#include <linux/bitops.h>
+#include <linux/ktime.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_kconfig.h>
@@ -26,6 +28,140 @@ static inline bool sbl_pml_serdes_op_busy(struct sbl_inst *sbl, int port_num)
 	return SBL_PML_SERDES_CORE_INTERRUPT_DO_CORE_INTERRUPT_GET(val64);
 }
 
+/*
+ * Hybrid completion polling
+ *
+ * Most core interrupts finish in microseconds, far below the msleep()
+ * granularity of the plain poll. In hybrid mode the op is busy-polled
+ * for about twice its learned completion time (bounded), then polled
+ * with a doubling usleep_range() backoff up to the flags poll interval.
+ * The completion time is learned per interrupt code as a moving average
+ * shared by all ports of the instance.
+ */
+
+static u32 sbl_pml_serdes_op_learned_ns(struct sbl_inst *sbl, u64 op)
+{
+	return READ_ONCE(sbl->serdes_op_ns[op & (SBL_SERDES_OP_CODES - 1)]);
+}
+
+static void sbl_pml_serdes_op_learn(struct sbl_inst *sbl, u64 op, u64 ns)
+{
+	u32 *learned = sbl->serdes_op_ns + (op & (SBL_SERDES_OP_CODES - 1));
+	u32 avg = READ_ONCE(*learned);
+	u32 sample = min_t(u64, ns, U32_MAX);
+
+	/* racy between ports, but only ever a hint */
+	WRITE_ONCE(*learned, avg ? avg - avg / SBL_SERDES_OP_LEARN_WEIGHT +
+			sample / SBL_SERDES_OP_LEARN_WEIGHT : sample);
+}
+
+static int sbl_pml_serdes_op_wait_hybrid(struct sbl_inst *sbl, int port_num, u64 op,
+		u64 start_ns, unsigned long last_jiffy, int poll_interval)
+{
+	u32 learned_ns = sbl_pml_serdes_op_learned_ns(sbl, op);
+	u64 spin_ns;
+	u32 sleep_us;
+	u32 max_sleep_us = poll_interval * USEC_PER_MSEC;
+
+	spin_ns = clamp_t(u64, 2 * (u64)learned_ns, SBL_SERDES_OP_SPIN_MIN_NS,
+			SBL_SERDES_OP_SPIN_MAX_NS);
+
+	while (ktime_get_ns() - start_ns < spin_ns) {
+		if (!sbl_pml_serdes_op_busy(sbl, port_num))
+			goto out;
+		udelay(1);
+	}
+
+	sleep_us = clamp_t(u32, learned_ns / NSEC_PER_USEC / 2,
+			SBL_SERDES_OP_SLEEP_MIN_US, max_sleep_us);
+	while (sbl_pml_serdes_op_busy(sbl, port_num)) {
+		if (time_is_before_jiffies(last_jiffy))
+			return -ETIMEDOUT;
+		usleep_range(sleep_us, 2 * sleep_us);
+		sleep_us = min(2 * sleep_us, max_sleep_us);
+	}
+
+ out:
+	sbl_pml_serdes_op_learn(sbl, op, ktime_get_ns() - start_ns);
+	return 0;
+}
+
+/* run one core interrupt on one serdes, serdes_mtx held */
+static int sbl_pml_serdes_op_run(struct sbl_inst *sbl, int port_num, u64 serdes_sel,
+		u64 op, u64 data, u16 *result, int timeout, unsigned int flags,
+		int poll_interval)
+{
+	u32 base = SBL_PML_BASE(port_num);
+	int delay = sbl_flags_get_delay_from_flags(flags);
+	u64 val64;
+	u64 start_ns;
+	unsigned long last_jiffy;
+	int err;
+
+	if (sbl_pml_serdes_op_busy(sbl, port_num))
+		return -EBUSY;
+
+	/* start the operation  */
+	val64 = SBL_PML_SERDES_CORE_INTERRUPT_SET(serdes_sel, 1ULL, op, data);
+	start_ns = ktime_get_ns();
+	sbl_write64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET, val64);
+	sbl_read64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET);  /* flush */
+
+	if (delay)
+		udelay(delay);
+
+	/* poll for completion or timeout */
+	last_jiffy = jiffies + msecs_to_jiffies(timeout) + 1;
+	if (flags & SBL_FLAG_POLL_HYBRID) {
+		err = sbl_pml_serdes_op_wait_hybrid(sbl, port_num, op, start_ns,
+				last_jiffy, poll_interval);
+		if (err)
+			return err;
+	} else {
+		while (sbl_pml_serdes_op_busy(sbl, port_num)) {
+			if (time_is_before_jiffies(last_jiffy))
+				return -ETIMEDOUT;
+			msleep(poll_interval);
+		}
+	}
+
+	/* get the result */
+	val64 = sbl_read64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET);
+	*result = SBL_PML_SERDES_CORE_INTERRUPT_CORE_INTERRUPT_DATA_GET(val64);
+
+	return 0;
+}
+
+/* common argument checks, returns the poll interval */
+static int sbl_pml_serdes_op_check(struct sbl_inst *sbl, int port_num,
+		void *result, int timeout, unsigned int flags)
+{
+	int poll_interval;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	if (!result)
+		return -EINVAL;
+
+	/* cannot wait infinitely */
+	if (!timeout)
+		return -EINVAL;
+
+	/* a polling interval is mandatory */
+	poll_interval = sbl_flags_get_poll_interval_from_flags(flags);
+	if (!poll_interval)
+		return -EINVAL;
+
+	return poll_interval;
+}
+
 /**
  * sbl_pml_serdes_op() - Perform a serdes interrupt configuration
  * @sbl: A slingshot base link device instance
@@ -50,74 +186,84 @@ int sbl_pml_serdes_op(struct sbl_inst *sbl, int port_num, u64 serdes_sel,
 		u64 op, u64 data, u16 *result, int timeout, unsigned int flags)
 {
 	struct sbl_link *link;
-	u32 base = SBL_PML_BASE(port_num);
-	u64 val64;
-	int delay;
 	int poll_interval;
-	unsigned long last_jiffy;
 	int err;
 
-	err = sbl_validate_instance(sbl);
-	if (err)
-		return err;
-
-	err = sbl_validate_port_num(sbl, port_num);
-	if (err)
-		return err;
+	poll_interval = sbl_pml_serdes_op_check(sbl, port_num, result, timeout, flags);
+	if (poll_interval < 0)
+		return poll_interval;
 
 	sbl_dev_dbg(sbl->dev, "serdes op, p%ds%lld, %lld, %lld, %d 0x%x\n",
 		port_num, serdes_sel, op, data, timeout, flags);
 
-	if (!result)
-		return -EINVAL;
+	link = sbl->link + port_num;
+	err = mutex_lock_interruptible(&link->serdes_mtx);
+	if (err)
+		return -ERESTARTSYS;
 
-	/* cannot wait infinitely */
-	if (!timeout)
-		return -EINVAL;
+	err = sbl_pml_serdes_op_run(sbl, port_num, serdes_sel, op, data, result,
+			timeout, flags, poll_interval);
 
-	/* a polling interval is mandatory */
-	poll_interval = sbl_flags_get_poll_interval_from_flags(flags);
-	if (!poll_interval)
+	mutex_unlock(&link->serdes_mtx);
+	return err;
+}
+EXPORT_SYMBOL(sbl_pml_serdes_op);
+
+/**
+ * sbl_pml_serdes_op_lanes() - Perform a serdes interrupt on several lanes
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @lane_mask: serdes lanes to interrupt
+ * @op: interrupt code
+ * @data: interrupt data
+ * @results: result for each lane, indexed by serdes
+ * @timeout: Time set used for polling each lane
+ * @flags: Used to set US/MSec delay
+ *
+ * The core interrupt register takes one serdes at a time, so the lanes
+ * are run back to back under a single hold of the serdes mutex rather
+ * than as separately checked and locked ops. Stops at the first lane
+ * that fails; results are only valid for lanes before it.
+ *
+ * Context: May sleep based on access to serdes
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_pml_serdes_op_lanes(struct sbl_inst *sbl, int port_num, u32 lane_mask,
+		u64 op, u64 data, u16 *results, int timeout, unsigned int flags)
+{
+	unsigned long lanes = lane_mask;
+	struct sbl_link *link;
+	int poll_interval;
+	int serdes;
+	int err;
+
+	poll_interval = sbl_pml_serdes_op_check(sbl, port_num, results, timeout, flags);
+	if (poll_interval < 0)
+		return poll_interval;
+
+	if (lanes & ~GENMASK(sbl->switch_info->num_serdes - 1, 0))
 		return -EINVAL;
 
-	delay = sbl_flags_get_delay_from_flags(flags);
+	sbl_dev_dbg(sbl->dev, "serdes op, p%d lanes 0x%lx, %lld, %lld, %d 0x%x\n",
+		port_num, lanes, op, data, timeout, flags);
 
 	link = sbl->link + port_num;
 	err = mutex_lock_interruptible(&link->serdes_mtx);
 	if (err)
 		return -ERESTARTSYS;
 
-	if (sbl_pml_serdes_op_busy(sbl, port_num)) {
-		mutex_unlock(&link->serdes_mtx);
-		return -EBUSY;
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		err = sbl_pml_serdes_op_run(sbl, port_num, serdes, op, data,
+				results + serdes, timeout, flags, poll_interval);
+		if (err)
+			break;
 	}
 
-	/* start the operation  */
-	val64 = SBL_PML_SERDES_CORE_INTERRUPT_SET(serdes_sel, 1ULL, op, data);
-	sbl_write64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET, val64);
-	sbl_read64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET);  /* flush */
-
-	if (delay)
-		udelay(delay);
-
-	/* poll for completion or timeout */
-	last_jiffy = jiffies + msecs_to_jiffies(timeout) + 1;
-	while (sbl_pml_serdes_op_busy(sbl, port_num)) {
-		if (time_is_before_jiffies(last_jiffy)) {
-			mutex_unlock(&link->serdes_mtx);
-			return -ETIMEDOUT;
-		}
-		msleep(poll_interval);
-	}
-
-	/* get the result */
-	val64 = sbl_read64(sbl, base|SBL_PML_SERDES_CORE_INTERRUPT_OFFSET);
-	*result = SBL_PML_SERDES_CORE_INTERRUPT_CORE_INTERRUPT_DATA_GET(val64);
-
 	mutex_unlock(&link->serdes_mtx);
-	return 0;
+	return err;
 }
-EXPORT_SYMBOL(sbl_pml_serdes_op);
+EXPORT_SYMBOL(sbl_pml_serdes_op_lanes);
 
 /**
  * sbl_pml_serdes_op_timing() - serdes core interrupt access timings
@@ -33,6 +33,18 @@ inline int sbl_sbm_sbus_op_reset(struct sbl_inst *sbl, int ring)
 	return sbl_sbus_op_reset(sbl, ring);
 }
 
+inline bool sbl_sbm_has_sbus_op_batch(struct sbl_inst *sbl)
+{
+	return sbl->ops.sbl_sbus_op_batch != NULL;
+}
+
+inline int sbl_sbm_sbus_op_batch(struct sbl_inst *sbl, int ring,
+				 struct sbl_sbus_op_desc *desc, int num_ops,
+				 int timeout, u32 flags)
+{
+	return sbl_sbus_op_batch(sbl, ring, desc, num_ops, timeout, flags);
+}
+
 inline int sbl_sbm_pml_serdes_op(struct sbl_inst *sbl, int port_num,
 				   u64 serdes_sel, u64 op, u64 data,
 				   u16 *result, int timeout, u32 flags)
@@ -41,6 +53,14 @@ inline int sbl_sbm_pml_serdes_op(struct sbl_inst *sbl, int port_num,
 				 timeout, flags);
 }
 
+inline int sbl_sbm_pml_serdes_op_lanes(struct sbl_inst *sbl, int port_num,
+					 u32 lane_mask, u64 op, u64 data,
+					 u16 *results, int timeout, u32 flags)
+{
+	return sbl_pml_serdes_op_lanes(sbl, port_num, lane_mask, op, data,
+				       results, timeout, flags);
+}
+
 inline int sbl_sbm_get_sbus_op_timeout_ms(struct sbl_inst *sbl)
 {
 	return sbl->iattr.sbus_op_timeout_ms;
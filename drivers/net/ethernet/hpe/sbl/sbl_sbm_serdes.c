@@ -5,6 +5,9 @@
 #include <linux/kernel.h>
 #include <linux/device.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/bitops.h>
 
 #include <uapi/ethernet/sbl_sbm_constants.h>
 
@@ -630,6 +633,154 @@ static void sbus_msg(void *inst, u32 sbus_addr, u32 req_data,
 	sbus_msg_print(inst, severity, message);
 }
 
+/*
+ * Binary sbus op log
+ *
+ * Every op is recorded raw into a per-ring ring of records so the hot
+ * path does no string formatting. There is a single writer per ring (it
+ * holds the ring mutex) and readers never lock: each record carries its
+ * op number, which is cleared while the record is rewritten, so a reader
+ * can tell a torn copy and skip it. Records are decoded only when read
+ * through sysfs or dumped after a failed op.
+ */
+
+static struct sbl_sbus_op_log *sbl_sbus_op_log_get(struct sbl_inst *sbl, u32 sbus_ring)
+{
+	/* an out of range ring is logged with ring 0 */
+	if (sbus_ring >= sbl->switch_info->num_sbus_rings)
+		sbus_ring = 0;
+
+	return sbl->sbus_op_log + sbus_ring;
+}
+
+static void sbl_sbus_op_log(struct sbl_inst *sbl, u32 sbus_addr, u32 req_data,
+		u8 reg_addr, u8 command, u32 rsp_data, u8 result_code,
+		u8 overrun, int rc)
+{
+	struct sbl_sbus_op_log *log = sbl_sbus_op_log_get(sbl, SBUS_RING(sbus_addr));
+	struct sbl_sbus_op_rec *rec = log->rec + (log->head & (SBL_SBUS_OP_LOG_SIZE - 1));
+	u64 seq = log->head + 1;
+
+	WRITE_ONCE(rec->seq, 0);
+	smp_wmb();
+	rec->ns = ktime_get_ns();
+	rec->req_data = req_data;
+	rec->rsp_data = rsp_data;
+	rec->sbus_addr = sbus_addr;
+	rec->reg_addr = reg_addr;
+	rec->command = command;
+	rec->result_code = result_code;
+	rec->overrun = overrun;
+	rec->rc = rc;
+	smp_wmb();
+	WRITE_ONCE(rec->seq, seq);
+	smp_store_release(&log->head, seq);
+}
+
+/* copy out op number seq if it is still in the log */
+static bool sbl_sbus_op_log_read(struct sbl_sbus_op_log *log, u64 seq,
+		struct sbl_sbus_op_rec *out)
+{
+	struct sbl_sbus_op_rec *rec = log->rec + ((seq - 1) & (SBL_SBUS_OP_LOG_SIZE - 1));
+
+	if (READ_ONCE(rec->seq) != seq)
+		return false;
+	smp_rmb();
+	*out = *rec;
+	smp_rmb();
+
+	return (READ_ONCE(rec->seq) == seq);
+}
+
+static int sbl_sbus_op_rec_sprint(const struct sbl_sbus_op_rec *rec, char *buf, size_t size)
+{
+	char sbus_addr_str[SBL_HALF_MAX_STR_LEN];
+	char reg_addr_str[SBL_HALF_MAX_STR_LEN];
+	char cmd_str[SBL_HALF_MAX_STR_LEN];
+	char rc_str[SBL_HALF_MAX_STR_LEN];
+
+	sbus_addr_to_string(rec->sbus_addr, sbus_addr_str);
+	sbus_reg_addr_to_string(rec->sbus_addr, rec->reg_addr, reg_addr_str);
+	sbus_cmd_to_string(rec->command, cmd_str);
+	sbus_result_code_to_string(rec->result_code, rc_str);
+
+	return snprintf(buf, size,
+			"%llu %llu addr 0x%03x(%s) reg 0x%02x(%s) cmd 0x%02x(%s) data 0x%08x rsp 0x%08x rc 0x%x(%s)%s [%d]",
+			rec->seq, rec->ns, rec->sbus_addr, sbus_addr_str,
+			rec->reg_addr, reg_addr_str, rec->command, cmd_str,
+			rec->req_data, rec->rsp_data, rec->result_code, rc_str,
+			rec->overrun ? " overrun" : "", rec->rc);
+}
+
+/* dump the most recent ops on a ring after a failure */
+static void sbl_sbus_op_log_dump(struct sbl_inst *sbl, u32 sbus_ring)
+{
+	struct sbl_sbus_op_log *log = sbl_sbus_op_log_get(sbl, sbus_ring);
+	struct sbl_sbus_op_rec rec;
+	char line[SBL_MAX_STR_LEN * 2];
+	u64 head = smp_load_acquire(&log->head);
+	u64 seq;
+
+	seq = (head > SBL_SBUS_OP_LOG_DUMP) ? head - SBL_SBUS_OP_LOG_DUMP + 1 : 1;
+	for (; seq <= head; ++seq) {
+		if (!sbl_sbus_op_log_read(log, seq, &rec))
+			continue;
+		sbl_sbus_op_rec_sprint(&rec, line, sizeof(line));
+		SBL_WARN(sbl->dev, "r%d: SBUS_OP: %s", sbus_ring, line);
+	}
+}
+
+#ifdef CONFIG_SYSFS
+/**
+ * sbl_sbus_op_log_sysfs_sprint() - Print the recent sbus ops on a ring
+ * @sbl: A slingshot base link device instance
+ * @ring: sbus ring
+ * @buf: Destination buffer to write the data
+ * @size: Size of data to write
+ *
+ * Decodes the binary op log for the ring, newest op first, until the
+ * buffer is full.
+ *
+ * Return: Number of characters on success, negative error on failure
+ */
+int sbl_sbus_op_log_sysfs_sprint(struct sbl_inst *sbl, int ring, char *buf, size_t size)
+{
+	struct sbl_sbus_op_log *log;
+	struct sbl_sbus_op_rec rec;
+	char line[SBL_MAX_STR_LEN * 2];
+	u64 head;
+	u64 seq;
+	int len;
+	int s = 0;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (ring < 0 || ring >= sbl->switch_info->num_sbus_rings)
+		return -EINVAL;
+
+	if (buf == NULL || size == 0U)
+		return -ENOMEM;
+
+	log = sbl->sbus_op_log + ring;
+	head = smp_load_acquire(&log->head);
+
+	for (seq = head; seq && (head - seq < SBL_SBUS_OP_LOG_SIZE); --seq) {
+		if (!sbl_sbus_op_log_read(log, seq, &rec))
+			continue;
+		len = sbl_sbus_op_rec_sprint(&rec, line, sizeof(line));
+		if (len + 1 >= size - s)
+			break;
+		s += snprintf(buf+s, size-s, "%s\n", line);
+	}
+
+	return s;
+}
+EXPORT_SYMBOL(sbl_sbus_op_log_sysfs_sprint);
+#endif
+
 /**
  * sbl_sbus_wr() - Write to sbus
  * @inst: Generic pointer used by various frameworks
@@ -738,52 +889,119 @@ int sbl_serdes_mem_rmw(void *inst, u32 port_num, u32 serdes,
 	return 0;
 }
 
-int sbl_spico_burst_upload(void *inst, u32 sbus, u32 reg,
-			   size_t fw_size, const u8 *fw_data)
+/* max sbus ops issued in one batch by a burst upload */
+#define SBL_SBUS_BURST_BATCH_MAX 512
+
+/* fill in an sbus op for sbl_sbus_op_batch_aux() */
+static void sbl_sbus_desc_set(struct sbl_sbus_op_desc *desc, u32 sbus_addr,
+			      u8 reg_addr, u8 command, u32 sbus_data)
 {
-	struct sbl_inst *sbl = inst;
-	int err;
-	u32 byte;
+	desc->req_data = sbus_data;
+	desc->data_addr = reg_addr;
+	desc->rx_addr = SBUS_RX_ADDR(sbus_addr);
+	desc->command = SBUS_IFACE_DST_CORE | command;
+}
 
-	if (!fw_data || fw_size <= 0) {
-		SBL_ERR(sbl->dev,
-			"Bad firmware for sbus:0x%02x reg:0x%x fw->size:%zd!",
-			sbus, reg, fw_size);
-		return -EINVAL;
-	}
+/**
+ * sbl_spico_burst_encode() - Pack a firmware image into spico burst words
+ * @fw_size: byte size of firmware image
+ * @fw_data: byte array of size fw_size
+ * @words: SBL_SPICO_BURST_WORDS(fw_size) words to fill in
+ *
+ * Return: number of words filled in
+ */
+int sbl_spico_burst_encode(size_t fw_size, const u8 *fw_data, u32 *words)
+{
+	int num_words = 0;
+	u32 byte;
 
-	SBL_TRACE1(sbl->dev, "sbus:0x%02x reg:0x%x fw->size:%zd", sbus, reg,
-		fw_size);
 	for (byte = 0; byte < fw_size-4; byte += 6) {
-		err = sbl_sbus_wr(sbl, sbus, reg, SPICO_SBR_DATA_BE_012 |
+		words[num_words++] = SPICO_SBR_DATA_BE_012 |
 				       (fw_data[byte+0]<<8 | fw_data[byte+1]) <<
 				       SPICO_SBR_DATA_W0_OFFSET |
 				       (fw_data[byte+2]<<8 | fw_data[byte+3]) <<
 				       SPICO_SBR_DATA_W1_OFFSET |
 				       (fw_data[byte+4]<<8 | fw_data[byte+5]) <<
-				       SPICO_SBR_DATA_W2_OFFSET);
-		if (err)
-			return err;
-
+				       SPICO_SBR_DATA_W2_OFFSET;
 	}
 	if (fw_size - byte == 4) {
-		err = sbl_sbus_wr(sbl, sbus, reg, SPICO_SBR_DATA_BE_01 |
+		words[num_words++] = SPICO_SBR_DATA_BE_01 |
 				       (fw_data[byte+0]<<8 | fw_data[byte+1]) <<
 				       SPICO_SBR_DATA_W0_OFFSET |
 				       (fw_data[byte+2]<<8 | fw_data[byte+3]) <<
-				       SPICO_SBR_DATA_W1_OFFSET);
-		if (err)
-			return err;
-
+				       SPICO_SBR_DATA_W1_OFFSET;
 	} else if (fw_size - byte == 2) {
-		err = sbl_sbus_wr(sbl, sbus, reg, SPICO_SBR_DATA_BE_0 |
+		words[num_words++] = SPICO_SBR_DATA_BE_0 |
 				       (fw_data[byte+0]<<8 | fw_data[byte+1]) <<
-				       SPICO_SBR_DATA_W0_OFFSET);
+				       SPICO_SBR_DATA_W0_OFFSET;
+	}
+
+	return num_words;
+}
+
+int sbl_spico_burst_upload(void *inst, u32 sbus, u32 reg,
+			   int num_words, const u32 *words)
+{
+	struct sbl_inst *sbl = inst;
+	struct sbl_sbus_op_desc *desc;
+	int num_ops = 0;
+	int err = 0;
+	int word;
+
+	if (!words || num_words <= 0) {
+		SBL_ERR(sbl->dev,
+			"Bad firmware for sbus:0x%02x reg:0x%x num_words:%d!",
+			sbus, reg, num_words);
+		return -EINVAL;
+	}
+
+	desc = kmalloc_array(SBL_SBUS_BURST_BATCH_MAX, sizeof(*desc), GFP_KERNEL);
+	if (!desc)
+		return -ENOMEM;
+
+	SBL_TRACE1(sbl->dev, "sbus:0x%02x reg:0x%x num_words:%d", sbus, reg,
+		num_words);
+	for (word = 0; word < num_words; ++word) {
+		sbl_sbus_desc_set(desc + num_ops++, sbus, reg, SBUS_CMD_WRITE,
+				  words[word]);
+		if ((num_ops < SBL_SBUS_BURST_BATCH_MAX) && (word < num_words - 1))
+			continue;
+
+		err = sbl_sbus_op_batch_aux(sbl, SBUS_RING(sbus), desc, num_ops);
 		if (err)
-			return err;
+			break;
+		num_ops = 0;
+
+		/*
+		 * Let more urgent ring users in between chunks. Only a single
+		 * serdes upload can be interleaved - the sbus master or a
+		 * broadcast target may be what they need.
+		 */
+		if (is_cm4_serdes_addr(sbus) &&
+		    (SBUS_RX_ADDR(sbus) != SBUS_BCAST_CM4_SERDES_SPICO) &&
+		    (word < num_words - 1))
+			sbl_sbus_ring_yield(sbl, SBUS_RING(sbus));
+	}
+
+	kfree(desc);
+	return err;
+}
 
+/* check the result_code of an sbus op against its command */
+static bool sbl_sbus_result_valid(u8 command, u8 result_code)
+{
+	switch (command & 0x3) {
+	case SBUS_CMD_RESET:
+		return result_code == SBUS_RC_RESET;
+	case SBUS_CMD_WRITE:
+		return result_code == SBUS_RC_WRITE_COMPLETE;
+	case SBUS_CMD_READ:
+		return result_code == SBUS_RC_READ_COMPLETE;
+	case SBUS_CMD_READ_RESULT:
+		return result_code == SBUS_RC_READ_ALL_COMPLETE;
 	}
-	return 0;
+
+	return false;
 }
 
 int sbl_sbus_op_aux(void *inst, u32 sbus_addr, u8 reg_addr,
@@ -796,10 +1014,10 @@ int sbl_sbus_op_aux(void *inst, u32 sbus_addr, u8 reg_addr,
 	int retry_limit = 5;
 	u32 sbus_ring = SBUS_RING(sbus_addr);
 	u32 rx_addr = SBUS_RX_ADDR(sbus_addr);
-	bool valid_result = false;
 	int sbus_op_timeout_ms = sbl_sbm_get_sbus_op_timeout_ms(sbl);
 	int sbus_op_flags = sbl_sbm_get_sbus_op_flags(sbl);
 	void *accessor = sbl;
+	u64 start_ns;
 
 	if (!sbl->is_hw) {
 		*result = 0;
@@ -815,11 +1033,17 @@ int sbl_sbus_op_aux(void *inst, u32 sbus_addr, u8 reg_addr,
 
 	// Perform SBus operation
 	while (retry_cnt++ < retry_limit) {
+		if (retry_cnt > 1)
+			sbl_sbus_prof_retry(sbl, sbus_ring);
+		start_ns = ktime_get_ns();
 		err = sbl_sbm_sbus_op(accessor, sbus_ring, sbus_data,
 					     reg_addr, rx_addr, command, result,
 					     &result_code, &overrun,
 					     sbus_op_timeout_ms,
 					     sbus_op_flags);
+		sbl_sbus_prof_ops(sbl, sbus_ring, 1, start_ns);
+		sbl_sbus_op_log(sbl, sbus_addr, sbus_data, reg_addr, command,
+				err ? 0 : *result, result_code, overrun, err);
 		if (err) {
 			sbus_msg(sbl, sbus_addr, sbus_data, reg_addr, command,
 				 0, result_code, overrun, sbus_op_timeout_ms,
@@ -827,6 +1051,7 @@ int sbl_sbus_op_aux(void *inst, u32 sbus_addr, u8 reg_addr,
 		}
 		if (err || overrun) {
 			SBL_INFO(sbl->dev, "Resetting SBUS ring %d!", sbus_ring);
+			sbl_sbus_prof_reset(sbl, sbus_ring);
 			err = sbl_sbm_sbus_op_reset(sbl, sbus_ring);
 			if (err) {
 				SBL_WARN(sbl->dev,
@@ -842,59 +1067,112 @@ int sbl_sbus_op_aux(void *inst, u32 sbus_addr, u8 reg_addr,
 	// Validate results
 	if (err || overrun) {
 		SBL_WARN(sbl->dev, "roshms_sbus_op failed!");
+		sbl_sbus_op_log_dump(sbl, sbus_ring);
 		return -EIO;
 	}
-	switch (command & 0x3) {
-	case SBUS_CMD_RESET:
-		if (result_code == SBUS_RC_RESET)
-			valid_result = true;
-
-		break;
-	case SBUS_CMD_WRITE:
-		if (result_code == SBUS_RC_WRITE_COMPLETE)
-			valid_result = true;
 
-		break;
-	case SBUS_CMD_READ:
-		if (result_code == SBUS_RC_READ_COMPLETE)
-			valid_result = true;
-
-		break;
-	case SBUS_CMD_READ_RESULT:
-		if (result_code == SBUS_RC_READ_ALL_COMPLETE)
-			valid_result = true;
-
-		break;
-	}
-
-	if (!valid_result) {
+	if (!sbl_sbus_result_valid(command, result_code)) {
 		SBL_WARN(sbl->dev, "Unexpected result code (%d) 0x%x!",
 				result_code, command);
 		sbus_msg(sbl, sbus_addr, sbus_data, reg_addr, command,
 				*result, result_code, overrun, sbus_op_timeout_ms,
 				sbus_op_flags, err, LEVEL_WARN);
+		sbl_sbus_op_log_dump(sbl, sbus_ring);
 		return -ENOMSG;
 	}
-	sbus_msg(sbl, sbus_addr, sbus_data, reg_addr, command,
-			*result, result_code, overrun, sbus_op_timeout_ms,
-			sbus_op_flags, err, LEVEL_DBG);
 
 	return 0;
 }
+
 /**
- * sbl_sbm_spico_int() - spico intilization
- * @inst: Generic pointer used by various framework
- * @sbus_addr: address describing a serdes ring and rxaddr
- * @code: interrupt command
- * @data: interrupt data
- * @result: location to store result of interrupt
+ * sbl_sbus_op_batch_aux() - Issue a batch of sbus ops on one ring
+ * @inst: Generic pointer used by various frameworks
+ * @sbus_ring: target sbus ring
+ * @desc: ops to issue, rsp_data is returned in each (for reads)
+ * @num_ops: number of ops in desc
  *
- * Write an interrupt request to a target SBM Spico
+ * Runs the ops through the optional sbl_sbus_op_batch operation and
+ * checks each result_code against its command. An op the batch did not
+ * complete is issued on its own through sbl_sbus_op_aux(), which resets
+ * and retries the ring, before batching resumes with the next op. With
+ * no batch operation every op is issued on its own.
+ *
+ * Context: Process context, sbus ring mutex held
  *
  * Return: 0 on success, negative error code on failure
  */
-int sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
-		      u32 *result)
+int sbl_sbus_op_batch_aux(void *inst, u32 sbus_ring,
+			  struct sbl_sbus_op_desc *desc, int num_ops)
+{
+	struct sbl_inst *sbl = inst;
+	int sbus_op_timeout_ms = sbl_sbm_get_sbus_op_timeout_ms(sbl);
+	int sbus_op_flags = sbl_sbm_get_sbus_op_flags(sbl);
+	u64 start_ns;
+	int done;
+	int err;
+	int i = 0;
+
+	if (!sbl->is_hw) {
+		for (i = 0; i < num_ops; ++i)
+			desc[i].rsp_data = 0;
+		return 0;
+	}
+	// Safety check
+	if (!mutex_is_locked(SBUS_RING_MTX(sbl, sbus_ring))) {
+		SBL_WARN(sbl->dev, "%s: Unlocked SBUS ring %d!", __func__, sbus_ring);
+		WARN(1, "%s: Unlocked SBUS ring %d!", __func__, sbus_ring);
+	}
+
+	while (i < num_ops) {
+		if (sbl_sbm_has_sbus_op_batch(sbl)) {
+			start_ns = ktime_get_ns();
+			done = sbl_sbm_sbus_op_batch(sbl, sbus_ring, desc + i,
+						     num_ops - i, sbus_op_timeout_ms,
+						     sbus_op_flags);
+			if (done < 0) {
+				SBL_WARN(sbl->dev, "r%d: sbus op batch failed [%d]",
+					 sbus_ring, done);
+				done = 0;
+			}
+			done = min_t(int, done, num_ops - i);
+			sbl_sbus_prof_ops(sbl, sbus_ring, done, start_ns);
+
+			for (done += i; i < done; ++i) {
+				sbl_sbus_op_log(sbl, SBUS_ADDR(sbus_ring, desc[i].rx_addr),
+						desc[i].req_data, desc[i].data_addr,
+						desc[i].command, desc[i].rsp_data,
+						desc[i].result_code, desc[i].overrun, 0);
+				if (sbl_sbus_result_valid(desc[i].command, desc[i].result_code))
+					continue;
+				SBL_WARN(sbl->dev, "Unexpected result code (%d) 0x%x!",
+					 desc[i].result_code, desc[i].command);
+				sbus_msg(sbl, SBUS_ADDR(sbus_ring, desc[i].rx_addr),
+					 desc[i].req_data, desc[i].data_addr,
+					 desc[i].command, desc[i].rsp_data,
+					 desc[i].result_code, desc[i].overrun,
+					 sbus_op_timeout_ms, sbus_op_flags, 0,
+					 LEVEL_WARN);
+				sbl_sbus_op_log_dump(sbl, sbus_ring);
+				return -ENOMSG;
+			}
+			if (i == num_ops)
+				break;
+		}
+
+		err = sbl_sbus_op_aux(sbl, SBUS_ADDR(sbus_ring, desc[i].rx_addr),
+				      desc[i].data_addr, desc[i].command,
+				      desc[i].req_data, &desc[i].rsp_data);
+		if (err)
+			return err;
+		++i;
+	}
+
+	return 0;
+}
+
+/* issue an sbm spico interrupt, profiled by sbl_sbm_spico_int() */
+static int __sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
+			       u32 *result)
 {
 	struct sbl_inst *sbl = inst;
 	int err;
@@ -905,6 +1183,7 @@ int sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
 	int sbus_int_poll_interval = sbl_sbm_get_sbus_int_poll_interval(sbl);
 	unsigned long last_jiffy;
 	u32 sbus_ring = SBUS_RING(sbus_addr);
+	struct sbl_sbus_op_desc desc[2];
 
 	if (!sbl->is_hw) {
 		*result = 0;
@@ -922,21 +1201,22 @@ int sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
 	intr_in = ((data & SBMS_INTERRUPT_DATA_MASK)<<SBMS_INTERRUPT_DATA_OFFSET) |
 		((code & SBMS_INTERRUPT_CODE_MASK)<<SBMS_INTERRUPT_CODE_OFFSET);
 
-	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_DMEM_IN, intr_in);
-	if (err)
-		return err;
-
-	err = sbl_sbus_rd(sbl, sbus_addr, SPICO_SBR_ADDR_INTR, &intr_out);
-	if (err)
-		return err;
-
-	intr_out |= SBMS_INTERRUPT_STATUS_OK;
-	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_INTR, intr_out);
+	//  (data write and intr read, then the intr pulse, as two batches)
+	sbl_sbus_desc_set(desc + 0, sbus_addr, SPICO_SBR_ADDR_DMEM_IN,
+			  SBUS_CMD_WRITE, intr_in);
+	sbl_sbus_desc_set(desc + 1, sbus_addr, SPICO_SBR_ADDR_INTR,
+			  SBUS_CMD_READ, 0);
+	err = sbl_sbus_op_batch_aux(sbl, sbus_ring, desc, 2);
 	if (err)
 		return err;
 
+	intr_out = desc[1].rsp_data | SBMS_INTERRUPT_STATUS_OK;
+	sbl_sbus_desc_set(desc + 0, sbus_addr, SPICO_SBR_ADDR_INTR,
+			  SBUS_CMD_WRITE, intr_out);
 	intr_out ^= SBMS_INTERRUPT_STATUS_OK;
-	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_INTR, intr_out);
+	sbl_sbus_desc_set(desc + 1, sbus_addr, SPICO_SBR_ADDR_INTR,
+			  SBUS_CMD_WRITE, intr_out);
+	err = sbl_sbus_op_batch_aux(sbl, sbus_ring, desc, 2);
 	if (err)
 		return err;
 
@@ -987,6 +1267,32 @@ int sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
 		sbus_addr, code, intr_str, data, *result);
 	return 0;
 }
+
+/**
+ * sbl_sbm_spico_int() - spico intilization
+ * @inst: Generic pointer used by various framework
+ * @sbus_addr: address describing a serdes ring and rxaddr
+ * @code: interrupt command
+ * @data: interrupt data
+ * @result: location to store result of interrupt
+ *
+ * Write an interrupt request to a target SBM Spico
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_sbm_spico_int(void *inst, u32 sbus_addr, int code, int data,
+		      u32 *result)
+{
+	struct sbl_inst *sbl = inst;
+	u64 start_ns = ktime_get_ns();
+	int err;
+
+	err = __sbl_sbm_spico_int(sbl, sbus_addr, code, data, result);
+	if (sbl->is_hw)
+		sbl_spico_prof_sbm(sbl, code, start_ns, err);
+
+	return err;
+}
 EXPORT_SYMBOL(sbl_sbm_spico_int);
 
 /* Returns a SBUS master address based on a ring number */
@@ -1040,23 +1346,9 @@ int sbl_serdes_spico_int2(void *inst, u32 sbus_addr,
 				    result_action);
 }
 
-/**
- * sbl_serdes_spico_int() - serdes spico initilization
- * @inst: Generic pointer used by various frameworks
- * @port_num: port number
- * @serdes: address list describing SerDes lanes
- * @code: interrupt command
- * @data: interrupt data
- * @result: pointer to store result in
- * @result_action: ignore the interrupt result, store it to the result
- *                 pointer, or validate it matches code
- *
- * Write an interrupt request to a set of SerDes Spicos
- *
- * Return: 0 if all results are the same, else -1
- */
-int sbl_serdes_spico_int(void *inst, u32 port_num, u32 serdes,
-			  int code, int data, u16 *result, u8 result_action)
+/* issue a serdes spico interrupt, profiled by sbl_serdes_spico_int() */
+static int __sbl_serdes_spico_int(void *inst, u32 port_num, u32 serdes,
+				  int code, int data, u16 *result, u8 result_action)
 {
 	struct sbl_inst *sbl = inst;
 	int err;
@@ -1110,4 +1402,134 @@ int sbl_serdes_spico_int(void *inst, u32 port_num, u32 serdes,
 
 	return 0;
 }
+
+/**
+ * sbl_serdes_spico_int() - serdes spico initilization
+ * @inst: Generic pointer used by various frameworks
+ * @port_num: port number
+ * @serdes: address list describing SerDes lanes
+ * @code: interrupt command
+ * @data: interrupt data
+ * @result: pointer to store result in
+ * @result_action: ignore the interrupt result, store it to the result
+ *                 pointer, or validate it matches code
+ *
+ * Write an interrupt request to a set of SerDes Spicos
+ *
+ * Return: 0 if all results are the same, else -1
+ */
+int sbl_serdes_spico_int(void *inst, u32 port_num, u32 serdes,
+			  int code, int data, u16 *result, u8 result_action)
+{
+	struct sbl_inst *sbl = inst;
+	u64 start_ns = ktime_get_ns();
+	int err;
+
+	err = __sbl_serdes_spico_int(sbl, port_num, serdes, code, data,
+				     result, result_action);
+	if (sbl->is_hw) {
+		sbl_spico_prof_serdes(sbl, port_num, code, start_ns, err, 1);
+		sbl_hal_shadow_update(sbl, port_num, serdes, code, data, err,
+				      (result_action == SPICO_INT_RETURN_RESULT) ? result : NULL);
+	}
+
+	return err;
+}
 EXPORT_SYMBOL(sbl_serdes_spico_int);
+
+/* issue a serdes spico interrupt on several lanes, profiled by sbl_serdes_spico_int_lanes() */
+static int __sbl_serdes_spico_int_lanes(void *inst, u32 port_num, u32 lane_mask,
+					int code, int data, u16 *results, u8 result_action)
+{
+	struct sbl_inst *sbl = inst;
+	u16 results_out[SBL_SERDES_LANES_PER_PORT];
+	unsigned long lanes = lane_mask;
+	char intr_str[SBL_MAX_STR_LEN];
+	u32 sbus_addr;
+	int serdes;
+	int err;
+
+	if ((result_action == SPICO_INT_RETURN_RESULT) && (results == NULL)) {
+		SBL_ERR(sbl->dev, "results pointer was NULL!");
+		return -1;
+	}
+	if (result_action != SPICO_INT_RETURN_RESULT)
+		results = results_out;
+
+	if (!sbl->is_hw) {
+		for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT)
+			results[serdes] = code;
+		return 0;
+	}
+
+	sbl_sbus_addr_get(&sbus_addr);
+	spico_interrupt_to_string(sbus_addr, code, intr_str);
+
+	err = sbl_sbm_pml_serdes_op_lanes(sbl, port_num, lane_mask, code, data,
+					  results,
+					  sbl_sbm_get_serdes_op_timeout_ms(sbl),
+					  sbl_sbm_get_serdes_op_flags(sbl));
+	if (err) {
+		SBL_ERR(sbl->dev,
+				"SERDES_INT: p%d lanes 0x%x sbl_serdes_op failed! (rc:%d) int:0x%02x(%s) data:0x%04x",
+				port_num, lane_mask, err, code, intr_str, data);
+		return err;
+	}
+
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		SBL_TRACE1(sbl->dev,
+				"SERDES_INT: p%ds%d int:0x%02x(%s) data:0x%04x -> 0x%04x",
+				port_num, serdes, code, intr_str, data, results[serdes]);
+
+		if ((result_action == SPICO_INT_VALIDATE_RESULT) &&
+		    ((results[serdes] & SPICO_INT_RESULT_CODE_MASK) != code)) {
+			SBL_ERR(sbl->dev,
+				"SERDES_INT: p%ds%d int:0x%02x(%s) data:0x%04x -> 0x%04x Unexpected result! Expected 0x%04x!",
+				port_num, serdes, code, intr_str, data,
+				results[serdes] & SPICO_INT_RESULT_CODE_MASK, code);
+			return -EBADE;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * sbl_serdes_spico_int_lanes() - serdes spico interrupt on several lanes
+ * @inst: Generic pointer used by various frameworks
+ * @port_num: port number
+ * @lane_mask: serdes lanes to interrupt
+ * @code: interrupt command
+ * @data: interrupt data
+ * @results: result for each lane, indexed by serdes
+ * @result_action: ignore the interrupt results, store them to the results
+ *                 array, or validate they match code
+ *
+ * Write the same interrupt request to each SerDes Spico in lane_mask,
+ * back to back.
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_spico_int_lanes(void *inst, u32 port_num, u32 lane_mask,
+			       int code, int data, u16 *results, u8 result_action)
+{
+	struct sbl_inst *sbl = inst;
+	u64 start_ns = ktime_get_ns();
+	unsigned long lanes = lane_mask;
+	int serdes;
+	int err;
+
+	err = __sbl_serdes_spico_int_lanes(sbl, port_num, lane_mask, code, data,
+					   results, result_action);
+	if (sbl->is_hw) {
+		sbl_spico_prof_serdes(sbl, port_num, code, start_ns, err,
+				      hweight32(lane_mask));
+		for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT)
+			sbl_hal_shadow_update(sbl, port_num, serdes, code, data, err,
+					      (result_action == SPICO_INT_RETURN_RESULT) ?
+					      results + serdes : NULL);
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(sbl_serdes_spico_int_lanes);
@@ -101,17 +101,48 @@ int sbl_sbus_op_aux(void *sbl, u32 sbus_addr, u8 reg_addr,
 		    u8 command, u32 sbus_data, u32 *result);
 
 /**
- * @brief upload rom to target sbus address
+ * @brief Issue a batch of SBus ops on one ring and check each result_code
+ *	 against its command
+ *
+ * Uses the optional sbl_sbus_op_batch operation when it is provided and
+ * falls back to single ops (with their ring reset and retry) for any op
+ * the batch did not complete, or for all ops when there is no batch op.
  *
  * @param sbus_ring target sbus ring
- * @param reg_addr target sbus register address
+ * @param desc ops to issue, rsp_data is returned in each (for reads)
+ * @param num_ops number of ops in desc
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int sbl_sbus_op_batch_aux(void *sbl, u32 sbus_ring,
+			  struct sbl_sbus_op_desc *desc, int num_ops);
+
+/* number of spico burst words needed for a firmware image */
+#define SBL_SPICO_BURST_WORDS(fw_size) DIV_ROUND_UP(fw_size, 6)
+
+/**
+ * @brief pack a firmware image into spico burst words
+ *
  * @param fw_size byte size of firmware image
  * @param fw_data byte array of size fw_size
+ * @param words SBL_SPICO_BURST_WORDS(fw_size) words to fill in
+ *
+ * @return number of words filled in
+ */
+int sbl_spico_burst_encode(size_t fw_size, const u8 *fw_data, u32 *words);
+
+/**
+ * @brief upload rom to target sbus address
+ *
+ * @param sbus_ring target sbus ring
+ * @param reg_addr target sbus register address
+ * @param num_words number of burst words
+ * @param words burst words from sbl_spico_burst_encode()
  *
  * @return 0 on success, -1 on failure
  */
 int sbl_spico_burst_upload(void *sbl, u32 sbus, u32 reg,
-			   size_t fw_size, const u8 *fw_data);
+			   int num_words, const u32 *words);
 
 /**
  * @brief Write an interrupt request to a target SBM Spico
@@ -140,6 +171,22 @@ int sbl_sbm_spico_int(void *sbl, u32 sbus_addr, int code,
  */
 int sbl_serdes_spico_int(void *sbl, u32 port, u32 serdes,
 			 int code, int data, u16 *result, u8 result_action);
+
+/**
+ * @brief Write the same interrupt request to several SerDes Spicos of a port
+ *
+ * @param port port number
+ * @param lane_mask serdes lanes to interrupt
+ * @param code interrupt command
+ * @param data interrupt data
+ * @param results result for each lane, indexed by serdes
+ * @param result_action ignore the interrupt results, store them to the
+ *		      results array, or validate they match code
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int sbl_serdes_spico_int_lanes(void *sbl, u32 port, u32 lane_mask,
+			       int code, int data, u16 *results, u8 result_action);
 /**
  * @param sbus_addr address describing a serdes ring and rxaddr
  */
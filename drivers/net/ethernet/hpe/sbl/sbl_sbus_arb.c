@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/bitops.h>
+#include <linux/completion.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include "sbl_internal.h"
+
+/*
+ * SBus ring arbiter
+ *
+ * Decides who gets an sbus ring next. Waiters queue FIFO in one of the
+ * sbl_sbus_prio classes and, when the ring is released, it is handed
+ * directly to the oldest waiter of the most urgent class. The ring mutex
+ * is still taken by the winner, so the mutex_is_locked() safety checks
+ * on the sbus op paths keep working, but it is never contended.
+ *
+ * A long holder (firmware upload) calls sbl_sbus_ring_yield() between
+ * chunks of work and gives the ring up if a more urgent class is waiting.
+ */
+
+struct sbl_sbus_arb_waiter {
+	struct list_head list;
+	struct completion granted;
+};
+
+static struct sbl_sbus_arb *sbl_sbus_arb_get(struct sbl_inst *sbl, int sbus_ring)
+{
+	/* an out of range ring uses the ring 0 arbiter */
+	if (sbus_ring < 0 || sbus_ring >= sbl->switch_info->num_sbus_rings)
+		sbus_ring = 0;
+
+	return sbl->sbus_arb + sbus_ring;
+}
+
+/* setup the arbiter for a ring */
+void sbl_sbus_arb_init(struct sbl_sbus_arb *arb)
+{
+	int prio;
+
+	spin_lock_init(&arb->lock);
+	arb->busy = false;
+	arb->prio = SBL_SBUS_PRIO_NUM;
+	arb->waiting = 0;
+	for (prio = 0; prio < SBL_SBUS_PRIO_NUM; ++prio)
+		INIT_LIST_HEAD(&arb->waiters[prio]);
+}
+
+/**
+ * sbl_sbus_arb_acquire() - Wait for an sbus ring to be granted
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ * @prio: priority class of the caller
+ *
+ * Context: Process context. May sleep.
+ *
+ * Return: true if the caller had to wait
+ */
+bool sbl_sbus_arb_acquire(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio)
+{
+	struct sbl_sbus_arb *arb = sbl_sbus_arb_get(sbl, sbus_ring);
+	struct sbl_sbus_arb_waiter waiter;
+
+	spin_lock(&arb->lock);
+
+	if (!arb->busy && !arb->waiting) {
+		arb->busy = true;
+		arb->prio = prio;
+		spin_unlock(&arb->lock);
+		return false;
+	}
+
+	init_completion(&waiter.granted);
+	list_add_tail(&waiter.list, &arb->waiters[prio]);
+	__set_bit(prio, &arb->waiting);
+
+	spin_unlock(&arb->lock);
+
+	/* the releaser sets busy and prio for us before granting */
+	wait_for_completion(&waiter.granted);
+
+	return true;
+}
+
+/**
+ * sbl_sbus_arb_tryacquire() - Take an sbus ring if it is idle
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ * @prio: priority class of the caller
+ *
+ * Fails if the ring is held or anyone is already queued for it.
+ *
+ * Return: true if the ring was granted
+ */
+bool sbl_sbus_arb_tryacquire(struct sbl_inst *sbl, int sbus_ring, enum sbl_sbus_prio prio)
+{
+	struct sbl_sbus_arb *arb = sbl_sbus_arb_get(sbl, sbus_ring);
+	bool granted = false;
+
+	spin_lock(&arb->lock);
+	if (!arb->busy && !arb->waiting) {
+		arb->busy = true;
+		arb->prio = prio;
+		granted = true;
+	}
+	spin_unlock(&arb->lock);
+
+	return granted;
+}
+
+/**
+ * sbl_sbus_arb_release() - Hand an sbus ring to the next waiter
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ *
+ * Context: Process context
+ */
+void sbl_sbus_arb_release(struct sbl_inst *sbl, int sbus_ring)
+{
+	struct sbl_sbus_arb *arb = sbl_sbus_arb_get(sbl, sbus_ring);
+	struct sbl_sbus_arb_waiter *waiter;
+	int prio;
+
+	spin_lock(&arb->lock);
+
+	if (!arb->waiting) {
+		arb->busy = false;
+		arb->prio = SBL_SBUS_PRIO_NUM;
+		spin_unlock(&arb->lock);
+		return;
+	}
+
+	prio = __ffs(arb->waiting);
+	waiter = list_first_entry(&arb->waiters[prio], struct sbl_sbus_arb_waiter, list);
+	list_del(&waiter->list);
+	if (list_empty(&arb->waiters[prio]))
+		__clear_bit(prio, &arb->waiting);
+	arb->prio = prio;
+	complete(&waiter->granted);
+
+	spin_unlock(&arb->lock);
+}
+
+/**
+ * sbl_sbus_arb_preempted() - Check if a more urgent class wants the ring
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ *
+ * Context: sbus ring held
+ *
+ * Return: true if the holder should yield the ring
+ */
+bool sbl_sbus_arb_preempted(struct sbl_inst *sbl, int sbus_ring)
+{
+	struct sbl_sbus_arb *arb = sbl_sbus_arb_get(sbl, sbus_ring);
+
+	return READ_ONCE(arb->waiting) & (BIT(arb->prio) - 1);
+}
+
+/* priority class of the current ring holder */
+enum sbl_sbus_prio sbl_sbus_arb_prio(struct sbl_inst *sbl, int sbus_ring)
+{
+	return sbl_sbus_arb_get(sbl, sbus_ring)->prio;
+}
@@ -0,0 +1,336 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/sort.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include "sbl_internal.h"
+
+/*
+ * SBus ring profiler
+ *
+ * All sbus ring critical sections go through the lock helpers below,
+ * which time the wait for the ring mutex and how long it is held, and
+ * charge both to the call site that took it. Ops, retries and ring
+ * resets are counted from the sbus op path. Who gets the ring next is
+ * left to the ring arbiter (sbl_sbus_arb.c). The profile is only ever
+ * written with the ring mutex held, so it needs no lock of its own;
+ * readers just take a (possibly slightly torn) snapshot.
+ *
+ * Histograms are log2 us buckets. Only the SBL_SBUS_PROF_HOLDERS call
+ * sites with the most hold time are kept - a new site replaces the
+ * one with the least.
+ */
+
+static struct sbl_sbus_prof *sbl_sbus_prof_get(struct sbl_inst *sbl, int sbus_ring)
+{
+	/* an out of range ring is profiled as ring 0 */
+	if (sbus_ring < 0 || sbus_ring >= sbl->switch_info->num_sbus_rings)
+		sbus_ring = 0;
+
+	return sbl->sbus_prof + sbus_ring;
+}
+
+static int sbl_sbus_prof_bucket(u64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	return us ? min_t(int, ilog2(us), SBL_SBUS_PROF_HIST_SIZE - 1) : 0;
+}
+
+static void sbl_sbus_prof_holder_add(struct sbl_sbus_prof *prof, unsigned long ip,
+		u64 wait_ns, u64 hold_ns)
+{
+	struct sbl_sbus_prof_holder *holder = NULL;
+	struct sbl_sbus_prof_holder *least = prof->holders;
+	int i;
+
+	for (i = 0; i < SBL_SBUS_PROF_HOLDERS; ++i) {
+		if (prof->holders[i].ip == ip) {
+			holder = prof->holders + i;
+			break;
+		}
+		if (prof->holders[i].hold_ns < least->hold_ns)
+			least = prof->holders + i;
+	}
+
+	if (!holder) {
+		holder = least;
+		memset(holder, 0, sizeof(*holder));
+		holder->ip = ip;
+	}
+
+	holder->count++;
+	holder->wait_ns += wait_ns;
+	holder->hold_ns += hold_ns;
+}
+
+static void sbl_sbus_prof_acquired(struct sbl_inst *sbl, int sbus_ring,
+		unsigned long ip, u64 start_ns, bool contended)
+{
+	struct sbl_sbus_prof *prof = sbl_sbus_prof_get(sbl, sbus_ring);
+	u64 now = ktime_get_ns();
+	u64 wait_ns = now - start_ns;
+
+	prof->lock_count++;
+	if (contended)
+		prof->contended++;
+	prof->wait_hist[sbl_sbus_prof_bucket(wait_ns)]++;
+	prof->wait_max_ns = max(prof->wait_max_ns, wait_ns);
+
+	prof->hold_ip = ip;
+	prof->hold_start_ns = now;
+	prof->hold_wait_ns = wait_ns;
+}
+
+static void __sbl_sbus_ring_lock(struct sbl_inst *sbl, int sbus_ring,
+		enum sbl_sbus_prio prio, unsigned long ip)
+{
+	u64 start_ns = ktime_get_ns();
+	bool contended;
+
+	contended = sbl_sbus_arb_acquire(sbl, sbus_ring, prio);
+	mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_prof_acquired(sbl, sbus_ring, ip, start_ns, contended);
+}
+
+static void __sbl_sbus_ring_unlock(struct sbl_inst *sbl, int sbus_ring)
+{
+	struct sbl_sbus_prof *prof = sbl_sbus_prof_get(sbl, sbus_ring);
+	u64 hold_ns = ktime_get_ns() - prof->hold_start_ns;
+
+	prof->hold_hist[sbl_sbus_prof_bucket(hold_ns)]++;
+	prof->hold_max_ns = max(prof->hold_max_ns, hold_ns);
+	sbl_sbus_prof_holder_add(prof, prof->hold_ip, prof->hold_wait_ns, hold_ns);
+
+	mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_arb_release(sbl, sbus_ring);
+}
+
+/**
+ * sbl_sbus_ring_lock() - Enter an sbus ring critical section
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ * @prio: priority class of the caller
+ *
+ * Context: Process context. May sleep.
+ */
+noinline void sbl_sbus_ring_lock(struct sbl_inst *sbl, int sbus_ring,
+		enum sbl_sbus_prio prio)
+{
+	__sbl_sbus_ring_lock(sbl, sbus_ring, prio, _RET_IP_);
+}
+
+/**
+ * sbl_sbus_ring_trylock() - Enter an sbus ring critical section if free
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ * @prio: priority class of the caller
+ *
+ * Context: Process context
+ *
+ * Return: true if the ring was locked
+ */
+noinline bool sbl_sbus_ring_trylock(struct sbl_inst *sbl, int sbus_ring,
+		enum sbl_sbus_prio prio)
+{
+	if (!sbl_sbus_arb_tryacquire(sbl, sbus_ring, prio))
+		return false;
+
+	if (!mutex_trylock(SBUS_RING_MTX(sbl, sbus_ring))) {
+		sbl_sbus_arb_release(sbl, sbus_ring);
+		return false;
+	}
+
+	sbl_sbus_prof_acquired(sbl, sbus_ring, _RET_IP_, ktime_get_ns(), false);
+
+	return true;
+}
+
+/**
+ * sbl_sbus_ring_unlock() - Leave an sbus ring critical section
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ *
+ * Context: Process context, sbus ring held
+ */
+void sbl_sbus_ring_unlock(struct sbl_inst *sbl, int sbus_ring)
+{
+	__sbl_sbus_ring_unlock(sbl, sbus_ring);
+}
+
+/**
+ * sbl_sbus_ring_yield() - Preemption point for long sbus ring holders
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ *
+ * If a more urgent class is waiting for the ring, release it and queue
+ * again behind it in the holder's own class. The caller must leave the
+ * ring in a state other users can work with.
+ *
+ * Context: Process context, sbus ring held. May sleep.
+ */
+void sbl_sbus_ring_yield(struct sbl_inst *sbl, int sbus_ring)
+{
+	struct sbl_sbus_prof *prof = sbl_sbus_prof_get(sbl, sbus_ring);
+	enum sbl_sbus_prio prio;
+	unsigned long ip;
+
+	if (!sbl_sbus_arb_preempted(sbl, sbus_ring))
+		return;
+
+	prio = sbl_sbus_arb_prio(sbl, sbus_ring);
+	ip = prof->hold_ip;
+
+	__sbl_sbus_ring_unlock(sbl, sbus_ring);
+	__sbl_sbus_ring_lock(sbl, sbus_ring, prio, ip);
+
+	prof->yields++;
+}
+
+/**
+ * sbl_sbus_prof_ops() - Record completed sbus ops
+ * @sbl: A slingshot base link device instance
+ * @sbus_ring: sbus ring
+ * @num_ops: number of ops completed
+ * @start_ns: ktime the ops were issued
+ *
+ * A batch is recorded as num_ops ops of its average latency.
+ *
+ * Context: Process context, sbus ring mutex held
+ */
+void sbl_sbus_prof_ops(struct sbl_inst *sbl, int sbus_ring, int num_ops, u64 start_ns)
+{
+	struct sbl_sbus_prof *prof = sbl_sbus_prof_get(sbl, sbus_ring);
+	u64 now = ktime_get_ns();
+	u64 op_ns;
+
+	if (num_ops <= 0)
+		return;
+
+	op_ns = div_u64(now - start_ns, num_ops);
+	prof->op_count += num_ops;
+	prof->op_hist[sbl_sbus_prof_bucket(op_ns)] += num_ops;
+	prof->op_max_ns = max(prof->op_max_ns, op_ns);
+
+	/* close the ops per second window */
+	if (now - prof->sec_start_ns >= NSEC_PER_SEC) {
+		prof->ops_per_sec = (now - prof->sec_start_ns < 2 * NSEC_PER_SEC) ?
+			prof->sec_ops : 0;
+		prof->ops_per_sec_max = max(prof->ops_per_sec_max, prof->ops_per_sec);
+		prof->sec_start_ns = now;
+		prof->sec_ops = 0;
+	}
+	prof->sec_ops += num_ops;
+}
+
+/* an sbus op was retried */
+void sbl_sbus_prof_retry(struct sbl_inst *sbl, int sbus_ring)
+{
+	sbl_sbus_prof_get(sbl, sbus_ring)->retry_count++;
+}
+
+/* an sbus ring was reset */
+void sbl_sbus_prof_reset(struct sbl_inst *sbl, int sbus_ring)
+{
+	sbl_sbus_prof_get(sbl, sbus_ring)->reset_count++;
+}
+
+#ifdef CONFIG_SYSFS
+static int sbl_sbus_prof_holder_cmp(const void *a, const void *b)
+{
+	const struct sbl_sbus_prof_holder *ha = a;
+	const struct sbl_sbus_prof_holder *hb = b;
+
+	if (ha->hold_ns == hb->hold_ns)
+		return 0;
+
+	return (ha->hold_ns < hb->hold_ns) ? 1 : -1;
+}
+
+static int sbl_sbus_prof_hist_sprint(const char *name, const u64 *hist, u64 max_ns,
+		char *buf, size_t size)
+{
+	int bucket;
+	int s = 0;
+
+	s += scnprintf(buf+s, size-s, "%s: max %llu, hist", name,
+			div_u64(max_ns, NSEC_PER_USEC));
+	for (bucket = 0; bucket < SBL_SBUS_PROF_HIST_SIZE; ++bucket) {
+		if (hist[bucket])
+			s += scnprintf(buf+s, size-s, " %lu:%llu", BIT(bucket), hist[bucket]);
+	}
+	s += scnprintf(buf+s, size-s, "\n");
+
+	return s;
+}
+
+/**
+ * sbl_sbus_prof_sysfs_sprint() - Print the sbus lock and op profile of a ring
+ * @sbl: A slingshot base link device instance
+ * @ring: sbus ring
+ * @buf: Destination buffer to write the data
+ * @size: Size of data to write
+ *
+ * Lock and op counts, wait/hold/op latency histograms (us), ops per
+ * second and the call sites holding the ring longest.
+ *
+ * Return: Number of characters on success, negative error on failure
+ */
+int sbl_sbus_prof_sysfs_sprint(struct sbl_inst *sbl, int ring, char *buf, size_t size)
+{
+	struct sbl_sbus_prof_holder holders[SBL_SBUS_PROF_HOLDERS];
+	struct sbl_sbus_prof *prof;
+	int i;
+	int s = 0;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (ring < 0 || ring >= sbl->switch_info->num_sbus_rings)
+		return -EINVAL;
+
+	if (buf == NULL || size == 0U)
+		return -ENOMEM;
+
+	prof = sbl->sbus_prof + ring;
+
+	s += scnprintf(buf+s, size-s, "locks %llu, contended %llu, yields %llu\n",
+			prof->lock_count, prof->contended, prof->yields);
+	s += sbl_sbus_prof_hist_sprint("wait", prof->wait_hist, prof->wait_max_ns,
+			buf+s, size-s);
+	s += sbl_sbus_prof_hist_sprint("hold", prof->hold_hist, prof->hold_max_ns,
+			buf+s, size-s);
+	s += scnprintf(buf+s, size-s, "ops %llu, retries %llu, resets %llu, ops/s %u, max %u\n",
+			prof->op_count, prof->retry_count, prof->reset_count,
+			prof->ops_per_sec, prof->ops_per_sec_max);
+	s += sbl_sbus_prof_hist_sprint("op", prof->op_hist, prof->op_max_ns,
+			buf+s, size-s);
+
+	memcpy(holders, prof->holders, sizeof(holders));
+	sort(holders, SBL_SBUS_PROF_HOLDERS, sizeof(holders[0]),
+			sbl_sbus_prof_holder_cmp, NULL);
+
+	for (i = 0; i < SBL_SBUS_PROF_HOLDERS; ++i) {
+		if (!holders[i].count)
+			continue;
+		s += scnprintf(buf+s, size-s, "holder %ps: count %llu, wait %llu, hold %llu\n",
+				(void *)holders[i].ip, holders[i].count,
+				div_u64(holders[i].wait_ns, NSEC_PER_USEC),
+				div_u64(holders[i].hold_ns, NSEC_PER_USEC));
+	}
+
+	return s;
+}
+EXPORT_SYMBOL(sbl_sbus_prof_sysfs_sprint);
+#endif
@@ -6,6 +6,7 @@
 #include <linux/device.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
+#include <linux/rculist.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_kconfig.h>
@@ -67,11 +68,9 @@ out:
 }
 
 /* This delay is to give time for the optical transceivers to lock */
-static int sbl_serdes_optical_lock_delay(struct sbl_inst *sbl, int port_num)
+static int sbl_serdes_optical_lock_delay_begin(struct sbl_inst *sbl, int port_num)
 {
 	struct sbl_link *link = sbl->link + port_num;
-	unsigned long last_jiffy;
-	int err = 0;
 
 	sbl_dev_dbg(sbl->dev, "p%d: optical lock delay", port_num);
 
@@ -81,8 +80,20 @@ static int sbl_serdes_optical_lock_delay(struct sbl_inst *sbl, int port_num)
 	}
 
 	link->optical_delay_active = true;
-	last_jiffy = jiffies + msecs_to_jiffies(link->blattr.aoc.optical_lock_delay);
-	while (time_is_after_jiffies(last_jiffy)) {
+	link->serdes_wait.state = SBL_SERDES_WAIT_OPTICAL_LOCK;
+	link->serdes_wait.last_jiffy = jiffies +
+		msecs_to_jiffies(link->blattr.aoc.optical_lock_delay);
+
+	return 0;
+}
+
+/* returns -EINPROGRESS until the optical lock delay is over */
+static int sbl_serdes_optical_lock_delay(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int err = 0;
+
+	if (time_is_after_jiffies(link->serdes_wait.last_jiffy)) {
 		if (sbl_base_link_start_cancelled(sbl, port_num)) {
 			err = -ECANCELED;
 			goto out;
@@ -91,7 +102,8 @@ static int sbl_serdes_optical_lock_delay(struct sbl_inst *sbl, int port_num)
 			err = -ETIMEDOUT;
 			goto out;
 		}
-		msleep(link->blattr.aoc.optical_lock_interval);
+		return sbl_start_wait(sbl, port_num,
+				link->blattr.aoc.optical_lock_interval);
 	}
 out:
 	link->optical_delay_active = false;
@@ -252,7 +264,14 @@ out_err:
 }
 
 
-int sbl_serdes_start(struct sbl_inst *sbl, int port_num)
+/*
+ * Start the serdes of a port
+ *
+ * The optical lock delay and tuning return -EINPROGRESS rather than
+ * sleeping, and the start carries on from link->serdes_wait when called
+ * again with resume set.
+ */
+int sbl_serdes_start(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link;
 	int err;
@@ -266,45 +285,61 @@ int sbl_serdes_start(struct sbl_inst *sbl, int port_num)
 	if (err)
 		return err;
 
-	sbl_dev_dbg(sbl->dev, "p%d: SerDes start", port_num);
-
 	link = sbl->link + port_num;
 
-	if (link->sstate != SBL_SERDES_STATUS_DOWN) {
-		sbl_dev_err(sbl->dev, "p%d: SerDes start: wrong state (%s)",
-			port_num, sbl_serdes_state_str(link->sstate));
-		/* leave state unchanged */
-		return -EUCLEAN;
-	}
+	if (!resume) {
+		sbl_dev_dbg(sbl->dev, "p%d: SerDes start", port_num);
 
-	/* configure serdes */
-	err = sbl_serdes_config(sbl, port_num, false);
-	if (err) {
-		sbl_dev_err(sbl->dev, "p%d: SerDes start: serdes_config failed [%d]", port_num, err);
-		if (err == -EBADE)
-			link->reload_serdes_fw = true;
-		goto out;
-	}
+		if (link->sstate != SBL_SERDES_STATUS_DOWN) {
+			sbl_dev_err(sbl->dev, "p%d: SerDes start: wrong state (%s)",
+				port_num, sbl_serdes_state_str(link->sstate));
+			/* leave state unchanged */
+			return -EUCLEAN;
+		}
 
-	/* wait a while before starting to tune to let the optics lock if present
-	 * (in local loopback mode however there are never any optics to wait for)
-	 */
-	if (link->blattr.loopback_mode != SBL_LOOPBACK_MODE_LOCAL) {
-		if (link->mattr.media == SBL_LINK_MEDIA_OPTICAL) {
-			err = sbl_serdes_optical_lock_delay(sbl, port_num);
-			if (err)
-				goto out;
+		/* configure serdes */
+		err = sbl_serdes_config(sbl, port_num, false);
+		if (err) {
+			sbl_dev_err(sbl->dev, "p%d: SerDes start: serdes_config failed [%d]", port_num, err);
+			if (err == -EBADE)
+				link->reload_serdes_fw = true;
+			goto out;
+		}
+
+		/* wait a while before starting to tune to let the optics lock if present
+		 * (in local loopback mode however there are never any optics to wait for)
+		 */
+		link->serdes_wait.state = SBL_SERDES_WAIT_NONE;
+		if (link->blattr.loopback_mode != SBL_LOOPBACK_MODE_LOCAL) {
+			if (link->mattr.media == SBL_LINK_MEDIA_OPTICAL) {
+				err = sbl_serdes_optical_lock_delay_begin(sbl, port_num);
+				if (err)
+					goto out;
+			}
 		}
 	}
 
-	/* make sure we have time left for at lease 2 tuning cycles */
-	sbl_start_timeout_ensure_remaining(sbl, port_num,
-			2*(link->blattr.dfe_timeout + link->blattr.dfe_pre_delay));
+	if (link->serdes_wait.state == SBL_SERDES_WAIT_OPTICAL_LOCK) {
+		err = sbl_serdes_optical_lock_delay(sbl, port_num);
+		if (err == -EINPROGRESS)
+			return err;
+		if (err)
+			goto out;
+		resume = false;
+	}
+
+	if (!resume) {
+		/* make sure we have time left for at lease 2 tuning cycles */
+		sbl_start_timeout_ensure_remaining(sbl, port_num,
+				2*(link->blattr.dfe_timeout + link->blattr.dfe_pre_delay));
 
-	/* tune serdes */
-	link->sstate = SBL_SERDES_STATUS_TUNING;
+		/* tune serdes */
+		link->sstate = SBL_SERDES_STATUS_TUNING;
+	}
 
-	err = sbl_serdes_tuning(sbl, port_num);
+	err = sbl_serdes_tuning(sbl, port_num, resume);
+	if (err == -EINPROGRESS)
+		return err;
 	if (err) {
 		switch (err) {
 		case -ECANCELED:
@@ -673,6 +708,7 @@ int sbl_serdes_set_tuning_params(struct sbl_inst *sbl, int port_num,
 
 	mutex_lock(&link->tuning_params_mtx);
 	memcpy(&link->tuning_params, tuning_params, sizeof(struct sbl_tuning_params));
+	link->tp_active_slot = -1;
 	mutex_unlock(&link->tuning_params_mtx);
 
 	sbl_dev_dbg(sbl->dev, "p%d: tp set - received hash0 0x%llx hash1 0x%llx\n",
@@ -688,7 +724,8 @@ EXPORT_SYMBOL(sbl_serdes_set_tuning_params);
  * @sbl: A slingshot base link device instance
  * @port_num: port number
  *
- * Clearing per port tuning parameters
+ * Clearing per port tuning parameters, and any copy remembered for the
+ * same configuration
  *
  * Context: Process, May sleep. Uses mutex_lock
  *
@@ -710,6 +747,7 @@ int sbl_serdes_invalidate_tuning_params(struct sbl_inst *sbl, int port_num)
 	link = sbl->link + port_num;
 
 	mutex_lock(&link->tuning_params_mtx);
+	sbl_tp_history_invalidate(sbl, port_num, false);
 	link->tuning_params.magic = 0;               /* prevent transfer to usr-space */
 	link->tuning_params.tp_state_hash0 = 0;      /* prevent use */
 	link->tuning_params.tp_state_hash1 = 0;      /* prevent use */
@@ -723,7 +761,8 @@ EXPORT_SYMBOL(sbl_serdes_invalidate_tuning_params);
  * sbl_serdes_invalidate_all_tuning_params() - Invalidate all tuning params
  * @sbl: A slingshot base link device instance
  *
- * Clearing all ports tuning parameters
+ * Clearing all ports tuning parameters, including those remembered for
+ * other configurations
  *
  * Return: 0 on success
  */
@@ -731,13 +770,153 @@ int sbl_serdes_invalidate_all_tuning_params(struct sbl_inst *sbl)
 {
 	int i;
 
-	for (i = 0; i < sbl->switch_info->num_ports; ++i)
+	for (i = 0; i < sbl->switch_info->num_ports; ++i) {
 		sbl_serdes_invalidate_tuning_params(sbl, i);
+		mutex_lock(&sbl->link[i].tuning_params_mtx);
+		sbl_tp_history_invalidate(sbl, i, true);
+		mutex_unlock(&sbl->link[i].tuning_params_mtx);
+	}
 
 	return 0;
 }
 EXPORT_SYMBOL(sbl_serdes_invalidate_all_tuning_params);
 
+/**
+ * sbl_serdes_export_tuning_params() - Save all ports tuning params
+ * @sbl: A slingshot base link device instance
+ * @buf: buffer for a struct sbl_tp_store, or NULL to get the size needed
+ * @size: size of buf
+ *
+ * Only ports with valid tuning params are included.
+ *
+ * Context: Process, May sleep. Uses mutex_lock
+ *
+ * Return: size of the store on success, negative error code on failure
+ */
+ssize_t sbl_serdes_export_tuning_params(struct sbl_inst *sbl, void *buf, size_t size)
+{
+	struct sbl_tp_store *store = buf;
+	struct sbl_tp_store_entry *entry;
+	struct sbl_link *link;
+	int num_entries = 0;
+	int port_num;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (!buf)
+		return struct_size(store, entries, sbl->switch_info->num_ports);
+
+	if (size < sizeof(struct sbl_tp_store))
+		return -ENOSPC;
+
+	for (port_num = 0; port_num < sbl->switch_info->num_ports; ++port_num) {
+		link = sbl->link + port_num;
+
+		mutex_lock(&link->tuning_params_mtx);
+		if (link->tuning_params.magic != SBL_TUNING_PARAM_MAGIC) {
+			mutex_unlock(&link->tuning_params_mtx);
+			continue;
+		}
+		if (struct_size(store, entries, num_entries + 1) > size) {
+			mutex_unlock(&link->tuning_params_mtx);
+			return -ENOSPC;
+		}
+		entry = store->entries + num_entries++;
+		entry->port_num = port_num;
+		entry->pad = 0;
+		memcpy(&entry->tp, &link->tuning_params, sizeof(struct sbl_tuning_params));
+		mutex_unlock(&link->tuning_params_mtx);
+	}
+
+	store->magic = SBL_TUNING_PARAM_STORE_MAGIC;
+	store->version = SBL_TUNING_PARAM_STORE_VERSION;
+	store->entry_size = sizeof(struct sbl_tp_store_entry);
+	store->num_entries = num_entries;
+
+	sbl_dev_dbg(sbl->dev, "tp export - %d ports\n", num_entries);
+
+	return struct_size(store, entries, num_entries);
+}
+EXPORT_SYMBOL(sbl_serdes_export_tuning_params);
+
+/**
+ * sbl_serdes_import_tuning_params() - Restore saved tuning params
+ * @sbl: A slingshot base link device instance
+ * @buf: struct sbl_tp_store from sbl_serdes_export_tuning_params()
+ * @size: size of buf
+ *
+ * Nothing is restored unless the whole store is valid. The restored
+ * params are only used by a port whose tp state hash still matches,
+ * just as if they had been saved by the last tune.
+ *
+ * Context: Process, May sleep. Uses mutex_lock
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_import_tuning_params(struct sbl_inst *sbl, const void *buf, size_t size)
+{
+	const struct sbl_tp_store *store = buf;
+	const struct sbl_tp_store_entry *entry;
+	struct sbl_link *link;
+	int err;
+	u32 i;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (!buf || (size < sizeof(struct sbl_tp_store)))
+		return -EINVAL;
+
+	if ((store->magic != SBL_TUNING_PARAM_STORE_MAGIC) ||
+	    (store->version != SBL_TUNING_PARAM_STORE_VERSION) ||
+	    (store->entry_size != sizeof(struct sbl_tp_store_entry))) {
+		sbl_dev_err(sbl->dev, "tp import - bad store (magic 0x%x, version %d, entry size %d)\n",
+			store->magic, store->version, store->entry_size);
+		return -EINVAL;
+	}
+
+	if ((store->num_entries > sbl->switch_info->num_ports) ||
+	    (size != struct_size(store, entries, store->num_entries))) {
+		sbl_dev_err(sbl->dev, "tp import - bad size %zd for %d entries\n",
+			size, store->num_entries);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < store->num_entries; ++i) {
+		entry = store->entries + i;
+		err = sbl_validate_port_num(sbl, entry->port_num);
+		if (err)
+			return err;
+		if ((entry->tp.magic != SBL_TUNING_PARAM_MAGIC) ||
+		    (entry->tp.version != SBL_TUNING_PARAM_VERSION) ||
+		    (!entry->tp.tp_state_hash0 && !entry->tp.tp_state_hash1)) {
+			sbl_dev_err(sbl->dev, "p%d: tp import - invalid params\n",
+				entry->port_num);
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < store->num_entries; ++i) {
+		entry = store->entries + i;
+		link = sbl->link + entry->port_num;
+
+		mutex_lock(&link->tuning_params_mtx);
+		memcpy(&link->tuning_params, &entry->tp, sizeof(struct sbl_tuning_params));
+		link->tp_active_slot = -1;
+		mutex_unlock(&link->tuning_params_mtx);
+
+		sbl_dev_dbg(sbl->dev, "p%d: tp import - hash0 0x%llx hash1 0x%llx\n",
+			entry->port_num, entry->tp.tp_state_hash0, entry->tp.tp_state_hash1);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_serdes_import_tuning_params);
+
 /**
  * sbl_serdes_add_config() - Serdes configuration addition
  * @sbl: A slingshot base link device instance
@@ -789,6 +968,7 @@ int sbl_serdes_add_config(struct sbl_inst *sbl,
 	new_sc->is_default      = is_default;
 	new_sc->tag             = sbl_serdes_get_config_tag();
 	memcpy(&new_sc->vals, vals, sizeof(struct sbl_sc_values));
+	sbl_serdes_config_count_bits(new_sc);
 	INIT_LIST_HEAD(&new_sc->list);
 
 	spin_lock(&sbl->serdes_config_lock);
@@ -807,9 +987,18 @@ int sbl_serdes_add_config(struct sbl_inst *sbl,
 		}
 	}
 
-	/* add the new entry */
-	list_add(&new_sc->list, &sbl->serdes_config_list);
-	sbl_dev_dbg(sbl->dev, "added serdes config, tag %d\n", sc->tag);
+	/*
+	 * add the new entry ahead of any as or less specific ones, so among
+	 * equally specific entries the newest is found first
+	 */
+	list_for_each_entry(sc, &sbl->serdes_config_list, list) {
+		if (!sbl_serdes_config_more_specific(sc, new_sc))
+			break;
+	}
+	write_seqcount_begin(&sbl->serdes_config_seq);
+	list_add_tail_rcu(&new_sc->list, &sc->list);
+	write_seqcount_end(&sbl->serdes_config_seq);
+	sbl_dev_dbg(sbl->dev, "added serdes config, tag %d\n", new_sc->tag);
 	spin_unlock(&sbl->serdes_config_lock);
 	return 0;
 }
@@ -856,10 +1045,12 @@ int sbl_serdes_del_config(struct sbl_inst *sbl,
 				(sc->tp_state_mask1 == tp_state_mask1) &&
 				(sc->tp_state_match0 == tp_state_match0) &&
 				(sc->tp_state_match1 == tp_state_match1)) {
-			list_del(&sc->list);
+			write_seqcount_begin(&sbl->serdes_config_seq);
+			list_del_rcu(&sc->list);
+			write_seqcount_end(&sbl->serdes_config_seq);
 			spin_unlock(&sbl->serdes_config_lock);
 			sbl_dev_dbg(sbl->dev, "deleted serdes config, tag %d\n", sc->tag);
-			kfree(sc);
+			kfree_rcu(sc, rcu);
 			return 0;
 		}
 	}
@@ -893,13 +1084,15 @@ int sbl_serdes_clear_all_configs(struct sbl_inst *sbl, bool clr_default)
 
 	/* find the entries and remove them */
 	spin_lock(&sbl->serdes_config_lock);
+	write_seqcount_begin(&sbl->serdes_config_seq);
 	list_for_each_entry_safe(sc, tmp_sc, &sbl->serdes_config_list, list) {
 		/* clear if not default or we want to clear the default */
 		if (!sc->is_default || clr_default) {
-			list_del(&sc->list);
-			kfree(sc);
+			list_del_rcu(&sc->list);
+			kfree_rcu(sc, rcu);
 		}
 	}
+	write_seqcount_end(&sbl->serdes_config_seq);
 	spin_unlock(&sbl->serdes_config_lock);
 
 	return 0;
@@ -51,7 +51,7 @@ int sbl_serdes_lp_detect(struct sbl_inst *sbl, int port_num);
  *
  * @return 0 on success or negative errno on failure
  */
-int sbl_serdes_start(struct sbl_inst *sbl, int port_num);
+int sbl_serdes_start(struct sbl_inst *sbl, int port_num, bool resume);
 
 /**
  * @brief Stops the SerDes lanes for a given port
@@ -6,6 +6,14 @@
 #include <linux/device.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/bitops.h>
+#include <linux/bitmap.h>
+#include <linux/workqueue.h>
+#include <linux/rculist.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_kconfig.h>
@@ -238,96 +246,462 @@ static bool rx_serdes_required_for_link_mode(struct sbl_inst *sbl, int port_num,
 		return false;
 }
 
-/* Returns a count of the number of bits set in input val */
-static int sbl_num_bits_set(u64 val)
+/* Get mask of serdes required in either direction for target link mode */
+static u32 get_serdes_required_mask(struct sbl_inst *sbl, int port_num)
 {
-	int bits_set = 0;
-	int i;
+	// physical lane 0 is always required (see tx_serdes_required_for_link_mode)
+	return (BIT(0) | get_serdes_tx_mask(sbl, port_num) |
+		get_serdes_rx_mask(sbl, port_num)) &
+		GENMASK(sbl->switch_info->num_serdes - 1, 0);
+}
 
-	for (i = 0; i < 64; ++i) {
-		if (val & (1ULL << i))
-			bits_set++;
-	}
-	return bits_set;
+/* Get mask of rx serdes required for target link mode */
+static u32 get_serdes_rx_required_mask(struct sbl_inst *sbl, int port_num)
+{
+	return get_serdes_rx_mask(sbl, port_num) &
+		GENMASK(sbl->switch_info->num_serdes - 1, 0);
 }
 
-/* Looks up sbl_sc_val struct for the given port, serdes, and hash */
+/*
+ * Looks up sbl_sc_val struct for the given port, serdes, and hash
+ *
+ * The config list is sorted most specific first (see sbl_serdes_add_config())
+ * so the first match is the one wanted. The lookup is retried if the list
+ * changes under it, and the result remembered for the lane until the hash
+ * or the list changes.
+ */
 static int sbl_get_serdes_config_values(struct sbl_inst *sbl, int port_num,
 					int serdes, struct sbl_sc_values *vals)
 {
+	struct sbl_sc_memo *memo = sbl->link[port_num].sc_memo + serdes;
 	u64 hash0 = sbl_get_tp_hash0(sbl, port_num);
 	u64 hash1 = sbl_get_tp_hash1(sbl, port_num);
 	struct sbl_serdes_config *sc;
-	int num_ports_bits, num_serdes_bits, num_mask_bits;
-	int least_port_bits = 64;
-	int least_serdes_bits = 64;
-	int most_mask_bits = 0;
-	bool curr_best;
-	int rc = -1;
-
-	spin_lock(&sbl->serdes_config_lock);
-
-	list_for_each_entry(sc, &sbl->serdes_config_list, list) {
-
-		if ((sc->port_mask & (1ULL << port_num)) &&
-		    (sc->serdes_mask & (1ULL << serdes)) &&
-		    // Ensure no bits are set in hash that are not set
-		    //  in tp_state_match for all bits included in the mask
-		    (((sc->tp_state_mask0 & hash0) &
-		      ~(sc->tp_state_mask0 & sc->tp_state_match0)) == 0) &&
-		    (((sc->tp_state_mask1 & hash1) &
-		      ~(sc->tp_state_mask1 & sc->tp_state_match1)) == 0)) {
-			// This is A match, but there may be >1. We want to
-			//  choose the match that's most specific to this
-			//  config. To determine this, we choose a match which:
-			//  * [1] Has the least number of bits set in its
-			//        port_mask
-			//  * [2] If tie, has the least number of bits set in
-			//        its serdes_mask
-			//  * [3] If tie, has the most number bits set it its
-			//         tp_state_mask0 and tp_state_mask1.
-			//  * [4] If tie, pick the one with the lowest index
-			sbl_dev_dbg(sbl->dev,
-				"p%d: get values: hash0 0x%llx hash1 0x%llx matched 0x%llx 0x%llx, tag %d\n",
-				port_num, hash0, hash1, sc->tp_state_match0, sc->tp_state_match1, sc->tag);
-			curr_best = false;
-			num_ports_bits	= sbl_num_bits_set(sc->port_mask);
-			num_serdes_bits = sbl_num_bits_set(sc->serdes_mask);
-			num_mask_bits	= sbl_num_bits_set(sc->tp_state_mask0);
-			num_mask_bits  += sbl_num_bits_set(sc->tp_state_mask1);
-			if (num_ports_bits < least_port_bits) {
-				// [1]
-				curr_best = true;
-			} else if (num_ports_bits == least_port_bits) {
-				if (num_serdes_bits < least_serdes_bits) {
-					// [2]
-					curr_best = true;
-				} else if (num_serdes_bits == least_serdes_bits) {
-					if (num_mask_bits > most_mask_bits) {
-						// [3]
-						curr_best = true;
-					}
-				}
-			}
+	unsigned int config_seq;
+	u32 tag = 0;
+	int rc;
+
+	config_seq = read_seqcount_begin(&sbl->serdes_config_seq);
+	if (memo->valid && (memo->config_seq == config_seq) &&
+	    (memo->tp_state_hash0 == hash0) && (memo->tp_state_hash1 == hash1)) {
+		rc = memo->rc;
+		goto out;
+	}
 
-			if (curr_best) {
-				sbl_dev_dbg(sbl->dev, "p%d: tag %d is current best match\n", port_num, sc->tag);
-				*vals = sc->vals;
-				least_port_bits = num_ports_bits;
-				least_serdes_bits = num_serdes_bits;
-				most_mask_bits = num_mask_bits;
+	rcu_read_lock();
+	do {
+		config_seq = read_seqcount_begin(&sbl->serdes_config_seq);
+		rc = -ENOENT;
+		list_for_each_entry_rcu(sc, &sbl->serdes_config_list, list) {
+			if ((sc->port_mask & (1ULL << port_num)) &&
+			    (sc->serdes_mask & (1ULL << serdes)) &&
+			    // Ensure no bits are set in hash that are not set
+			    //  in tp_state_match for all bits included in the mask
+			    (((sc->tp_state_mask0 & hash0) &
+			      ~(sc->tp_state_mask0 & sc->tp_state_match0)) == 0) &&
+			    (((sc->tp_state_mask1 & hash1) &
+			      ~(sc->tp_state_mask1 & sc->tp_state_match1)) == 0)) {
+				memo->vals = sc->vals;
+				tag = sc->tag;
 				rc = 0;
+				break;
 			}
 		}
+	} while (read_seqcount_retry(&sbl->serdes_config_seq, config_seq));
+	rcu_read_unlock();
+
+	if (!rc)
+		sbl_dev_dbg(sbl->dev,
+			"p%ds%d: get values: hash0 0x%llx hash1 0x%llx matched tag %d\n",
+			port_num, serdes, hash0, hash1, tag);
+
+	memo->valid = true;
+	memo->config_seq = config_seq;
+	memo->tp_state_hash0 = hash0;
+	memo->tp_state_hash1 = hash1;
+	memo->rc = rc;
+
+ out:
+	if (rc) {
+		sbl_dev_err(sbl->dev, "%d: get values: no match for hash0 0x%llx hash1 0x%llx\n",
+				port_num, hash0, hash1);
+		return rc;
 	}
-	spin_unlock(&sbl->serdes_config_lock);
 
-	if (rc == 0)
-		return 0;
+	*vals = memo->vals;
+	return 0;
+}
+
+/*
+ * Tuning params history
+ *
+ * Besides the active set in link->tuning_params, each port remembers the
+ * last few sets saved, up to SBL_TP_HISTORY_CANDIDATES for each tp state
+ * hash, so going back to an earlier configuration (loopback mode, cable,
+ * link mode) can reuse its params instead of doing a full tune.
+ *
+ * Each set records how well it worked - its eye heights, the fec rates
+ * in the up check and early in each link up, the share of link ups lost
+ * early and how long the link stayed up - and a retune uses the best
+ * scoring set for the hash. A new tune replaces the worst candidate for
+ * its hash, or else the least recently used slot. All under
+ * tuning_params_mtx.
+ */
+
+static bool sbl_tp_slot_valid(const struct sbl_tp_slot *slot, u64 hash0, u64 hash1)
+{
+	return (slot->tp.magic == SBL_TUNING_PARAM_MAGIC) &&
+		(slot->tp.tp_state_hash0 == hash0) &&
+		(slot->tp.tp_state_hash1 == hash1);
+}
+
+static s64 sbl_tp_quality_score(const struct sbl_tp_quality *quality)
+{
+	s64 score;
+
+	score  = (s64)quality->min_eye * SBL_TP_SCORE_EYE;
+	score += min_t(unsigned long, quality->up_ms / (60 * MSEC_PER_SEC), 60) *
+		SBL_TP_SCORE_UP_MIN;
+	/* a new set ranks on its eyes, not on having no history */
+	if (quality->fail_count)
+		score -= div_u64((u64)quality->fail_count * SBL_TP_SCORE_FAIL,
+				quality->up_count + quality->fail_count);
+	score -= (s64)ilog2(max(quality->up_ccw, quality->early_ccw) + 1) *
+		SBL_TP_SCORE_CCW;
+	if (quality->up_ucw || quality->early_ucw)
+		score -= SBL_TP_SCORE_UCW;
+
+	return score;
+}
+
+/* best (or worst) scoring set for the hashes, and how many there are */
+static struct sbl_tp_slot *sbl_tp_history_rank(struct sbl_link *link,
+		u64 hash0, u64 hash1, bool best, int *count)
+{
+	struct sbl_tp_slot *found = NULL;
+	struct sbl_tp_slot *slot;
+	s64 found_score = 0;
+	s64 score;
+	int i;
+
+	*count = 0;
+	if (!link->tp_history)
+		return NULL;
+
+	for (i = 0; i < SBL_TP_HISTORY_SLOTS; ++i) {
+		slot = link->tp_history + i;
+		if (!sbl_tp_slot_valid(slot, hash0, hash1))
+			continue;
+		(*count)++;
+		score = sbl_tp_quality_score(&slot->quality);
+		if (!found || (best ? (score > found_score) : (score < found_score))) {
+			found = slot;
+			found_score = score;
+		}
+	}
+
+	return found;
+}
+
+/* smallest eye height of the required lanes */
+static s16 sbl_tp_min_eye(struct sbl_inst *sbl, int port_num,
+		const struct sbl_tuning_params *tp)
+{
+	unsigned long lanes = get_serdes_rx_required_mask(sbl, port_num);
+	s16 min_eye = S16_MAX;
+	int serdes;
+	int i;
+
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		for (i = 0; i < NUM_EH_PARAMS; ++i)
+			min_eye = min(min_eye, tp->params[serdes].eh[i]);
+	}
+
+	return (min_eye == S16_MAX) ? 0 : min_eye;
+}
+
+/* remember the active tuning params for their tp state hashes (tuning_params_mtx held) */
+static void sbl_tp_history_store(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	u64 hash0 = link->tuning_params.tp_state_hash0;
+	u64 hash1 = link->tuning_params.tp_state_hash1;
+	struct sbl_tp_slot *slot;
+	int count;
+	int i;
+
+	if (!link->tp_history) {
+		link->tp_history = kcalloc(SBL_TP_HISTORY_SLOTS,
+				sizeof(struct sbl_tp_slot), GFP_KERNEL);
+		if (!link->tp_history)
+			return;
+	}
+
+	/* a new tune replaces the worst set for the hashes, or a free or lru slot */
+	slot = sbl_tp_history_rank(link, hash0, hash1, false, &count);
+	if (count < SBL_TP_HISTORY_CANDIDATES) {
+		slot = link->tp_history;
+		for (i = 1; i < SBL_TP_HISTORY_SLOTS; ++i) {
+			if (slot->tp.magic != SBL_TUNING_PARAM_MAGIC)
+				break;
+			if ((link->tp_history[i].tp.magic != SBL_TUNING_PARAM_MAGIC) ||
+			    (link->tp_history[i].last_used < slot->last_used))
+				slot = link->tp_history + i;
+		}
+	}
+
+	memcpy(&slot->tp, &link->tuning_params, sizeof(struct sbl_tuning_params));
+	memset(&slot->quality, 0, sizeof(struct sbl_tp_quality));
+	slot->quality.min_eye = sbl_tp_min_eye(sbl, port_num, &slot->tp);
+	slot->last_used = ++link->tp_history_clock;
+	link->tp_active_slot = slot - link->tp_history;
+
+	sbl_dev_dbg(sbl->dev, "p%d: tp history - stored hash0 0x%llx hash1 0x%llx in slot %d (min eye %d)\n",
+		port_num, hash0, hash1, link->tp_active_slot, slot->quality.min_eye);
+}
+
+/* make the best remembered params for these tp state hashes the active ones (tuning_params_mtx held) */
+static bool sbl_tp_history_restore(struct sbl_inst *sbl, int port_num,
+		u64 hash0, u64 hash1)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_tp_slot *slot;
+	int count;
+
+	slot = sbl_tp_history_rank(link, hash0, hash1, true, &count);
+	if (!slot)
+		return false;
+
+	memcpy(&link->tuning_params, &slot->tp, sizeof(struct sbl_tuning_params));
+	slot->last_used = ++link->tp_history_clock;
+	link->tp_active_slot = slot - link->tp_history;
+
+	sbl_dev_dbg(sbl->dev, "p%d: tp history - restored hash0 0x%llx hash1 0x%llx from slot %d of %d (score %lld)\n",
+		port_num, hash0, hash1, link->tp_active_slot, count,
+		sbl_tp_quality_score(&slot->quality));
+
+	return true;
+}
+
+/* the active history slot, if the active params came from one (tuning_params_mtx held) */
+static struct sbl_tp_slot *sbl_tp_active_slot(struct sbl_link *link)
+{
+	if (!link->tp_history || (link->tp_active_slot < 0))
+		return NULL;
+
+	return link->tp_history + link->tp_active_slot;
+}
+
+/* snapshot of the current fec rates */
+static void sbl_tp_quality_rates(struct sbl_link *link, u64 *ccw, u64 *ucw)
+{
+	struct sbl_fec *fec_prmts = link->fec_data->fec_prmts;
+
+	spin_lock(&fec_prmts->fec_cnt_lock);
+	*ccw = fec_prmts->fec_rates->ccw;
+	*ucw = fec_prmts->fec_rates->ucw;
+	spin_unlock(&fec_prmts->fec_cnt_lock);
+}
+
+/**
+ * sbl_tp_quality_up() - Record a passed fec up check for the active params
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Context: Process context
+ */
+void sbl_tp_quality_up(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_tp_slot *slot;
+	u64 ccw;
+	u64 ucw;
+
+	sbl_tp_quality_rates(link, &ccw, &ucw);
+
+	mutex_lock(&link->tuning_params_mtx);
+	link->tp_up_jiffies = jiffies;
+	slot = sbl_tp_active_slot(link);
+	if (slot) {
+		slot->quality.up_count++;
+		slot->quality.up_ccw = max(slot->quality.up_ccw, ccw);
+		slot->quality.up_ucw = max(slot->quality.up_ucw, ucw);
+	}
+	mutex_unlock(&link->tuning_params_mtx);
+}
+
+/**
+ * sbl_tp_quality_monitor() - Record the fec monitor rates for the active params
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @down: the monitor is taking the link down
+ *
+ * Never waits for the tuning params - a busy sample is just skipped.
+ *
+ * Context: Process context (fec timer work)
+ */
+void sbl_tp_quality_monitor(struct sbl_inst *sbl, int port_num, bool down)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_tp_slot *slot;
+	unsigned long up_ms;
+	u64 ccw;
+	u64 ucw;
+
+	sbl_tp_quality_rates(link, &ccw, &ucw);
+
+	if (!mutex_trylock(&link->tuning_params_mtx))
+		return;
+
+	slot = sbl_tp_active_slot(link);
+	if (!slot)
+		goto out;
+
+	up_ms = jiffies_to_msecs(jiffies - link->tp_up_jiffies);
+	slot->quality.up_ms = max(slot->quality.up_ms, up_ms);
+	if (up_ms > SBL_TP_QUALITY_EARLY_PERIOD)
+		goto out;
+
+	slot->quality.early_ccw = max(slot->quality.early_ccw, ccw);
+	slot->quality.early_ucw = max(slot->quality.early_ucw, ucw);
+	if (down)
+		slot->quality.fail_count++;
+
+ out:
+	mutex_unlock(&link->tuning_params_mtx);
+}
+
+/*
+ * sbl_tp_history_invalidate() - Forget remembered tuning params
+ *
+ * Forgets the set the active params came from, or every set if all is true.
+ *
+ * Context: tuning_params_mtx held
+ */
+void sbl_tp_history_invalidate(struct sbl_inst *sbl, int port_num, bool all)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_tp_slot *slot;
+	int i;
+
+	slot = sbl_tp_active_slot(link);
+	link->tp_active_slot = -1;
+	if (!link->tp_history)
+		return;
+
+	if (!all) {
+		if (slot)
+			slot->tp.magic = 0;
+		return;
+	}
+
+	for (i = 0; i < SBL_TP_HISTORY_SLOTS; ++i)
+		link->tp_history[i].tp.magic = 0;
+}
+
+/*
+ * Peer tuning seed
+ *
+ * A port with no saved params for its configuration can start from the
+ * params of another port which is up with the same tp state hashes (same
+ * link partner, mode, media, vendor and length). They are only a starting
+ * point for a min effort tune - once they are applied the port's own
+ * params are put back, so only a good tune of this port saves params for
+ * it and the params it holds for another configuration are kept.
+ */
+
+/* copy converged params from an up peer with the same tp state hashes */
+static bool sbl_tp_peer_find(struct sbl_inst *sbl, int port_num,
+		u64 hash0, u64 hash1)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int num_ports = sbl->switch_info->num_ports;
+	struct sbl_link *peer;
+	bool found;
+	int i;
+
+	for (i = 1; i < num_ports; ++i) {
+		peer = sbl->link + ((port_num + i) % num_ports);
+
+		if (peer->blstate != SBL_BASE_LINK_STATUS_UP)
+			continue;
+
+		/* never wait for a peer, it might be seeding from us */
+		if (!mutex_trylock(&peer->tuning_params_mtx))
+			continue;
+
+		found = (peer->tuning_params.magic == SBL_TUNING_PARAM_MAGIC) &&
+			(peer->tuning_params.tp_state_hash0 == hash0) &&
+			(peer->tuning_params.tp_state_hash1 == hash1) &&
+			(sbl_get_tp_hash0(sbl, peer - sbl->link) == hash0) &&
+			(sbl_get_tp_hash1(sbl, peer - sbl->link) == hash1);
+		if (found)
+			memcpy(&link->tuning_params, &peer->tuning_params,
+					sizeof(struct sbl_tuning_params));
+
+		mutex_unlock(&peer->tuning_params_mtx);
+
+		if (found) {
+			sbl_dev_dbg(sbl->dev, "p%d: tp seed - using params from p%ld\n",
+				port_num, (long)(peer - sbl->link));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * sbl_tp_peer_seed() - Apply a peer port's tuning params as a starting point
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Context: tuning_params_mtx held
+ *
+ * Return: true if params were applied and a min effort tune should follow
+ */
+static bool sbl_tp_peer_seed(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_tuning_params *own;
+	u64 hash0;
+	u64 hash1;
+	int serdes;
+	int err = 0;
+
+	/* as for saved params, not until AOC sync is implemented */
+	if (link->mattr.media == SBL_LINK_MEDIA_OPTICAL)
+		return false;
+
+	own = kmalloc(sizeof(struct sbl_tuning_params), GFP_KERNEL);
+	if (!own)
+		return false;
+	memcpy(own, &link->tuning_params, sizeof(struct sbl_tuning_params));
 
-	sbl_dev_err(sbl->dev, "%d: get values: no match for hash0 0x%llx hash1 0x%llx\n",
-			port_num, hash0, hash1);
-	return -ENOENT;
+	hash0 = sbl_get_tp_hash0(sbl, port_num);
+	hash1 = sbl_get_tp_hash1(sbl, port_num);
+
+	if (!sbl_tp_peer_find(sbl, port_num, hash0, hash1)) {
+		kfree(own);
+		return false;
+	}
+
+	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+		if (!rx_serdes_required_for_link_mode(sbl, port_num, serdes))
+			continue;
+		err = sbl_apply_serdes_tuning_params(sbl, port_num, serdes);
+		if (err) {
+			sbl_dev_warn(sbl->dev, "p%ds%d: tp seed - apply failed [%d]",
+					port_num, serdes, err);
+			break;
+		}
+	}
+
+	/* only a good tune of this port saves params for it */
+	memcpy(&link->tuning_params, own, sizeof(struct sbl_tuning_params));
+	kfree(own);
+
+	return !err;
 }
 
 /* Checks if there are valid tuning params in the sbl struct which can
@@ -338,6 +712,7 @@ static bool sbl_is_retune(struct sbl_inst *sbl, int port_num)
 	int serdes, i;
 	u64 tp_state_hash0, tp_state_hash1;
 	struct sbl_link *link = sbl->link + port_num;
+	bool active_match;
 
 	DEV_TRACE2(sbl->dev, "p%d", port_num);
 
@@ -348,8 +723,13 @@ static bool sbl_is_retune(struct sbl_inst *sbl, int port_num)
 	// Check tuning params are for this target configuration
 	tp_state_hash0 = sbl_get_tp_hash0(sbl, port_num);
 	tp_state_hash1 = sbl_get_tp_hash1(sbl, port_num);
-	if ((sbl->link[port_num].tuning_params.tp_state_hash0 != tp_state_hash0) ||
-	    (sbl->link[port_num].tuning_params.tp_state_hash1 != tp_state_hash1)) {
+	active_match = (link->tuning_params.tp_state_hash0 == tp_state_hash0) &&
+		(link->tuning_params.tp_state_hash1 == tp_state_hash1);
+
+	// Params set from outside are used as given, otherwise the best remembered set
+	if (!(active_match && (link->tp_active_slot < 0)) &&
+	    !sbl_tp_history_restore(sbl, port_num, tp_state_hash0, tp_state_hash1) &&
+	    !active_match) {
 		sbl_dev_dbg(sbl->dev,
 			"p%d: tuning param mismatch (saved: 0x%llx 0x%llx curr:0x%llx 0x%llx) - not retune\n",
 			port_num, sbl->link[port_num].tuning_params.tp_state_hash0,
@@ -390,8 +770,8 @@ static bool sbl_is_retune(struct sbl_inst *sbl, int port_num)
 }
 
 /* Parse the vers string into rev and build */
-static int sbl_parse_version_string(struct sbl_inst *sbl, char *fw_fname,
-				    int *fw_rev, int *fw_build)
+int sbl_parse_version_string(struct sbl_inst *sbl, char *fw_fname,
+			     int *fw_rev, int *fw_build)
 {
 	char  rev_str[SBL_MAX_STR_LEN];
 	char  build_str[SBL_MAX_STR_LEN];
@@ -435,7 +815,7 @@ void sbl_sbm_get_fw_vers(struct sbl_inst *sbl, int sbus_ring, uint *fw_rev, uint
 	uint sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_SBM_SPICO);
 
 	// SBUS Critical Section
-	mutex_lock(&sbl->sbus_ring_mtx[sbus_ring]);
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_TELEMETRY);
 
 	if (sbl_sbm_spico_int(sbl, sbus_addr, SPICO_INT_SBMS_REV_ID,
 				SPICO_INT_DATA_NONE, fw_rev)) {
@@ -449,7 +829,7 @@ void sbl_sbm_get_fw_vers(struct sbl_inst *sbl, int sbus_ring, uint *fw_rev, uint
 		dev_dbg(sbl->dev, "sbm%d: Failed to read firmware build from 0x%x", sbus_ring, sbus_addr);
 		*fw_build = 0x0;
 	}
-	mutex_unlock(&sbl->sbus_ring_mtx[sbus_ring]);
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 }
 
 int sbl_sbm_firmware_flash(struct sbl_inst *sbl)
@@ -465,14 +845,101 @@ int sbl_sbm_firmware_flash(struct sbl_inst *sbl)
 	return err;
 }
 
+/* one per-ring firmware worker */
+struct sbl_ring_work {
+	struct work_struct work;
+	struct sbl_inst *sbl;
+	int sbus_ring;
+	int (*fn)(struct sbl_inst *sbl, int sbus_ring, void *arg);
+	void *arg;
+	int err;
+};
+
+static void sbl_ring_work_fn(struct work_struct *work)
+{
+	struct sbl_ring_work *ring_work = container_of(work, struct sbl_ring_work, work);
+
+	ring_work->err = ring_work->fn(ring_work->sbl, ring_work->sbus_ring, ring_work->arg);
+}
+
+/*
+ * Run fn on each sbus ring in rings in parallel, one worker per ring, and
+ * wait for them all. Each ring has its own sbus ring mutex so the workers
+ * only contend where the platform shares it.
+ *
+ * The workers run on their own workqueue as this is called from work on
+ * sbl->workq (start_many and async starts), which must not wait for
+ * other work queued on it.
+ *
+ * Returns the error from the lowest failing ring.
+ */
+static int sbl_sbus_rings_parallel(struct sbl_inst *sbl, unsigned long rings,
+		int (*fn)(struct sbl_inst *sbl, int sbus_ring, void *arg), void *arg)
+{
+	struct sbl_ring_work *ring_work;
+	int num_rings = sbl->switch_info->num_sbus_rings;
+	int sbus_ring;
+	int err = 0;
+
+	if (!sbl->ring_workq || (hweight_long(rings) <= 1))
+		goto serial;
+
+	ring_work = kcalloc(num_rings, sizeof(*ring_work), GFP_KERNEL);
+	if (!ring_work)
+		goto serial;
+
+	for_each_set_bit(sbus_ring, &rings, num_rings) {
+		ring_work[sbus_ring].sbl = sbl;
+		ring_work[sbus_ring].sbus_ring = sbus_ring;
+		ring_work[sbus_ring].fn = fn;
+		ring_work[sbus_ring].arg = arg;
+		INIT_WORK(&ring_work[sbus_ring].work, sbl_ring_work_fn);
+		queue_work(sbl->ring_workq, &ring_work[sbus_ring].work);
+	}
+
+	for_each_set_bit(sbus_ring, &rings, num_rings) {
+		flush_work(&ring_work[sbus_ring].work);
+		if (!err)
+			err = ring_work[sbus_ring].err;
+	}
+
+	kfree(ring_work);
+	return err;
+
+ serial:
+	for_each_set_bit(sbus_ring, &rings, num_rings) {
+		err = fn(sbl, sbus_ring, arg);
+		if (err)
+			break;
+	}
+	return err;
+}
+
+static int sbl_sbm_firmware_flash_one_ring(struct sbl_inst *sbl, int sbus_ring, void *arg)
+{
+	const struct sbl_fw_image *fw = arg;
+	int err;
+
+	sbl_dev_dbg(sbl->dev, "ring %d sbus_master firmware out of date! Flashing...", sbus_ring);
+
+	err = sbl_sbm_firm_upload(sbl, sbus_ring, fw);
+	if (err) {
+		sbl_dev_err(sbl->dev, "Failed to upload ring %d firmware!", sbus_ring);
+		return err;
+	}
+
+	sbl_dev_info(sbl->dev, "Ring %d Sbus Master firmware flashed successfully.", sbus_ring);
+	return 0;
+}
+
 int sbl_sbm_firmware_flash_ring(struct sbl_inst *sbl, int first_ring,
 				int last_ring, bool force)
 {
-	bool flash_needed, fw_requested = false;
+	unsigned long rings = 0;
 	int sbus_ring;
 	int err;
 	int fw_rev, fw_build;
-	const struct firmware *fw = NULL;
+	struct sbl_fw_image *fw;
 
 	if ((last_ring < first_ring) || (first_ring < 0) ||
 	    (last_ring > sbl->switch_info->num_sbus_rings - 1)) {
@@ -491,42 +958,26 @@ int sbl_sbm_firmware_flash_ring(struct sbl_inst *sbl, int first_ring,
 
 	// Check SBus Master firmware versions
 	for (sbus_ring = first_ring; sbus_ring <= last_ring; ++sbus_ring) {
-		flash_needed = false;
-		if (sbl_validate_sbm_fw_vers(sbl, sbus_ring, fw_rev,
-					     fw_build)) {
-			flash_needed = true;
-		}
+		if (force || sbl_validate_sbm_fw_vers(sbl, sbus_ring, fw_rev,
+						      fw_build))
+			__set_bit(sbus_ring, &rings);
+	}
+	if (!rings)
+		return 0;
 
-		if (flash_needed || force) {
-			if (!fw_requested) {
-				err = request_firmware(&fw, sbl->iattr.sbm_fw_fname,
-						       sbl->dev);
-				if (err) {
-					sbl_dev_err(sbl->dev, "firmware request failed [%d]", err);
-					return err;
-				}
-				sbl_dev_dbg(sbl->dev, "loaded fw (size %zd)", fw->size);
-				fw_requested = true;
-			}
-			sbl_dev_dbg(sbl->dev, "ring %d sbus_master firmware out of date! Flashing...", sbus_ring);
+	fw = sbl_sbm_fw_image_get(sbl);
+	if (IS_ERR(fw))
+		return PTR_ERR(fw);
 
-			err = sbl_sbm_firm_upload(sbl, sbus_ring, fw->size, fw->data);
-			if (err) {
-				sbl_dev_err(sbl->dev, "Failed to upload ring %d firmware!", sbus_ring);
-				goto out_release;
-			} else {
-				sbl_dev_info(sbl->dev, "Ring %d Sbus Master firmware flashed successfully.", sbus_ring);
-			}
-		}
-	}
+	// Flash the out of date rings in parallel
+	err = sbl_sbus_rings_parallel(sbl, rings, sbl_sbm_firmware_flash_one_ring, fw);
 
- out_release:
-	release_firmware(fw);
+	sbl_fw_image_put(fw);
 
 	return err;
 }
 
-static void sbl_serdes_firmware_validation(struct sbl_inst *sbl, const struct firmware *fw,
+static void sbl_serdes_firmware_validation(struct sbl_inst *sbl, const struct sbl_fw_image *fw,
 					u32 sbus_addr, u32 result, u32 sbus_ring)
 {
 	int rc, i;
@@ -570,7 +1021,7 @@ int sbl_serdes_firmware_flash_safe(struct sbl_inst *sbl, int port_num,
 	u32 sbus_addr, crc_result, sbus_ring;
 	u32 curr_fw_rev = 0, curr_fw_build = 0;
 	u32 result;
-	const struct firmware *fw = NULL;
+	struct sbl_fw_image *fw;
 	int fw_rev, fw_build;
 	int serdes = 0;
 
@@ -647,7 +1098,7 @@ int sbl_serdes_firmware_flash_safe(struct sbl_inst *sbl, int port_num,
 			    "%s: Sbus contention detected, sbus_ring_mtx[%d] locked", __func__, sbus_ring);
 
 		// SBUS Critical Section
-		mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_FIRMWARE);
 
 		/* First, dump the SBM FW info for debug */
 		sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_SBM_SPICO);
@@ -699,9 +1150,9 @@ int sbl_serdes_firmware_flash_safe(struct sbl_inst *sbl, int port_num,
 				 port_num, sbus_addr, result);
 		}
 
-		rc = request_firmware(&fw, sbl->iattr.sbm_fw_fname, sbl->dev);
-		if (rc != 0) {
-			sbl_dev_err(sbl->dev, "firmware request failed [%d]", rc);
+		fw = sbl_sbm_fw_image_get(sbl);
+		if (IS_ERR(fw)) {
+			rc = PTR_ERR(fw);
 		} else {
 			sbl_dev_info(sbl->dev,
 				 "p%d(0x%x): Checking SBM FW for corruption...",
@@ -713,10 +1164,10 @@ int sbl_serdes_firmware_flash_safe(struct sbl_inst *sbl, int port_num,
 			else
 				sbl_serdes_firmware_validation(sbl, fw, sbus_addr, result, sbus_ring);
 
-			release_firmware(fw);
+			sbl_fw_image_put(fw);
 		}
 
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 
 		/* Now, try reloading the sbus master FW */
 		rc = sbl_sbm_firmware_flash_ring(sbl, sbus_ring, sbus_ring, true);
@@ -753,7 +1204,7 @@ int sbl_serdes_firmware_flash(struct sbl_inst *sbl, int port_num, bool force)
 	int fw_rev, fw_build;
 	int port = port_num;
 	int first_port, last_port;
-	const struct firmware *fw = NULL;
+	struct sbl_fw_image *fw = NULL;
 
 	/* Lock sbm_fw_mtx to ensure we don't reload the sbus master FW
 	 * while reloading the SerDes FW
@@ -805,14 +1256,14 @@ int sbl_serdes_firmware_flash(struct sbl_inst *sbl, int port_num, bool force)
 	}
 
 	if (flash_needed) {
-		err = request_firmware(&fw, sbl->iattr.serdes_fw_fname, sbl->dev);
-		if (err) {
-			sbl_dev_err(sbl->dev, "firmware request failed [%d]",
-				err);
+		fw = sbl_serdes_fw_image_get(sbl);
+		if (IS_ERR(fw)) {
+			err = PTR_ERR(fw);
+			fw = NULL;
 			goto out;
 		}
 
-		err = sbl_serdes_firm_upload(sbl, port_num, fw->size, fw->data);
+		err = sbl_serdes_firm_upload(sbl, port_num, fw);
 		if (err) {
 			sbl_dev_err(sbl->dev, "%d: serdes firmware upload failed [%d]", port_num, err);
 			if (port_num == SBL_ALL_PORTS)
@@ -833,7 +1284,7 @@ int sbl_serdes_firmware_flash(struct sbl_inst *sbl, int port_num, bool force)
 	}
 
  out:
-	release_firmware(fw);
+	sbl_fw_image_put(fw);
 
 	if (port_num == SBL_ALL_PORTS) {
 		for (sr = 0; sr < sbl->switch_info->num_sbus_rings; ++sr)
@@ -856,7 +1307,7 @@ int sbl_validate_sbm_fw_vers(struct sbl_inst *sbl, u32 sbus_ring,
 		   sbus_ring, fw_rev, fw_build);
 
 	// SBUS Critical Section
-	mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_FIRMWARE);
 
 	if (sbl_sbm_spico_int(sbl, sbus_addr, SPICO_INT_SBMS_REV_ID,
 			      SPICO_INT_DATA_NONE, &curr_fw_rev)) {
@@ -871,7 +1322,7 @@ int sbl_validate_sbm_fw_vers(struct sbl_inst *sbl, u32 sbus_ring,
 			 sbus_ring, sbus_addr);
 	}
 
-	mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 
 	if (((int)curr_fw_rev == fw_rev) && ((int)curr_fw_build == fw_build)) {
 		sbl_dev_dbg(sbl->dev, "r%d: Found expected SBM rev: 0x%x_%x",
@@ -955,7 +1406,7 @@ int sbl_validate_serdes_fw_vers(struct sbl_inst *sbl, int port_num, int serdes,
 
 // does the CRC check
 int sbl_sbm_firm_upload(struct sbl_inst *sbl, int sbus_ring,
-			size_t fw_size, const u8 *fw_data)
+			const struct sbl_fw_image *fw)
 {
 	u32 sbus_addr, unused, crc_result;
 	int err;
@@ -964,7 +1415,7 @@ int sbl_sbm_firm_upload(struct sbl_inst *sbl, int sbus_ring,
 		return 0;
 
 	// SBUS Critical Section
-	mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_FIRMWARE);
 
 	sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_SBM_SPICO);
 
@@ -1001,32 +1452,32 @@ int sbl_sbm_firm_upload(struct sbl_inst *sbl, int sbus_ring,
 
 	err = sbl_spico_burst_upload(sbl, sbus_addr,
 					  SPICO_SBR_ADDR_IMEM_BURST_DATA,
-					  fw_size, fw_data);
+					  fw->num_words, fw->words);
 	if (err) {
 		sbl_dev_err(sbl->dev, "Upload failed!");
 		goto err_out;
 	}
 
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_IMEM,
-			       SPICO_SBR_DATA_SET_BURST_WR | fw_size);
+			       SPICO_SBR_DATA_SET_BURST_WR | fw->size);
 	if (err)
 		goto err_out;
 
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_IMEM,
 			       SPICO_SBR_DATA_SET_BURST_WR |
-			       (fw_size+1));
+			       (fw->size+1));
 	if (err)
 		goto err_out;
 
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_IMEM,
 			       SPICO_SBR_DATA_SET_BURST_WR |
-			       (fw_size+2));
+			       (fw->size+2));
 	if (err)
 		goto err_out;
 
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SBR_ADDR_IMEM,
 			       SPICO_SBR_DATA_SET_BURST_WR |
-			       (fw_size+3));
+			       (fw->size+3));
 	if (err)
 		goto err_out;
 
@@ -1060,135 +1511,213 @@ int sbl_sbm_firm_upload(struct sbl_inst *sbl, int sbus_ring,
 	atomic_inc(&sbl->sbm_fw_reload_count[sbus_ring]);
 
 err_out:
-	mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 	return err;
 }
 
-int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num, size_t fw_size,
-			   const u8 *fw_data)
+/* what to flash on each ring for a serdes firmware upload */
+struct sbl_serdes_upload {
+	const struct sbl_fw_image *fw;
+	int port_num;
+	int first_serdes;
+	int last_serdes;
+};
+
+static int sbl_serdes_firm_upload_ring(struct sbl_inst *sbl, int sbus_ring, void *arg)
 {
-	int serdes;
+	struct sbl_serdes_upload *upload = arg;
+	int port_num = upload->port_num;
 	u32 sbus_addr;
-	u64 core_status_value;
-	int sbus_ring;
-	int err = -1;
-	int port, first_port, last_port, first_ring, last_ring;
-	int first_serdes, last_serdes;
-	unsigned long last_jiffy;
+	int serdes;
+	int err = 0;
 
-	if (port_num == SBL_ALL_PORTS) {
-		sbl_dev_dbg(sbl->dev, "Loading SerDes firmware for all ports...");
-		first_port = 0;
-		last_port = sbl->switch_info->num_ports - 1;
-		first_serdes = 0; // force to a single iteration
-		last_serdes = 0;
-		first_ring = 0;
-		last_ring = sbl->switch_info->num_sbus_rings - 1;
-	} else {
-		sbl_dev_dbg(sbl->dev, "p%d: Loading SerDes firmware...", port_num);
-		first_port = port_num;
-		last_port = port_num;
-		first_serdes = 0;
-		last_serdes = sbl->switch_info->num_serdes - 1;
-		// All serdes for a given port are always on the same ring, so
-		//  just use serdes 0 to determine the ring.
-		first_ring = sbl->switch_info->ports[port_num].serdes[0].sbus_ring;
-		last_ring = sbl->switch_info->ports[port_num].serdes[0].sbus_ring;
-	}
-	for (port = first_port; port <= last_port; ++port) {
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			err = sbl_serdes_soft_reset(sbl, port, serdes);
-			if (err)
-				return err;
-		}
-	}
+	// SBUS Critical Section
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_FIRMWARE);
 
-	// Don't allow SPICO interrupts while we are reloading firmware
-	for (port = first_port; port <= last_port; ++port)
-		mutex_lock(&sbl->link[port].serdes_mtx);
+	for (serdes = upload->first_serdes; serdes <= upload->last_serdes; ++serdes) {
+		if (port_num == SBL_ALL_PORTS)
+			sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_CM4_SERDES_SPICO);
+		else
+			sbus_addr = SBUS_ADDR(sbl->switch_info->ports[port_num].serdes[serdes].sbus_ring,
+					      sbl->switch_info->ports[port_num].serdes[serdes].rx_addr);
 
-	sbl_dev_dbg(sbl->dev, "p%d: Flashing SerDes firmware...", port_num);
-	for (sbus_ring = first_ring; sbus_ring <= last_ring; ++sbus_ring) {
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_RESET_EN,
+			       SPICO_SERDES_DATA_SET_GLOBAL_RESET);
+		if (err)
+			break;
 
-		// SBUS Critical Section
-		mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_RESET_EN,
+			       SPICO_SERDES_DATA_CLR_GLOBAL_RESET);
+		if (err)
+			break;
 
-		for (serdes = first_serdes; serdes <= last_serdes; ++serdes) {
-			if (port_num == SBL_ALL_PORTS)
-				sbus_addr = SBUS_ADDR(sbus_ring, SBUS_BCAST_CM4_SERDES_SPICO);
-			else
-				sbus_addr = SBUS_ADDR(sbl->switch_info->ports[port_num].serdes[serdes].sbus_ring,
-						      sbl->switch_info->ports[port_num].serdes[serdes].rx_addr);
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_INTR_DIS,
+			       SPICO_SERDES_DATA_SET_INTR_DIS);
+		if (err)
+			break;
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_RESET_EN,
-				       SPICO_SERDES_DATA_SET_GLOBAL_RESET);
-			if (err)
-				break;
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_IMEM,
+			       SPICO_SERDES_DATA_SET_IMEM_CNTL_EN);
+		if (err)
+			break;
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_RESET_EN,
-				       SPICO_SERDES_DATA_CLR_GLOBAL_RESET);
-			if (err)
-				break;
+		err = sbl_spico_burst_upload(sbl, sbus_addr,
+					  SPICO_SERDES_ADDR_IMEM_BURST,
+					  upload->fw->num_words, upload->fw->words);
+		if (err) {
+			sbl_dev_err(sbl->dev, "Upload failed!");
+			break;
+		}
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_INTR_DIS,
-				       SPICO_SERDES_DATA_SET_INTR_DIS);
-			if (err)
-				break;
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_IMEM,
+			       SPICO_SERDES_DATA_CLR_IMEM_CNTL_EN);
+		if (err)
+			break;
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_IMEM,
-				       SPICO_SERDES_DATA_SET_IMEM_CNTL_EN);
-			if (err)
-				break;
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_ECC,
+			       SPICO_SERDES_DATA_SET_ECC_EN);
+		if (err)
+			break;
 
-			err = sbl_spico_burst_upload(sbl, sbus_addr,
-						  SPICO_SERDES_ADDR_IMEM_BURST,
-						  fw_size, fw_data);
-			if (err) {
-				sbl_dev_err(sbl->dev, "Upload failed!");
-				break;
-			}
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_ECCLOG,
+			       SPICO_SERDES_DATA_CLR_ECC_ERR);
+		if (err)
+			break;
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_IMEM,
-				       SPICO_SERDES_DATA_CLR_IMEM_CNTL_EN);
-			if (err)
-				break;
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_RESET_EN,
+			       SPICO_SERDES_DATA_SET_SPICO_EN);
+		if (err)
+			break;
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_ECC,
-				       SPICO_SERDES_DATA_SET_ECC_EN);
-			if (err)
-				break;
+		err = sbl_sbus_wr(sbl, sbus_addr,
+			       SPICO_SERDES_ADDR_INTR_DIS,
+			       SPICO_SERDES_DATA_SET_INTR_EN);
+		if (err)
+			break;
+	}
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_ECCLOG,
-				       SPICO_SERDES_DATA_CLR_ECC_ERR);
-			if (err)
-				break;
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_RESET_EN,
-				       SPICO_SERDES_DATA_SET_SPICO_EN);
-			if (err)
-				break;
+	return err;
+}
 
-			err = sbl_sbus_wr(sbl, sbus_addr,
-				       SPICO_SERDES_ADDR_INTR_DIS,
-				       SPICO_SERDES_DATA_SET_INTR_EN);
-			if (err)
-				break;
+/*
+ * Wait for the spico on every serdes of the ports to come ready, polling
+ * them all in one sweep, then check each firmware crc.
+ */
+static int sbl_serdes_firm_ready_wait(struct sbl_inst *sbl, int first_port,
+		int last_port)
+{
+	int num_serdes = sbl->switch_info->num_serdes;
+	int num_lanes = (last_port - first_port + 1) * num_serdes;
+	unsigned long *pending;
+	unsigned long last_jiffy;
+	u64 core_status_value;
+	int port, serdes;
+	int lane;
+	int err = 0;
+
+	pending = bitmap_zalloc(num_lanes, GFP_KERNEL);
+	if (!pending)
+		return -ENOMEM;
+	bitmap_fill(pending, num_lanes);
+
+	last_jiffy = jiffies + msecs_to_jiffies(1000*sbl->iattr.core_status_rd_timeout);
+	do {
+		for_each_set_bit(lane, pending, num_lanes) {
+			port = first_port + lane / num_serdes;
+			serdes = lane % num_serdes;
+			core_status_value = sbl_read64(sbl, SBL_PML_BASE(port)|
+						       SBL_PML_SERDES_CORE_STATUS_OFFSET(serdes));
+			if (core_status_value & SERDES_CORE_STATUS_SPICO_READY_MASK)
+				__clear_bit(lane, pending);
 		}
+		if (bitmap_empty(pending, num_lanes))
+			break;
+		msleep(sbl->iattr.core_status_rd_poll_interval);
+	} while (time_is_after_jiffies(last_jiffy));
+
+	for (lane = 0; lane < num_lanes; ++lane) {
+		port = first_port + lane / num_serdes;
+		serdes = lane % num_serdes;
 
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		if (test_bit(lane, pending)) {
+			sbl_dev_err(sbl->dev, "p%ds%d Timeout reading o_core_status (timeout:%ds)",
+						port, serdes, sbl->iattr.core_status_rd_timeout);
+			err = -ETIME;
+			break;
+		}
 
+		err = sbl_validate_serdes_fw_crc(sbl, port, serdes);
 		if (err)
 			break;
+
+		sbl_serdes_fw_crc_record(sbl, port, serdes);
+	}
+
+	bitmap_free(pending);
+	return err;
+}
+
+int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num,
+			   const struct sbl_fw_image *fw)
+{
+	struct sbl_serdes_upload upload = {
+		.fw = fw,
+		.port_num = port_num,
+	};
+	unsigned long rings = 0;
+	int serdes;
+	int sbus_ring;
+	int err = -1;
+	int port, first_port, last_port;
+
+	if (port_num == SBL_ALL_PORTS) {
+		sbl_dev_dbg(sbl->dev, "Loading SerDes firmware for all ports...");
+		first_port = 0;
+		last_port = sbl->switch_info->num_ports - 1;
+		upload.first_serdes = 0; // force to a single iteration
+		upload.last_serdes = 0;
+		for (sbus_ring = 0; sbus_ring < sbl->switch_info->num_sbus_rings; ++sbus_ring)
+			__set_bit(sbus_ring, &rings);
+	} else {
+		sbl_dev_dbg(sbl->dev, "p%d: Loading SerDes firmware...", port_num);
+		first_port = port_num;
+		last_port = port_num;
+		upload.first_serdes = 0;
+		upload.last_serdes = sbl->switch_info->num_serdes - 1;
+		// All serdes for a given port are always on the same ring, so
+		//  just use serdes 0 to determine the ring.
+		__set_bit(sbl->switch_info->ports[port_num].serdes[0].sbus_ring, &rings);
+	}
+	for (port = first_port; port <= last_port; ++port) {
+		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+			err = sbl_serdes_soft_reset(sbl, port, serdes);
+			if (err)
+				return err;
+		}
+	}
+
+	// Don't allow SPICO interrupts while we are reloading firmware
+	for (port = first_port; port <= last_port; ++port) {
+		mutex_lock(&sbl->link[port].serdes_mtx);
+		// Broadcast loads don't bump the reload counters
+		sbl_serdes_fw_crc_invalidate(sbl, port);
+		sbl_hal_shadow_invalidate(sbl, port, ~0);
 	}
 
+	// Flash each ring in parallel
+	sbl_dev_dbg(sbl->dev, "p%d: Flashing SerDes firmware...", port_num);
+	err = sbl_sbus_rings_parallel(sbl, rings, sbl_serdes_firm_upload_ring, &upload);
+
 	for (port = first_port; port <= last_port; ++port)
 		mutex_unlock(&sbl->link[port].serdes_mtx);
 
@@ -1198,7 +1727,7 @@ int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num, size_t fw_size,
 
 	// Increment SerDes firmware reload counters
 	if (port_num != SBL_ALL_PORTS)
-		for (serdes = first_serdes; serdes <= last_serdes; ++serdes)
+		for (serdes = upload.first_serdes; serdes <= upload.last_serdes; ++serdes)
 			sbl_link_counters_incr(sbl, port_num, serdes0_fw_reload + serdes);
 
 	if (!sbl->is_hw)
@@ -1206,34 +1735,9 @@ int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num, size_t fw_size,
 
 
 	sbl_dev_dbg(sbl->dev, "p%d: Validating flash..", port_num);
-	for (port = first_port; port <= last_port; ++port) {
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			sbus_addr =
-				SBUS_ADDR(sbl->switch_info->ports[port].serdes[serdes].sbus_ring,
-					  sbl->switch_info->ports[port].serdes[serdes].rx_addr);
-			last_jiffy = jiffies + msecs_to_jiffies(1000*sbl->iattr.core_status_rd_timeout);
-			do {
-				core_status_value = sbl_read64(sbl, SBL_PML_BASE(port)|
-							       SBL_PML_SERDES_CORE_STATUS_OFFSET(serdes));
-				if (core_status_value &
-				    SERDES_CORE_STATUS_SPICO_READY_MASK) {
-					break;
-				}
-				msleep(sbl->iattr.core_status_rd_poll_interval);
-			} while (time_is_after_jiffies(last_jiffy));
-
-			if (!(core_status_value & (1<<5))) {
-				sbl_dev_err(sbl->dev, "p%ds%d Timeout reading o_core_status (timeout:%ds)",
-							port_num, serdes, sbl->iattr.core_status_rd_timeout);
-				return -ETIME;
-			}
-
-			err = sbl_validate_serdes_fw_crc(sbl, port, serdes);
-			if (err)
-				return err;
-
-		}
-	}
+	err = sbl_serdes_firm_ready_wait(sbl, first_port, last_port);
+	if (err)
+		return err;
 	sbl_dev_dbg(sbl->dev, "p%d: FW upload complete!", port_num);
 
 	return 0;
@@ -1718,6 +2222,8 @@ int sbl_save_serdes_tuning_params(struct sbl_inst *sbl, int port_num)
 
 	err = sbl_get_serdes_tuning_params(sbl, port_num,
 			&sbl->link[port_num].tuning_params);
+	if (!err)
+		sbl_tp_history_store(sbl, port_num);
 
 	return err;
 }
@@ -2277,15 +2783,16 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 
 	// Don't allow SPICO interrupts while we are resetting the SerDes
 	mutex_lock(&sbl->link[port_num].serdes_mtx);
+	sbl_hal_shadow_invalidate(sbl, port_num, BIT(serdes));
 	// SBUS Critical Section
-	mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_RECOVERY);
 
 	// Reset high
 	err = sbl_sbus_op_aux(sbl, sbus_addr, SPICO_SERDES_ADDR_IMEM,
 				   SBUS_IFACE_DST_CORE | SBUS_CMD_RESET,
 				   SPICO_SERDES_DATA_RESET, &unused);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
@@ -2294,7 +2801,7 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SERDES_ADDR_RESET_EN,
 				SPICO_SERDES_DATA_CLR_GLOBAL_RESET);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
@@ -2303,7 +2810,7 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SERDES_ADDR_ECC,
 				SPICO_SERDES_DATA_SET_ECC_EN);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
@@ -2312,7 +2819,7 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SERDES_ADDR_ECCLOG,
 				SPICO_SERDES_DATA_CLR_ECC_ERR);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
@@ -2321,7 +2828,7 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SERDES_ADDR_RESET_EN,
 				SPICO_SERDES_DATA_SET_SPICO_EN);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
@@ -2330,12 +2837,12 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	err = sbl_sbus_wr(sbl, sbus_addr, SPICO_SERDES_ADDR_INTR_DIS,
 				SPICO_SERDES_DATA_SET_INTR_EN);
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		mutex_unlock(&sbl->link[port_num].serdes_mtx);
 		return err;
 	}
 
-	mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 	mutex_unlock(&sbl->link[port_num].serdes_mtx);
 
 	DEV_TRACE2(sbl->dev, "rc: 0");
@@ -2344,111 +2851,88 @@ int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes)
 	return 0;
 }
 
-int sbl_serdes_init(struct sbl_inst *sbl, int port_num, int serdes,
-		    int encoding, int divisor, int width)
+/* append a compiled op, issuing it with the previous op where only the lanes differ */
+static void sbl_serdes_script_add(struct sbl_serdes_script *script, u8 type,
+		u32 lanes, u16 code, u16 data, u16 arg)
 {
-	int err;
-	bool tx_en, rx_en;
+	struct sbl_serdes_script_op *op;
 
-	DEV_TRACE2(sbl->dev, "p%ds%d: encoding: %d divisor: %d width: %d",
-		   port_num, serdes, encoding, divisor, width);
+	if (script->num_ops) {
+		op = script->ops + script->num_ops - 1;
+		if ((type == SBL_SCRIPT_OP_INT) && (op->type == type) &&
+		    (op->code == code) && (op->data == data) && !(op->lanes & lanes)) {
+			op->lanes |= lanes;
+			return;
+		}
+	}
 
-	err = sbl_set_tx_rx_enable(sbl, port_num, serdes, false, false,
-					false);
-	if (err)
-		return err;
+	if (script->num_ops == SBL_SERDES_SCRIPT_MAX_OPS) {
+		script->overflow = true;
+		return;
+	}
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_PLL_RECAL,
-					SPICO_INT_DATA_NONE, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+	op = script->ops + script->num_ops++;
+	op->type  = type;
+	op->lanes = lanes;
+	op->code  = code;
+	op->data  = data;
+	op->arg   = arg;
+}
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TX_PHASE_CAL,
-					SPICO_INT_DATA_NONE, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+/* compile SerDes initialization */
+static void sbl_serdes_script_init(struct sbl_serdes_script *script,
+		struct sbl_inst *sbl, int port_num, int serdes,
+		int encoding, int divisor, int width)
+{
+	u16 en = 0;
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TX_BAUD,
-					(divisor & SPICO_INT_DIVIDER_MASK) |
-					SPICO_INT_DATA_TXTX_RC_NOT_SS,
-					NULL, SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+	DEV_TRACE2(sbl->dev, "p%ds%d: encoding: %d divisor: %d width: %d",
+		   port_num, serdes, encoding, divisor, width);
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_WIDTH_MODE,
-					encoding | width |
-					SPICO_INT_DATA_TXRX_FC_IGNORE, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(serdes), 0, 0, 0);
+
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_PLL_RECAL, SPICO_INT_DATA_NONE, 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TX_PHASE_CAL, SPICO_INT_DATA_NONE, 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TX_BAUD,
+			(divisor & SPICO_INT_DIVIDER_MASK) | SPICO_INT_DATA_TXTX_RC_NOT_SS, 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_WIDTH_MODE,
+			encoding | width | SPICO_INT_DATA_TXRX_FC_IGNORE, 0);
 
 	// tx/rx based on link mode, and always configuing physical lane 0
 	if (tx_serdes_required_for_link_mode(sbl, port_num, serdes))
-		tx_en = true;
-	else
-		tx_en = false;
-
+		en |= SBL_SCRIPT_EN_TX;
 	if (rx_serdes_required_for_link_mode(sbl, port_num, serdes))
-		rx_en = true;
-	else
-		rx_en = false;
-
-	err = sbl_set_tx_rx_enable(sbl, port_num, serdes, tx_en, rx_en,
-					false);
-	if (err)
-		return err;
-
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_PCIE_SLICES,
-					SPICO_INT_DATA_TX_OVERRIDE, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+		en |= SBL_SCRIPT_EN_RX;
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(serdes), 0, en, 0);
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_PCIE_SLICES,
-					SPICO_INT_DATA_RX_EID_EN, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_PCIE_SLICES, SPICO_INT_DATA_TX_OVERRIDE, 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_PCIE_SLICES, SPICO_INT_DATA_RX_EID_EN, 0);
 
 	// Reset signal_ok
-	sbl_serdes_mem_rmw(sbl, port_num, serdes, SERDES_MEM_ADDR_O_CORE_STATUS,
-			   0, SERDES_CORE_STATUS_RX_SIG_OK_MASK);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_MEM_RMW, BIT(serdes),
+			SERDES_MEM_ADDR_O_CORE_STATUS, 0,
+			SERDES_CORE_STATUS_RX_SIG_OK_MASK);
 
 	// Set PRBS for loopback mode - will be changed later
 	if (sbl->link[port_num].loopback_mode == SBL_LOOPBACK_MODE_LOCAL) {
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_PRBS_CTRL,
-						SPICO_INT_DATA_PRBS31_AS_TXGEN, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-		if (err)
-			return err;
-
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_PRBS_CTRL,
-						SPICO_INT_DATA_PRBS31_AS_RXGEN, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-		if (err)
-			return err;
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+				SPICO_INT_CM4_PRBS_CTRL, SPICO_INT_DATA_PRBS31_AS_TXGEN, 0);
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+				SPICO_INT_CM4_PRBS_CTRL, SPICO_INT_DATA_PRBS31_AS_RXGEN, 0);
 	}
-	DEV_TRACE2(sbl->dev, "rc: 0");
-
-	return 0;
 }
 
-int sbl_serdes_polarity_ctrl(struct sbl_inst *sbl, int port_num, int serdes,
-			     int encoding, bool an)
+/* compile tx/rx polarity inversion and other config */
+static int sbl_serdes_script_polarity(struct sbl_serdes_script *script,
+		struct sbl_inst *sbl, int port_num, int serdes, int encoding, bool an)
 {
-	struct sbl_link *link = sbl->link + port_num;
 	u32 datapath = 0;
-	int err;
 
 	DEV_TRACE2(sbl->dev, "p%ds%d: encoding:0x%x", port_num, serdes, encoding);
 
@@ -2479,8 +2963,9 @@ int sbl_serdes_polarity_ctrl(struct sbl_inst *sbl, int port_num, int serdes,
 
 	// Set Precode
 	if (encoding == SBL_ENC_PAM4) {
-		link->precoding_enabled = get_serdes_precoding(sbl, port_num);
-		if (link->precoding_enabled)
+		script->set_precoding = true;
+		script->precoding_enabled = get_serdes_precoding(sbl, port_num);
+		if (script->precoding_enabled)
 			datapath |= SPICO_INT_DATA_SET_PRECODE;
 		else
 			datapath |= SPICO_INT_DATA_CLR_PRECODE;
@@ -2494,12 +2979,8 @@ int sbl_serdes_polarity_ctrl(struct sbl_inst *sbl, int port_num, int serdes,
 	else
 		datapath |= SPICO_INT_DATA_SET_GRAY_SWZ;
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_POLARITY_CTRL,
-					datapath, NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_POLARITY_CTRL, datapath, 0);
 
 	return 0;
 }
@@ -2557,11 +3038,11 @@ int sbl_set_tx_rx_enable(struct sbl_inst *sbl, int port_num, int serdes,
 	return 0;
 }
 
-int sbl_set_tx_eq(struct sbl_inst *sbl, int port_num, int serdes,
-		  int atten, int pre, int post, int pre2, int pre3)
+/* compile the tx equalization settings */
+static int sbl_serdes_script_tx_eq(struct sbl_serdes_script *script,
+		struct sbl_inst *sbl, int port_num, int serdes,
+		int atten, int pre, int post, int pre2, int pre3)
 {
-	int err, rc = 0;
-
 	DEV_TRACE2(sbl->dev,
 		   "p%ds%d: atten: %d pre: %d post: %d pre2: %d pre3: %d",
 		   port_num, serdes, atten, pre, post, pre2, pre3);
@@ -2597,56 +3078,29 @@ int sbl_set_tx_eq(struct sbl_inst *sbl, int port_num, int serdes,
 		return -EINVAL;
 	}
 
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TXEQ_LOAD,
-					SPICO_INT_DATA_SET_TXEQ_ATTEN |
-						(atten & SPICO_INT_DATA_TXEQ_DATA_MASK), NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
-
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TXEQ_LOAD,
-					SPICO_INT_DATA_SET_TXEQ_PRE1 |
-						(pre & SPICO_INT_DATA_TXEQ_DATA_MASK), NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
-
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TXEQ_LOAD,
-					SPICO_INT_DATA_SET_TXEQ_POST |
-						(post & SPICO_INT_DATA_TXEQ_DATA_MASK), NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
-
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TXEQ_LOAD,
-					SPICO_INT_DATA_SET_TXEQ_PRE2 |
-						(pre2 & SPICO_INT_DATA_TXEQ_DATA_MASK), NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
-
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_TXEQ_LOAD,
-					SPICO_INT_DATA_SET_TXEQ_PRE3 |
-						(pre3 & SPICO_INT_DATA_TXEQ_DATA_MASK), NULL,
-					SPICO_INT_VALIDATE_RESULT);
-	if (err)
-		return err;
-
-	DEV_TRACE2(sbl->dev, "rc: %d", rc);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TXEQ_LOAD,
+			SPICO_INT_DATA_SET_TXEQ_ATTEN | (atten & SPICO_INT_DATA_TXEQ_DATA_MASK), 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TXEQ_LOAD,
+			SPICO_INT_DATA_SET_TXEQ_PRE1 | (pre & SPICO_INT_DATA_TXEQ_DATA_MASK), 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TXEQ_LOAD,
+			SPICO_INT_DATA_SET_TXEQ_POST | (post & SPICO_INT_DATA_TXEQ_DATA_MASK), 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TXEQ_LOAD,
+			SPICO_INT_DATA_SET_TXEQ_PRE2 | (pre2 & SPICO_INT_DATA_TXEQ_DATA_MASK), 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, BIT(serdes),
+			SPICO_INT_CM4_TXEQ_LOAD,
+			SPICO_INT_DATA_SET_TXEQ_PRE3 | (pre3 & SPICO_INT_DATA_TXEQ_DATA_MASK), 0);
 
-	return rc;
+	return 0;
 }
 
-int sbl_set_gs(struct sbl_inst *sbl, int port_num, int serdes, int gs1, int gs2)
+/* compile the CTLE gainshape settings */
+static int sbl_serdes_script_gs(struct sbl_serdes_script *script,
+		struct sbl_inst *sbl, int port_num, int serdes, int gs1, int gs2)
 {
-	int err;
-	u16 result;
-
 	DEV_TRACE2(sbl->dev, "port: %d gs1: %d gs2: %d", port_num, gs1, gs2);
 
 	if ((gs1 < RXEQ_DFE_GS1_MIN) || (gs1 > RXEQ_DFE_GS1_MAX)) {
@@ -2662,62 +3116,10 @@ int sbl_set_gs(struct sbl_inst *sbl, int port_num, int serdes, int gs1, int gs2)
 		return -EINVAL;
 	}
 
-	if (!sbl->is_hw)
-		return 0;
-
-	/* Write GS1 */
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_READ,
-					SPICO_INT_DATA_HAL_CTLE_GS1,
-					&result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
-	DEV_TRACE2(sbl->dev,
-		   "p%ds%d: Updating GS1 from 0x%x to 0x%x",
-		   port_num, serdes, result, gs1);
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_WRITE,
-					gs1, &result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
-	if (result != SPICO_INT_CM4_HAL_READ) {
-		sbl_dev_err(sbl->dev,
-			"p%ds%d: Failed updating gs1 (0x%x)!",
-			port_num, serdes, gs1);
-		return -EBADE;
-	}
-
-	/* Write GS2 */
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_READ,
-					SPICO_INT_DATA_HAL_CTLE_GS2,
-					&result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
-	DEV_TRACE2(sbl->dev,
-		   "p%ds%d: Updating GS2 from 0x%x to 0x%x",
-		   port_num, serdes, result, gs2);
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_WRITE,
-					gs2, &result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
-	if (result != SPICO_INT_CM4_HAL_READ) {
-		sbl_dev_err(sbl->dev,
-			"p%ds%d: Failed updating gs2 (0x%x)!",
-			port_num, serdes, gs2);
-		return -EBADE;
-	}
-
-	DEV_TRACE2(sbl->dev, "rc: 0");
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_HAL_WRITE, BIT(serdes),
+			SPICO_INT_DATA_HAL_CTLE_GS1, gs1, 0);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_HAL_WRITE, BIT(serdes),
+			SPICO_INT_DATA_HAL_CTLE_GS2, gs2, 0);
 
 	return 0;
 }
@@ -2816,9 +3218,9 @@ int sbl_apply_sbus_divider(struct sbl_inst *sbl, int divider)
 		DEV_TRACE2(sbl->dev, "ring: %d divider_exp: %d", sbus_ring,
 			   divider);
 		// SBUS Critical Section
-		mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_BRINGUP);
 		err = sbl_sbus_wr(sbl, sbus_addr, SBM_CRM_ADDR_CLK_DIV, divider);
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		if (err)
 			return err;
 	}
@@ -2883,13 +3285,6 @@ int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 		   is_retune);
 
 	// Set effort level
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_READ,
-					SPICO_INT_DATA_ICAL_EFFORT_SEL, &result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
 	if (sbl_debug_option(sbl, port_num, SBL_DEBUG_FORCE_MAX_EFFORT)) {
 		link->ical_effort = SPICO_INT_DATA_ICAL_MAX_EFFORT;
 	} else if (sbl_debug_option(sbl, port_num, SBL_DEBUG_FORCE_MED_EFFORT)) {
@@ -2902,6 +3297,8 @@ int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 		link->ical_effort = SPICO_INT_DATA_ICAL_MED_EFFORT;
 	} else if (link->blattr.options & SBL_OPT_DFE_ALWAYS_MIN_EFFORT) {
 		link->ical_effort = SPICO_INT_DATA_ICAL_MIN_EFFORT;
+	} else if (link->dfe_effort < SBL_DFE_EFFORT_NUM) {
+		link->ical_effort = sbl_dfe_effort_ical(link->dfe_effort);
 	} else if (link->dfe_tune_count < 3) {
 		// medium effort for first few attempts
 		link->ical_effort = SPICO_INT_DATA_ICAL_MED_EFFORT;
@@ -2915,19 +3312,12 @@ int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 	if (!sbl->is_hw)
 		return 0;
 
-	DEV_TRACE2(sbl->dev, "p%ds%d: Updating ICAL effort from 0x%x to 0x%x",
-		   port_num, serdes, result, link->ical_effort);
-	err = sbl_serdes_spico_int(sbl, port_num, serdes,
-					SPICO_INT_CM4_HAL_WRITE,
-					link->ical_effort, &result,
-					SPICO_INT_RETURN_RESULT);
-	if (err)
-		return err;
-
-	if (result != SPICO_INT_CM4_HAL_READ) {
+	err = sbl_serdes_hal_set(sbl, port_num, serdes,
+				 SBL_HAL_SHADOW_ICAL_EFFORT, link->ical_effort);
+	if (err) {
 		sbl_dev_err(sbl->dev, "p%ds%d: Failed updating ICAL effort (0x%x)!",
 				port_num, serdes, link->ical_effort);
-		return -EBADE;
+		return err;
 	}
 	sbl_dev_dbg(sbl->dev, "p%ds%d: Setup ICAL effort 0x%x",
 			port_num, serdes, link->ical_effort);
@@ -2944,65 +3334,61 @@ int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 	return 0;
 }
 
-int sbl_serdes_dfe_tune_wait(struct sbl_inst *sbl, int port_num)
+/* poll the dfe status of the lanes still tuning, moving the ones which
+ * have finished from *in_progress_mask to *tuned_mask
+ */
+static int sbl_serdes_dfe_tune_poll(struct sbl_inst *sbl, int port_num,
+		u8 *in_progress_mask, u8 *tuned_mask)
 {
-	struct sbl_link *link = sbl->link + port_num;
 	u16 result;
 	int err, serdes;
-	u8 in_progress_mask, serdes_mask, tuned_mask = 0;
-	unsigned long last_jiffy;
-
-	serdes_mask = get_serdes_rx_mask(sbl, port_num);
-	in_progress_mask = serdes_mask;
 
-	DEV_TRACE2(sbl->dev, "p%d serdes_mask:0x%x", port_num, serdes_mask);
+	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+		if (!rx_serdes_required_for_link_mode(sbl, port_num, serdes))
+			continue;
 
-	last_jiffy = jiffies + msecs_to_jiffies(1000*link->blattr.dfe_timeout);
-	do {
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!rx_serdes_required_for_link_mode(sbl, port_num, serdes))
-				continue;
+		if (!((1 << serdes) & *in_progress_mask))
+			continue;
 
-			if (!((1 << serdes) & in_progress_mask))
-				continue;
+		err = sbl_serdes_spico_int(sbl, port_num, serdes,
+						SPICO_INT_CM4_GET_RX_EQ,
+						SPICO_INT_DATA_RXEQ_STS_DFE_STS,
+						&result, SPICO_INT_RETURN_RESULT);
+		if (err) {
+			sbl_dev_err(sbl->dev, "p%ds%d: Failed checking status of DFE tune!",
+				port_num, serdes);
+			return -EIO;
+		}
+		if (!sbl->is_hw)
+			result = DFE_CAL_DONE;
 
-			err = sbl_serdes_spico_int(sbl, port_num, serdes,
-							SPICO_INT_CM4_GET_RX_EQ,
-							SPICO_INT_DATA_RXEQ_STS_DFE_STS,
-							&result, SPICO_INT_RETURN_RESULT);
-			if (err) {
-				sbl_dev_err(sbl->dev, "p%ds%d: Failed checking status of DFE tune!",
-					port_num, serdes);
-				return -EIO;
-			}
-			if (!sbl->is_hw)
-				result = DFE_CAL_DONE;
-
-			if (result & DFE_LOS_MASK) {
-				sbl_dev_warn(sbl->dev, "p%ds%d: Loss of signal when in DFE tune!",
-					 port_num, serdes);
-				return -ENOMSG;
-			} else if (result & DFE_CAL_RUN_IN_PRGRS_MASK) {
-				sbl_dev_dbg(sbl->dev, "p%ds%d: DFE still in progress", port_num,
-					serdes);
-			} else if (result & DFE_CAL_DONE) {
-				sbl_dev_dbg(sbl->dev, "p%ds%d: DFE done", port_num,
-					serdes);
-				tuned_mask      |= (1 << serdes);
-				in_progress_mask &= ~(1 << serdes);
-			} else {
-				sbl_dev_dbg(sbl->dev, "p%ds%d: DFE complete", port_num, serdes);
-				tuned_mask      |= (1 << serdes);
-				in_progress_mask &= ~(1 << serdes);
-			}
+		if (result & DFE_LOS_MASK) {
+			sbl_dev_warn(sbl->dev, "p%ds%d: Loss of signal when in DFE tune!",
+				 port_num, serdes);
+			return -ENOMSG;
+		} else if (result & DFE_CAL_RUN_IN_PRGRS_MASK) {
+			sbl_dev_dbg(sbl->dev, "p%ds%d: DFE still in progress", port_num,
+				serdes);
+		} else if (result & DFE_CAL_DONE) {
+			sbl_dev_dbg(sbl->dev, "p%ds%d: DFE done", port_num,
+				serdes);
+			*tuned_mask      |= (1 << serdes);
+			*in_progress_mask &= ~(1 << serdes);
+		} else {
+			sbl_dev_dbg(sbl->dev, "p%ds%d: DFE complete", port_num, serdes);
+			*tuned_mask      |= (1 << serdes);
+			*in_progress_mask &= ~(1 << serdes);
 		}
-		if (!in_progress_mask)
-			break;
+	}
 
-		msleep(link->blattr.dfe_poll_interval);
-	} while (time_is_after_jiffies(last_jiffy) &&
-		 !sbl_start_timeout(sbl, port_num) &&
-		 !sbl_base_link_start_cancelled(sbl, port_num));
+	return 0;
+}
+
+/* the result of a dfe tune wait which has stopped polling */
+static int sbl_serdes_dfe_tune_result(struct sbl_inst *sbl, int port_num,
+		u8 serdes_mask, u8 tuned_mask)
+{
+	struct sbl_link *link = sbl->link + port_num;
 
 	if (serdes_mask == tuned_mask)
 		return 0;
@@ -3022,6 +3408,76 @@ int sbl_serdes_dfe_tune_wait(struct sbl_inst *sbl, int port_num)
 	return -ETIME;
 }
 
+int sbl_serdes_dfe_tune_wait(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	int err;
+	u8 in_progress_mask, serdes_mask, tuned_mask = 0;
+	unsigned long last_jiffy;
+
+	serdes_mask = get_serdes_rx_mask(sbl, port_num);
+	in_progress_mask = serdes_mask;
+
+	DEV_TRACE2(sbl->dev, "p%d serdes_mask:0x%x", port_num, serdes_mask);
+
+	last_jiffy = jiffies + msecs_to_jiffies(1000*link->blattr.dfe_timeout);
+	do {
+		err = sbl_serdes_dfe_tune_poll(sbl, port_num, &in_progress_mask,
+				&tuned_mask);
+		if (err)
+			return err;
+		if (!in_progress_mask)
+			break;
+
+		msleep(link->blattr.dfe_poll_interval);
+	} while (time_is_after_jiffies(last_jiffy) &&
+		 !sbl_start_timeout(sbl, port_num) &&
+		 !sbl_base_link_start_cancelled(sbl, port_num));
+
+	return sbl_serdes_dfe_tune_result(sbl, port_num, serdes_mask, tuned_mask);
+}
+
+/* start a dfe tune wait which is polled by sbl_serdes_dfe_tune_wait_step() */
+void sbl_serdes_dfe_tune_wait_begin(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_serdes_wait *serdes_wait = &link->serdes_wait;
+
+	serdes_wait->state = SBL_SERDES_WAIT_DFE_TUNE;
+	serdes_wait->serdes_mask = get_serdes_rx_mask(sbl, port_num);
+	serdes_wait->in_progress_mask = serdes_wait->serdes_mask;
+	serdes_wait->tuned_mask = 0;
+	serdes_wait->last_jiffy = jiffies + msecs_to_jiffies(1000*link->blattr.dfe_timeout);
+
+	DEV_TRACE2(sbl->dev, "p%d serdes_mask:0x%x", port_num, serdes_wait->serdes_mask);
+}
+
+/* one poll of a start's dfe tune wait
+ *
+ * returns -EINPROGRESS while lanes are still tuning and there is time
+ * left, the start resumes it after the poll interval
+ */
+int sbl_serdes_dfe_tune_wait_step(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_serdes_wait *serdes_wait = &link->serdes_wait;
+	int err;
+
+	err = sbl_serdes_dfe_tune_poll(sbl, port_num, &serdes_wait->in_progress_mask,
+			&serdes_wait->tuned_mask);
+	if (err)
+		return err;
+
+	if (serdes_wait->in_progress_mask &&
+			time_is_after_jiffies(serdes_wait->last_jiffy) &&
+			!sbl_start_timeout(sbl, port_num) &&
+			!sbl_base_link_start_cancelled(sbl, port_num))
+		return sbl_start_wait(sbl, port_num, link->blattr.dfe_poll_interval);
+
+	return sbl_serdes_dfe_tune_result(sbl, port_num, serdes_wait->serdes_mask,
+			serdes_wait->tuned_mask);
+}
+
 int sbl_port_dfe_tune_start(struct sbl_inst *sbl, int port_num, bool is_retune)
 {
 	int err, serdes;
@@ -3050,7 +3506,9 @@ int sbl_port_dfe_tune_wait(struct sbl_inst *sbl, int port_num)
 	int err;
 
 	// DFE Tune
-	err = sbl_serdes_dfe_tune_wait(sbl, port_num);
+	err = sbl_serdes_dfe_tune_wait_step(sbl, port_num);
+	if (err == -EINPROGRESS)
+		return err;
 	if (err) {
 		switch (err) {
 		case -ECANCELED:
@@ -3389,10 +3847,14 @@ int sbl_port_stop_pcal(struct sbl_inst *sbl, int port_num)
 }
 
 
-int sbl_port_dfe_tune(struct sbl_inst *sbl, int port_num, bool is_retune)
+int sbl_port_dfe_tune(struct sbl_inst *sbl, int port_num, bool is_retune,
+		bool resume)
 {
 	int err;
 
+	if (resume)
+		goto wait;
+
 	sbl_dev_dbg(sbl->dev, "p%d: Starting DFE %stune...", port_num,
 		is_retune ? "re" : "");
 
@@ -3405,7 +3867,11 @@ int sbl_port_dfe_tune(struct sbl_inst *sbl, int port_num, bool is_retune)
 	}
 
 	sbl_dev_dbg(sbl->dev, "p%d: Waiting for DFE tuning to complete...", port_num);
+	sbl_serdes_dfe_tune_wait_begin(sbl, port_num);
+wait:
 	err = sbl_port_dfe_tune_wait(sbl, port_num);
+	if (err == -EINPROGRESS)
+		return err;
 	if (err) {
 		sbl_dev_dbg(sbl->dev, "p%d: DFE tune failed!", port_num);
 		goto out;
@@ -3419,8 +3885,7 @@ out:
 int sbl_serdes_minitune_setup(struct sbl_inst *sbl, int port_num)
 {
 	int err;
-	u16 result;
-	int serdes;
+	unsigned long lanes;
 
 	err = sbl_serdes_config(sbl, port_num, false);
 	if (err) {
@@ -3430,64 +3895,28 @@ int sbl_serdes_minitune_setup(struct sbl_inst *sbl, int port_num)
 		return err;
 	}
 
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!rx_serdes_required_for_link_mode(sbl, port_num, serdes))
-			continue;
-		// Set effort level
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_READ,
-						SPICO_INT_DATA_ICAL_EFFORT_SEL,
-						&result,
-						SPICO_INT_RETURN_RESULT);
-		if (err)
-			return err;
-
-		DEV_TRACE2(sbl->dev,
-			   "p%ds%d: mt: Updating ICAL effort from 0x%x to 0x%x",
-			   port_num, serdes, result,
-			   SPICO_INT_DATA_ICAL_EFFORT_0);
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_WRITE,
-						SPICO_INT_DATA_ICAL_EFFORT_0,
-						&result,
-						SPICO_INT_RETURN_RESULT);
-		if (err)
-			return err;
-
-		if (result != SPICO_INT_CM4_HAL_READ) {
-			sbl_dev_err(sbl->dev,
-				"p%ds%d: mt: Failed updating ICAL effort (0x%x)!",
-				port_num, serdes, SPICO_INT_DATA_ICAL_EFFORT_0);
-			return -EBADE;
-		}
-		// Enable EID based on DFE tuning
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_READ,
-						SPICO_INT_DATA_EID_FILTER_SEL,
-						&result,
-						SPICO_INT_RETURN_RESULT);
-		if (err)
-			return err;
+	lanes = get_serdes_rx_required_mask(sbl, port_num);
+	if (!lanes)
+		return 0;
 
-		DEV_TRACE2(sbl->dev,
-			   "p%ds%d: mt: Updating EID Filter from 0x%x to 0x%x",
-			   port_num, serdes, result,
-			   SPICO_INT_DATA_EID_FILTER_DFE);
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_WRITE,
-						SPICO_INT_DATA_EID_FILTER_DFE,
-						&result,
-						SPICO_INT_RETURN_RESULT);
-		if (err)
-			return err;
+	// Set effort level
+	err = sbl_serdes_hal_set_lanes(sbl, port_num, lanes,
+				       SBL_HAL_SHADOW_ICAL_EFFORT,
+				       SPICO_INT_DATA_ICAL_EFFORT_0);
+	if (err) {
+		sbl_dev_err(sbl->dev, "p%d: mt: Failed updating ICAL effort (0x%x)!",
+			port_num, SPICO_INT_DATA_ICAL_EFFORT_0);
+		return err;
+	}
 
-		if (result != SPICO_INT_CM4_HAL_READ) {
-			sbl_dev_err(sbl->dev,
-				"p%ds%d: mt: Failed updating EID Filter (0x%x)!",
-				port_num, serdes,
-				SPICO_INT_DATA_EID_FILTER_DFE);
-			return -EBADE;
-		}
+	// Enable EID based on DFE tuning
+	err = sbl_serdes_hal_set_lanes(sbl, port_num, lanes,
+				       SBL_HAL_SHADOW_EID_FILTER,
+				       SPICO_INT_DATA_EID_FILTER_DFE);
+	if (err) {
+		sbl_dev_err(sbl->dev, "p%d: mt: Failed updating EID Filter (0x%x)!",
+			port_num, SPICO_INT_DATA_EID_FILTER_DFE);
+		return err;
 	}
 
 	return 0;
@@ -3498,7 +3927,6 @@ int sbl_serdes_minitune_block(struct sbl_inst *sbl, int port_num)
 	u64 core_status_value;
 	u8 sig_ok_mask = 0;
 	u8 tgt_serdes = 0;
-	u16 result;
 	int serdes;
 	int err;
 	u8 serdes_mask;
@@ -3549,38 +3977,15 @@ int sbl_serdes_minitune_block(struct sbl_inst *sbl, int port_num)
 	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
 		if (!rx_serdes_required_for_link_mode(sbl, port_num, serdes))
 			continue;
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_READ,
-						SPICO_INT_DATA_EID_FILTER_SEL,
-						&result,
-						SPICO_INT_RETURN_RESULT);
+		err = sbl_serdes_hal_set(sbl, port_num, serdes,
+					 SBL_HAL_SHADOW_EID_FILTER,
+					 SPICO_INT_DATA_EID_FILTER_OFF);
 		if (err) {
 			sbl_dev_err(sbl->dev,
-				"p%ds%d: mt block exit@1: sbl_serdes_spico_int failed [%d]",
-				port_num, serdes, err);
-			return err;
-		}
-		DEV_TRACE2(sbl->dev,
-			   "p%ds%d: Updating EID Filter from 0x%x to 0x%x",
-			   port_num, serdes, result,
-			   SPICO_INT_DATA_EID_FILTER_OFF);
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_HAL_WRITE,
-						SPICO_INT_DATA_EID_FILTER_OFF,
-						&result,
-						SPICO_INT_RETURN_RESULT);
-		if (err) {
-			sbl_dev_err(sbl->dev,
-				"p%ds%d: mt block exit@2: sbl_serdes_spico_int failed [%d]",
-				port_num, serdes, err);
-			return err;
-		}
-		if (result != SPICO_INT_CM4_HAL_READ) {
-			sbl_dev_err(sbl->dev,
-				"p%ds%d: mt: Failed updating EID Filter (0x%x)!",
+				"p%ds%d: mt: Failed updating EID Filter (0x%x) [%d]",
 				port_num, serdes,
-				SPICO_INT_DATA_EID_FILTER_OFF);
-			return -EBADE;
+				SPICO_INT_DATA_EID_FILTER_OFF, err);
+			return err;
 		}
 	}
 	// Make sure all tunes are complete
@@ -3604,33 +4009,183 @@ int sbl_serdes_minitune_block(struct sbl_inst *sbl, int port_num)
 	return err;
 }
 
-int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an)
+/* issue a config list interrupt, its result is only logged */
+static void sbl_serdes_script_config_int(struct sbl_inst *sbl, int port_num,
+		int serdes, const struct sbl_serdes_script_op *op)
+{
+	u16 result = 0;
+	int err;
+
+	sbl_dev_dbg(sbl->dev, "p%d: Applying interrupt 0x%x with data 0x%x",
+		port_num, op->code, op->data);
+	err = sbl_serdes_spico_int(sbl, port_num, serdes, op->code, op->data,
+				   &result, SPICO_INT_RETURN_RESULT);
+	if (err) {
+		sbl_dev_warn(sbl->dev, "p%ds%d: interrupt 0x%x data 0x%x failed!",
+			 port_num, serdes, op->code, op->data);
+	}
+	if (result != op->code) {
+		sbl_dev_dbg(sbl->dev,
+			 "p%ds%d: interrupt:0x%x data:0x%x result:0x%x != code:0x%x. This is okay in some cases.",
+			 port_num, serdes, op->code, op->data, result, op->code);
+	}
+}
+
+/* select a HAL address and write it */
+static int sbl_serdes_script_hal_write(struct sbl_inst *sbl, int port_num,
+		int serdes, u16 sel, u16 value)
 {
-	int err, encoding, divisor, width, serdes, j;
-	struct sbl_sc_values values = {0};
 	u16 result;
-	u32 rx_phase_slip_cnt;
-	u32 rx_phase_slip_reapply;
-	bool use_default_tx_eq, use_default_gs;
-	bool tx_en, rx_en, txo_en;
+	int err;
 
-	if (allow_an && (sbl->link[port_num].blattr.config_target != SBL_BASE_LINK_CONFIG_PEC)) {
-		sbl_dev_err(sbl->dev, "%d: AN allowed but has no config", port_num);
-		return -ENAVAIL;
+	if (!sbl->is_hw)
+		return 0;
+
+	err = sbl_serdes_spico_int(sbl, port_num, serdes,
+					SPICO_INT_CM4_HAL_READ, sel,
+					&result, SPICO_INT_RETURN_RESULT);
+	if (err)
+		return err;
+
+	DEV_TRACE2(sbl->dev, "p%ds%d: Updating HAL 0x%x from 0x%x to 0x%x",
+		   port_num, serdes, sel, result, value);
+	err = sbl_serdes_spico_int(sbl, port_num, serdes,
+					SPICO_INT_CM4_HAL_WRITE, value,
+					&result, SPICO_INT_RETURN_RESULT);
+	if (err)
+		return err;
+
+	if (result != SPICO_INT_CM4_HAL_READ) {
+		sbl_dev_err(sbl->dev, "p%ds%d: Failed updating HAL 0x%x (0x%x)!",
+			port_num, serdes, sel, value);
+		return -EBADE;
 	}
 
-	/* Stop continuous tune */
-	err = sbl_port_stop_pcal(sbl, port_num);
+	return 0;
+}
+
+/* compile the config values from the serdes config list */
+static int sbl_serdes_script_values(struct sbl_serdes_script *script,
+		struct sbl_inst *sbl, int port_num, int serdes)
+{
+	struct sbl_sc_values values = {0};
+	bool use_default_tx_eq = false;
+	bool use_default_gs = false;
+	int num_intr;
+	int err;
+	int j;
+
+	err = sbl_get_serdes_config_values(sbl, port_num, serdes, &values);
 	if (err) {
-		sbl_dev_warn(sbl->dev, "%d: serdes config: stop pcal failed [%d]",
-			port_num, err);
-		return err;
+		sbl_dev_warn(sbl->dev,
+				"p%ds%d: Unable to read config list!", port_num, serdes);
+		use_default_tx_eq = true;
+		use_default_gs    = true;
+	}
+	// Apply tx eq values
+	if (!use_default_tx_eq) {
+		err = sbl_serdes_script_tx_eq(script, sbl, port_num, serdes,
+					      values.atten, values.pre, values.post,
+					      values.pre2, values.pre3);
+		if (err) {
+			sbl_dev_warn(sbl->dev,
+					"Bad settings for port %d! Applying defaults.", port_num);
+			use_default_tx_eq = true;
+		}
+	}
+	if (use_default_tx_eq) {
+		err = sbl_serdes_script_tx_eq(script, sbl, port_num, serdes,
+					      SBL_DFLT_PORT_CONFIG_ATTEN,
+					      SBL_DFLT_PORT_CONFIG_PRE,
+					      SBL_DFLT_PORT_CONFIG_POST,
+					      SBL_DFLT_PORT_CONFIG_PRE2,
+					      SBL_DFLT_PORT_CONFIG_PRE3);
+		if (err) {
+			sbl_dev_err(sbl->dev, "Default serdes atten/pre/post settings failed!");
+			return err;
+		}
+	}
+	// Apply gainshape values
+	if (!use_default_gs) {
+		err = sbl_serdes_script_gs(script, sbl, port_num, serdes,
+					   values.gs1, values.gs2);
+		if (err) {
+			sbl_dev_warn(sbl->dev,
+					 "Bad gs1/gs2 settings for port %d! Applying defaults.", port_num);
+			use_default_gs = true;
+		}
+	}
+	if (use_default_gs) {
+		err = sbl_serdes_script_gs(script, sbl, port_num, serdes,
+					   SBL_DFLT_PORT_CONFIG_GS1,
+					   SBL_DFLT_PORT_CONFIG_GS2);
+		if (err) {
+			sbl_dev_err(sbl->dev,
+				"Default serdes gainshape settings failed!");
+			return err;
+		}
 	}
 
+	num_intr = min_t(u32, values.num_intr, SBL_SC_MAX_INTR);
+	if (num_intr) {
+		sbl_dev_dbg(sbl->dev,
+			"p%ds%d: Applying %d interrupts",
+			port_num, serdes, num_intr);
+	}
+	for (j = 0; j < num_intr; ++j)
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT_CONFIG, BIT(serdes),
+				values.intr_val[j], values.data_val[j], 0);
+
+	return 0;
+}
+
+/* get what the serdes config for a port depends on now */
+static void sbl_serdes_script_key_get(struct sbl_inst *sbl, int port_num,
+		bool allow_an, struct sbl_serdes_script_key *key)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	memset(key, 0, sizeof(*key));
+	key->allow_an          = allow_an;
+	key->an_mode           = link->blattr.pec.an_mode;
+	key->link_mode         = link->link_mode;
+	key->loopback_mode     = link->loopback_mode;
+	key->link_partner      = link->blattr.link_partner;
+	key->tuning_pattern    = link->blattr.tuning_pattern;
+	key->precoding         = link->blattr.precoding;
+	key->options           = link->blattr.options;
+	key->debug_config      = atomic_read(&link->debug_config);
+	key->rx_phase_slip_cnt = sbl->iattr.rx_phase_slip_cnt;
+	key->config_seq        = read_seqcount_begin(&sbl->serdes_config_seq);
+	key->tp_state_hash0    = sbl_get_tp_hash0(sbl, port_num);
+	key->tp_state_hash1    = sbl_get_tp_hash1(sbl, port_num);
+}
+
+/*
+ * sbl_serdes_script_compile() - Compile the serdes config for a port
+ *
+ * All the decisions (link mode, loopback, link partner, config list lookup,
+ * value checks and defaults) are made here, leaving a flat list of ops
+ * for sbl_serdes_script_run().
+ */
+static int sbl_serdes_script_compile(struct sbl_inst *sbl, int port_num,
+		bool allow_an, struct sbl_serdes_script *script)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	unsigned long lanes = get_serdes_required_mask(sbl, port_num);
+	u32 rx_phase_slip_cnt;
+	u32 rx_phase_slip_reapply;
+	int encoding, divisor, width, serdes;
+	u16 en;
+	int err;
+
+	script->set_precoding = false;
+	script->overflow = false;
+	script->num_ops = 0;
 
 	// Handle requested speed
 	if (allow_an) {
-		switch (sbl->link[port_num].blattr.pec.an_mode) {
+		switch (link->blattr.pec.an_mode) {
 		case SBL_AN_MODE_FIXED:
 		case SBL_AN_MODE_ON:
 			encoding = SBL_ENC_NRZ;
@@ -3640,12 +4195,12 @@ int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an)
 		case SBL_AN_MODE_OFF:
 		default:
 			sbl_dev_warn(sbl->dev, "%d: Unsupported an mode (%d)",
-				port_num, sbl->link[port_num].blattr.pec.an_mode);
+				port_num, link->blattr.pec.an_mode);
 			return -EINVAL;
 
 		}
 	} else {
-		switch (sbl->link[port_num].link_mode) {
+		switch (link->link_mode) {
 		case SBL_LINK_MODE_BJ_100G:
 			encoding = SBL_ENC_NRZ;
 			divisor  = SBL_DIV_25G;
@@ -3660,210 +4215,72 @@ int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an)
 			break;
 		default:
 			sbl_dev_warn(sbl->dev, "%d: Unsupported link mode (%d)",
-				port_num, sbl->link[port_num].link_mode);
+				port_num, link->link_mode);
 			return -EINVAL;
 		}
 	}
 
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-		      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-			continue;
-		err = sbl_serdes_init(sbl, port_num, serdes, encoding,
-					   divisor, width);
-		if (err)
-			return err;
-	}
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT)
+		sbl_serdes_script_init(script, sbl, port_num, serdes, encoding,
+				       divisor, width);
 
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-		      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-			continue;
-		err = sbl_serdes_polarity_ctrl(sbl, port_num, serdes,
-						    encoding, allow_an);
+	for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+		err = sbl_serdes_script_polarity(script, sbl, port_num, serdes,
+						 encoding, allow_an);
 		if (err)
 			return err;
 	}
 
 	// Set Rx Termination
-	switch (sbl->link[port_num].blattr.link_partner) {
+	switch (link->blattr.link_partner) {
 	case SBL_LINK_PARTNER_SWITCH:
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-			      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-				continue;
-			err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_INT_RX_TERM,
-						SPICO_INT_DATA_RXT_FLOAT, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-			if (err)
-				return err;
-		}
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+				SPICO_INT_CM4_INT_RX_TERM, SPICO_INT_DATA_RXT_FLOAT, 0);
 		break;
 	case SBL_LINK_PARTNER_NIC:
 	case SBL_LINK_PARTNER_NIC_C2:
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-			      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-				continue;
-			err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_INT_RX_TERM,
-						SPICO_INT_DATA_RXT_AVDD, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-			if (err)
-				return err;
-		}
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+				SPICO_INT_CM4_INT_RX_TERM, SPICO_INT_DATA_RXT_AVDD, 0);
 		break;
 	default:
 		sbl_dev_warn(sbl->dev, "p%d: Unsupported link partner mode (enum %d)!",
-			port_num, sbl->link[port_num].blattr.link_partner);
+			port_num, link->blattr.link_partner);
 		return -EINVAL;
 	}
 
 	// Handle requested loopback mode
-	switch (sbl->link[port_num].loopback_mode) {
+	switch (link->loopback_mode) {
 	case SBL_LOOPBACK_MODE_LOCAL:
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-			      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-				continue;
-			err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_LOOPBACK,
-						SPICO_INT_DATA_ILB, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-			if (err)
-				return err;
-		}
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+				SPICO_INT_CM4_LOOPBACK, SPICO_INT_DATA_ILB, 0);
 		break;
 	case SBL_LOOPBACK_MODE_REMOTE:
 	case SBL_LOOPBACK_MODE_OFF:
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-			      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-				continue;
-			err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_LOOPBACK,
-						SPICO_INT_DATA_ELB, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-			if (err)
-				return err;
-		}
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+				SPICO_INT_CM4_LOOPBACK, SPICO_INT_DATA_ELB, 0);
 		break;
 	default:
 		sbl_dev_warn(sbl->dev, "Unsupported loopback mode (enum %d)!",
-			 sbl->link[port_num].loopback_mode);
+			 link->loopback_mode);
 		return -EINVAL;
 	}
 
 	// Set port config values
 	if (!allow_an) {
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-			      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-				continue;
-			use_default_tx_eq = false;
-			use_default_gs    = false;
-			err = sbl_get_serdes_config_values(sbl, port_num,
-								serdes,
-								&values);
-			if (err) {
-				sbl_dev_warn(sbl->dev,
-						"p%ds%d: Unable to read config list!", port_num, serdes);
-				use_default_tx_eq = true;
-				use_default_gs    = true;
-			}
-			// Apply tx eq values
-			if (!use_default_tx_eq) {
-				err = sbl_set_tx_eq(sbl, port_num, serdes,
-							 values.atten,
-							 values.pre,
-							 values.post,
-							 values.pre2,
-							 values.pre3);
-				if (err) {
-					sbl_dev_warn(sbl->dev,
-							"Bad settings for port %d! Applying defaults.", port_num);
-					use_default_tx_eq = true;
-				}
-			}
-			if (use_default_tx_eq) {
-				err = sbl_set_tx_eq(sbl, port_num, serdes,
-						 SBL_DFLT_PORT_CONFIG_ATTEN,
-						 SBL_DFLT_PORT_CONFIG_PRE,
-						 SBL_DFLT_PORT_CONFIG_POST,
-						 SBL_DFLT_PORT_CONFIG_PRE2,
-						 SBL_DFLT_PORT_CONFIG_PRE3);
-				if (err) {
-					sbl_dev_err(sbl->dev, "Default serdes atten/pre/post settings failed!");
-					return err;
-				}
-			}
-			// Apply gainshape values
-			if (!use_default_gs) {
-				err = sbl_set_gs(sbl, port_num, serdes,
-						      values.gs1,
-						      values.gs2);
-				if (err) {
-					sbl_dev_warn(sbl->dev,
-							 "Bad gs1/gs2 settings for port %d! Applying defaults.", port_num);
-					use_default_gs = true;
-				}
-			}
-			if (use_default_gs) {
-				err = sbl_set_gs(sbl, port_num, serdes,
-					      SBL_DFLT_PORT_CONFIG_GS1,
-					      SBL_DFLT_PORT_CONFIG_GS2);
-				if (err) {
-					sbl_dev_err(sbl->dev,
-						"Default serdes gainshape settings failed!");
-					return err;
-				}
-			}
-
-			if (values.num_intr) {
-				sbl_dev_dbg(sbl->dev,
-					"p%ds%d: Applying %d interrupts",
-					port_num, serdes, values.num_intr);
-			}
-			for (j = 0; j < values.num_intr; ++j) {
-				sbl_dev_dbg(sbl->dev,
-				"p%d: Applying interrupt 0x%x with data 0x%x",
-				port_num, values.intr_val[j],
-				values.data_val[j]);
-				err = sbl_serdes_spico_int(sbl, port_num,
-						serdes, values.intr_val[j],
-						values.data_val[j], &result,
-						SPICO_INT_RETURN_RESULT);
-				if (err) {
-					sbl_dev_warn(sbl->dev,
-						 "p%ds%d: interrupt 0x%x data 0x%x failed!", port_num,
-						 serdes, values.intr_val[j], values.data_val[j]);
-				}
-				if (result != values.intr_val[j]) {
-					sbl_dev_dbg(sbl->dev,
-						 "p%ds%d: interrupt:0x%x data:0x%x result:0x%x != code:0x%x. This is okay in some cases.",
-						 port_num, serdes, values.intr_val[j], values.data_val[j], result, values.intr_val[j]);
-				}
-			}
+		for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+			err = sbl_serdes_script_values(script, sbl, port_num, serdes);
+			if (err)
+				return err;
 		}
 	}
 	// TODO - Set PRBS here
 
 	// Set Tx Phase Cal
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-		      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-			continue;
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_TX_PHASE_CAL,
-						SPICO_INT_DATA_TPCE, NULL,
-						SPICO_INT_VALIDATE_RESULT);
-		if (err)
-			return err;
-	}
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+			SPICO_INT_CM4_TX_PHASE_CAL, SPICO_INT_DATA_TPCE, 0);
 
 	// Set Rx Phase Slip
-	if (sbl->link[port_num].loopback_mode == SBL_LOOPBACK_MODE_LOCAL)
+	if (link->loopback_mode == SBL_LOOPBACK_MODE_LOCAL)
 		rx_phase_slip_reapply = 1;
 	else
 		rx_phase_slip_reapply = 0;
@@ -3880,121 +4297,253 @@ int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an)
 	sbl_dev_dbg(sbl->dev, "p%d: rx_phase_slip_reapply: 0x%x", port_num,
 		rx_phase_slip_reapply);
 
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-		      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-			continue;
-		err = sbl_serdes_spico_int(sbl, port_num, serdes,
-						SPICO_INT_CM4_RX_PHASE_SLIP,
-						(rx_phase_slip_reapply << SPICO_INT_DATA_RXP_APPLY_OFFSET) |
-						(rx_phase_slip_cnt << SPICO_INT_DATA_RX_PHASE_OFFSET), NULL,
-						SPICO_INT_VALIDATE_RESULT);
-		if (err)
-			return err;
-	}
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_INT, lanes,
+			SPICO_INT_CM4_RX_PHASE_SLIP,
+			(rx_phase_slip_reapply << SPICO_INT_DATA_RXP_APPLY_OFFSET) |
+			(rx_phase_slip_cnt << SPICO_INT_DATA_RX_PHASE_OFFSET), 0);
 
-	switch (sbl->link[port_num].loopback_mode) {
+	switch (link->loopback_mode) {
 	case SBL_LOOPBACK_MODE_LOCAL:
 		// Disable TX and RX
-		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-			err = sbl_set_tx_rx_enable(sbl, port_num, serdes,
-							false, false, false);
-			if (err)
-				return err;
-		}
+		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes)
+			sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(serdes),
+					0, 0, 0);
 		break;
 	case SBL_LOOPBACK_MODE_REMOTE:
 	case SBL_LOOPBACK_MODE_OFF:
 		// Disable TX
 		for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
+			en = 0;
 			if (rx_serdes_required_for_link_mode(sbl, port_num, serdes))
-				rx_en = true;
-			else
-				rx_en = false;
-			err = sbl_set_tx_rx_enable(sbl, port_num, serdes,
-							false, rx_en, false);
-			if (err)
-				return err;
+				en |= SBL_SCRIPT_EN_RX;
+			sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(serdes),
+					0, en, 0);
 		}
 		break;
-	default:
-		sbl_dev_warn(sbl->dev, "Unsupported loopback mode (enum %d)!",
-			 sbl->link[port_num].loopback_mode);
-		return -EINVAL;
 	}
 
-	msleep(20);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_DELAY, 0, 0, 20000, 0);
 
 	// Enable tx on physical lane 0 - this has the clock for all serdes and
 	//  is always required.
 	// rx based on link mode
-	if (rx_serdes_required_for_link_mode(sbl, port_num, 0))
-		rx_en = true;
-	else
-		rx_en = false;
 	// txo based on link mode
+	en = SBL_SCRIPT_EN_TX;
+	if (rx_serdes_required_for_link_mode(sbl, port_num, 0))
+		en |= SBL_SCRIPT_EN_RX;
 	if (get_serdes_tx_mask(sbl, port_num) & (1<<0))
-		txo_en = true;
-	else
-		txo_en = false;
-	err = sbl_set_tx_rx_enable(sbl, port_num, 0,
-					true, rx_en, txo_en);
-	if (err)
-		return err;
+		en |= SBL_SCRIPT_EN_TXO;
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(0), 0, en, 0);
 
-	usleep_range(1000, 2000);
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_DELAY, 0, 0, 1000, 0);
 
 	// Enable lane 1 2 3 as needed
 	for (serdes = 1; serdes < sbl->switch_info->num_serdes; ++serdes) {
+		en = 0;
 		if (rx_serdes_required_for_link_mode(sbl, port_num, serdes))
-			rx_en = true;
-		else
-			rx_en = false;
-		if (tx_serdes_required_for_link_mode(sbl, port_num, serdes)) {
-			tx_en = true;
-			txo_en = true;
-		} else {
-			tx_en = false;
-			txo_en = false;
+			en |= SBL_SCRIPT_EN_RX;
+		if (tx_serdes_required_for_link_mode(sbl, port_num, serdes))
+			en |= SBL_SCRIPT_EN_TX | SBL_SCRIPT_EN_TXO;
+		sbl_serdes_script_add(script, SBL_SCRIPT_OP_ENABLE, BIT(serdes), 0, en, 0);
+	}
+
+	sbl_serdes_script_add(script, SBL_SCRIPT_OP_DATA_SEL, lanes, 0,
+			(link->blattr.tuning_pattern == SBL_TUNING_PATTERN_CORE) ?
+			SBL_DS_CORE : SBL_DS_PRBS, 0);
+
+	if (script->overflow) {
+		sbl_dev_err(sbl->dev, "p%d: serdes config needs more than %d ops",
+			port_num, SBL_SERDES_SCRIPT_MAX_OPS);
+		return -E2BIG;
+	}
+
+	return 0;
+}
+
+/* replay a compiled serdes config */
+static int sbl_serdes_script_run(struct sbl_inst *sbl, int port_num,
+		const struct sbl_serdes_script *script)
+{
+	const struct sbl_serdes_script_op *op;
+	unsigned long lanes;
+	int serdes;
+	int err = 0;
+	int i;
+
+	if (script->set_precoding)
+		sbl->link[port_num].precoding_enabled = script->precoding_enabled;
+
+	for (i = 0; i < script->num_ops; ++i) {
+		op = script->ops + i;
+		lanes = op->lanes;
+
+		switch (op->type) {
+		case SBL_SCRIPT_OP_INT:
+			err = sbl_serdes_spico_int_lanes(sbl, port_num, op->lanes,
+							 op->code, op->data, NULL,
+							 SPICO_INT_VALIDATE_RESULT);
+			break;
+		case SBL_SCRIPT_OP_INT_CONFIG:
+			for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT)
+				sbl_serdes_script_config_int(sbl, port_num, serdes, op);
+			break;
+		case SBL_SCRIPT_OP_HAL_WRITE:
+			for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+				err = sbl_serdes_script_hal_write(sbl, port_num, serdes,
+								  op->code, op->data);
+				if (err)
+					break;
+			}
+			break;
+		case SBL_SCRIPT_OP_MEM_RMW:
+			for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT)
+				sbl_serdes_mem_rmw(sbl, port_num, serdes, op->code,
+						   op->data, op->arg);
+			break;
+		case SBL_SCRIPT_OP_ENABLE:
+			for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+				err = sbl_set_tx_rx_enable(sbl, port_num, serdes,
+							   op->data & SBL_SCRIPT_EN_TX,
+							   op->data & SBL_SCRIPT_EN_RX,
+							   op->data & SBL_SCRIPT_EN_TXO);
+				if (err)
+					break;
+			}
+			break;
+		case SBL_SCRIPT_OP_DATA_SEL:
+			for_each_set_bit(serdes, &lanes, SBL_SERDES_LANES_PER_PORT) {
+				err = sbl_set_tx_data_sel(sbl, port_num, serdes, op->data);
+				if (err)
+					break;
+			}
+			break;
+		case SBL_SCRIPT_OP_DELAY:
+			if (op->data > 10000)
+				msleep(op->data / 1000);
+			else
+				usleep_range(op->data, 2 * op->data);
+			break;
 		}
-		err = sbl_set_tx_rx_enable(sbl, port_num, serdes,
-						tx_en, rx_en, txo_en);
 		if (err)
 			return err;
 	}
 
-	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
-		if (!(rx_serdes_required_for_link_mode(sbl, port_num, serdes) ||
-		      tx_serdes_required_for_link_mode(sbl, port_num, serdes)))
-			continue;
-		if (sbl->link[port_num].blattr.tuning_pattern ==
-		    SBL_TUNING_PATTERN_CORE) {
-			err = sbl_set_tx_data_sel(sbl, port_num, serdes,
-						       SBL_DS_CORE);
-			if (err)
-				return err;
-		} else {
-			err = sbl_set_tx_data_sel(sbl, port_num, serdes,
-						       SBL_DS_PRBS);
-			if (err)
-				return err;
-		}
+	return 0;
+}
+
+/**
+ * sbl_serdes_config() - Configure the SerDes lanes for a given port
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @allow_an: configure for autoneg
+ *
+ * The configuration is compiled to a flat list of ops on first use and
+ * replayed on later starts and lp detect retries. It is only recompiled
+ * when something it depends on (link and an mode, loopback, link partner,
+ * media, serdes config list) changes.
+ *
+ * Context: Process context, link busy
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_serdes_script_key key;
+	int err;
+
+	if (allow_an && (link->blattr.config_target != SBL_BASE_LINK_CONFIG_PEC)) {
+		sbl_dev_err(sbl->dev, "%d: AN allowed but has no config", port_num);
+		return -ENAVAIL;
 	}
 
-	return 0;
+	/* Stop continuous tune */
+	err = sbl_port_stop_pcal(sbl, port_num);
+	if (err) {
+		sbl_dev_warn(sbl->dev, "%d: serdes config: stop pcal failed [%d]",
+			port_num, err);
+		return err;
+	}
+
+	sbl_serdes_script_key_get(sbl, port_num, allow_an, &key);
+
+	if (!link->serdes_script) {
+		link->serdes_script = kzalloc(sizeof(struct sbl_serdes_script), GFP_KERNEL);
+		if (!link->serdes_script)
+			return -ENOMEM;
+	} else if (link->serdes_script->num_ops &&
+		   !memcmp(&link->serdes_script->key, &key, sizeof(key))) {
+		goto run;
+	}
+
+	err = sbl_serdes_script_compile(sbl, port_num, allow_an, link->serdes_script);
+	if (err) {
+		link->serdes_script->num_ops = 0;
+		return err;
+	}
+	link->serdes_script->key = key;
+	sbl_dev_dbg(sbl->dev, "p%d: compiled serdes config (%d ops)",
+		port_num, link->serdes_script->num_ops);
+
+ run:
+	return sbl_serdes_script_run(sbl, port_num, link->serdes_script);
 }
 
 
-int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num)
+/* wait for the link partner to start before tuning, a second at a time */
+static int sbl_serdes_dfe_pre_delay(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link = sbl->link + port_num;
+
+	if (!link->serdes_wait.pre_delay_left) {
+		link->dfe_predelay_active = false;
+		return 0;
+	}
+
+	if (sbl_base_link_start_cancelled(sbl, port_num)) {
+		link->dfe_predelay_active = false;
+		return -ECANCELED;
+	}
+	if (sbl_start_timeout(sbl, port_num)) {
+		link->dfe_predelay_active = false;
+		return -ETIMEDOUT;
+	}
+
+	link->serdes_wait.pre_delay_left--;
+	return sbl_start_wait(sbl, port_num, 1000);
+}
+
+/*
+ * Tune the serdes of a port for a start
+ *
+ * The dfe pre delay and the waits for each tune to complete return
+ * -EINPROGRESS rather than sleeping, and tuning carries on from
+ * link->serdes_wait when called again with resume set.
+ */
+int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num, bool resume)
 {
 	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_serdes_wait *serdes_wait = &link->serdes_wait;
 	int err = 0;
 	int serdes;
 	bool is_retune;
-	int j;
+	bool is_seeded = false;
+
+	if (resume) {
+		is_retune = serdes_wait->is_retune;
+		is_seeded = serdes_wait->is_seeded;
+		if (serdes_wait->state == SBL_SERDES_WAIT_DFE_PRE_DELAY)
+			goto pre_delay;
+		goto tune;
+	}
 
 	sbl_dev_dbg(sbl->dev, "SerDes tuning for port %d", port_num);
 
+	/* a good tune from an earlier start never got to its fec up check */
+	spin_lock(&link->dfe_effort_lock);
+	link->dfe_effort_pending = false;
+	spin_unlock(&link->dfe_effort_lock);
+
 	mutex_lock(&link->tuning_params_mtx);
 	if (!(link->blattr.options & SBL_OPT_FABRIC_LINK)) {
 		sbl_dev_dbg(sbl->dev,
@@ -4011,12 +4560,19 @@ int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num)
 			(link->loopback_mode != SBL_LOOPBACK_MODE_LOCAL) &&
 			!sbl_debug_option(sbl, port_num, SBL_DEBUG_INHIBIT_USE_SAVED_TP)) {
 		is_retune = sbl_is_retune(sbl, port_num);
+		if (!is_retune && (link->blattr.options & SBL_OPT_DFE_PEER_SEED))
+			is_seeded = sbl_tp_peer_seed(sbl, port_num);
 	} else {
 		sbl_dev_dbg(sbl->dev,
 				"p%d: Usage of saved tuning params is disabled!",
 				port_num);
 		is_retune = false;
 	}
+	/* a full tune makes a new set rather than refining a remembered one */
+	if (!is_retune)
+		link->tp_active_slot = -1;
+	serdes_wait->is_retune = is_retune;
+	serdes_wait->is_seeded = is_seeded;
 
 	if (is_retune) {
 		sbl_dev_dbg(sbl->dev, "p%d: Applying saved tuning params",
@@ -4069,23 +4625,18 @@ int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num)
 	// This extra delay is about waiting for the link partner to start as we currently
 	// have no way of knowing this
 	//
-	if (link->blattr.dfe_pre_delay) {
+	serdes_wait->state = SBL_SERDES_WAIT_DFE_PRE_DELAY;
+	serdes_wait->pre_delay_left = link->blattr.dfe_pre_delay;
+	if (serdes_wait->pre_delay_left) {
 		sbl_dev_dbg(sbl->dev, "p%d: pre delay of %d seconds...", port_num,
 				link->blattr.dfe_pre_delay);
 		link->dfe_predelay_active = true;
-		for (j = 0; j < link->blattr.dfe_pre_delay; ++j) {
-			if (sbl_base_link_start_cancelled(sbl, port_num)) {
-				link->dfe_predelay_active = false;
-				return -ECANCELED;
-			}
-			if (sbl_start_timeout(sbl, port_num)) {
-				link->dfe_predelay_active = false;
-				return -ETIMEDOUT;
-			}
-			msleep(1000);
-		}
-		link->dfe_predelay_active = false;
 	}
+pre_delay:
+	err = sbl_serdes_dfe_pre_delay(sbl, port_num);
+	if (err)
+		return err;
+	resume = false;
 
 	//
 	// Try to tune, keep going unless error, cancelled, timeout
@@ -4095,14 +4646,32 @@ int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num)
 	// need to fail here and reset the serdes on the next cycle to clear out
 	// the current tuning params
 	//
-	sbl_dev_dbg(sbl->dev, "p%d: DFE %stune starting", port_num,
-		is_retune ? "re" : "");
+	sbl_dev_dbg(sbl->dev, "p%d: DFE %stune starting%s", port_num,
+		is_retune ? "re" : "", is_seeded ? " (seeded)" : "");
 
 	sbl_link_tune_zero_total_timespec(sbl, port_num);
 	link->dfe_tune_count = -1;
+tune:
 	while (true) {
-		link->dfe_tune_count++;
-		link->serr = sbl_port_dfe_tune(sbl, port_num, is_retune);
+		if (!resume) {
+			link->dfe_tune_count++;
+			if (is_seeded && !link->dfe_tune_count)
+				link->dfe_effort = SBL_DFE_EFFORT_MIN;
+			else if (link->blattr.options & SBL_OPT_DFE_ADAPTIVE_EFFORT)
+				link->dfe_effort = sbl_dfe_effort_choose(sbl, port_num);
+			else
+				link->dfe_effort = SBL_DFE_EFFORT_NUM;
+			serdes_wait->tune_start_ns = ktime_get_ns();
+		}
+		err = sbl_port_dfe_tune(sbl, port_num, is_retune, resume);
+		if (err == -EINPROGRESS)
+			return err;
+		resume = false;
+		link->serr = err;
+		/* a seeded tune says nothing about a cold one */
+		if (!(is_seeded && !link->dfe_tune_count))
+			sbl_dfe_effort_record(sbl, port_num, link->ical_effort,
+					link->serr, serdes_wait->tune_start_ns);
 
 		switch (link->serr) {
 		case 0:
@@ -4192,7 +4761,7 @@ int sbl_spico_reset(struct sbl_inst *sbl, int port_num)
 		sbl_dev_dbg(sbl->dev, "spico_reset: Sbus contention detected, sbus_ring_mtx[%d] locked", sbus_ring);
 
 	// SBUS Critical Section
-	mutex_lock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_lock(sbl, sbus_ring, SBL_SBUS_PRIO_BRINGUP);
 
 	/* Issue the reset */
 	for (serdes = 0; serdes < sbl->switch_info->num_serdes; ++serdes) {
@@ -4204,13 +4773,14 @@ int sbl_spico_reset(struct sbl_inst *sbl, int port_num)
 				SPICO_INT_DATA_PROC_RESET, NULL,
 				SPICO_INT_IGNORE_RESULT);
 		if (err) {
-			mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+			sbl_sbus_ring_unlock(sbl, sbus_ring);
 			sbl_dev_err(sbl->dev, "s%d: sbl_serdes_spico_int failed %d", sbus_ring, err);
 			return err;
 		}
 
 		// Increment SPICO reset counter
 		sbl_link_counters_incr(sbl, port_num, serdes0_spico_reset + serdes);
+		sbl_hal_shadow_invalidate(sbl, port_num, BIT(serdes));
 	}
 
 	/* Check that each lane has been reset */
@@ -4227,7 +4797,7 @@ int sbl_spico_reset(struct sbl_inst *sbl, int port_num)
 					       SBM_CRM_ADDR_PROC_STS,
 					       &result[serdes]);
 			if (err) {
-				mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+				sbl_sbus_ring_unlock(sbl, sbus_ring);
 				return err;
 			}
 
@@ -4262,13 +4832,13 @@ int sbl_spico_reset(struct sbl_inst *sbl, int port_num)
 		}
 	}
 	if (err) {
-		mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+		sbl_sbus_ring_unlock(sbl, sbus_ring);
 		return -ETIME;
 	}
 
 	sbl->link[port_num].pcal_running = false;
 
-	mutex_unlock(SBUS_RING_MTX(sbl, sbus_ring));
+	sbl_sbus_ring_unlock(sbl, sbus_ring);
 
 	sbl_dev_dbg(sbl->dev, "p%d: spico reset done", port_num);
 	return 0;
@@ -4300,6 +4870,7 @@ int sbl_reset_serdes_plls(struct sbl_inst *sbl, int port_num)
 
 		// Increment PLL reset counter
 		sbl_link_counters_incr(sbl, port_num, serdes0_pll_reset + serdes);
+		sbl_hal_shadow_invalidate(sbl, port_num, BIT(serdes));
 	}
 
 	return 0;
@@ -6,6 +6,14 @@
 
 #include <linux/hpe/sbl/sbl.h>
 
+/* serdes start waits, resumed rather than slept in */
+enum sbl_serdes_wait_state {
+	SBL_SERDES_WAIT_NONE,
+	SBL_SERDES_WAIT_OPTICAL_LOCK,
+	SBL_SERDES_WAIT_DFE_PRE_DELAY,
+	SBL_SERDES_WAIT_DFE_TUNE,
+};
+
 /* Get SBM firmware version from the given SBUS ring. */
 void sbl_sbm_get_fw_vers(struct sbl_inst *sbl, int sbus_ring, uint *fw_rev,
 		uint *fw_build);
@@ -32,6 +40,32 @@ int sbl_serdes_firmware_flash_safe(struct sbl_inst *sbl, int port_num,
 /* Check if CRC for target serdes lane is valid */
 int sbl_validate_serdes_fw_crc(struct sbl_inst *sbl, int port_num, int serdes);
 
+/* Check for a recent good CRC for target serdes lane */
+bool sbl_serdes_fw_crc_cached(struct sbl_inst *sbl, int port_num, int serdes);
+
+/* Remember a good CRC for target serdes lane */
+void sbl_serdes_fw_crc_record(struct sbl_inst *sbl, int port_num, int serdes);
+
+/* Forget all remembered CRCs for a port */
+void sbl_serdes_fw_crc_invalidate(struct sbl_inst *sbl, int port_num);
+
+/* Background SerDes/SBM firmware CRC scrub pass */
+void sbl_fw_scrub_work(struct work_struct *work);
+
+/* Parse rev and build from a firmware file name */
+int sbl_parse_version_string(struct sbl_inst *sbl, char *fw_fname,
+			     int *fw_rev, int *fw_build);
+
+/* Get the cached Sbus Master/SerDes firmware images */
+struct sbl_fw_image *sbl_sbm_fw_image_get(struct sbl_inst *sbl);
+struct sbl_fw_image *sbl_serdes_fw_image_get(struct sbl_inst *sbl);
+
+/* Release a firmware image */
+void sbl_fw_image_put(struct sbl_fw_image *image);
+
+/* Drop the cached firmware images */
+void sbl_fw_image_cache_flush(struct sbl_inst *sbl);
+
 /* Check if SerDes desired_rev matches flashed version */
 int sbl_validate_serdes_fw_vers(struct sbl_inst *sbl, int port_num, int serdes,
 				int fw_rev, int fw_build);
@@ -41,13 +75,13 @@ int sbl_validate_sbm_fw_vers(struct sbl_inst *sbl, u32 sbus_ring,
 			     int fw_rev, int fw_build);
 
 /* Upload target firmware image to single location */
-int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num, size_t fw_size,
-			   const u8 *fw_data);
+int sbl_serdes_firm_upload(struct sbl_inst *sbl, int port_num,
+			   const struct sbl_fw_image *fw);
 
 
 /* Upload target firmware image to multiple locations */
 int sbl_sbm_firm_upload(struct sbl_inst *sbl, int sbus_ring,
-			size_t fw_size, const u8 *fw_data);
+			const struct sbl_fw_image *fw);
 
 /* Ensures most tuning parameters for a given port are within range. */
 int sbl_check_serdes_tuning_params(struct sbl_inst *sbl, int port_num);
@@ -58,6 +92,13 @@ int sbl_save_serdes_tuning_params(struct sbl_inst *sbl, int port_num);
 /* Set a given SerDes tuning params */
 int sbl_apply_serdes_tuning_params(struct sbl_inst *sbl, int port, int serdes);
 
+/* Forget remembered tuning params for other configurations */
+void sbl_tp_history_invalidate(struct sbl_inst *sbl, int port_num, bool all);
+
+/* Record how well the active tuning params work */
+void sbl_tp_quality_up(struct sbl_inst *sbl, int port_num);
+void sbl_tp_quality_monitor(struct sbl_inst *sbl, int port_num, bool down);
+
 /* Perfrom dfe tune on a particular serdes */
 int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 			      bool is_retune);
@@ -65,10 +106,14 @@ int sbl_serdes_dfe_tune_start(struct sbl_inst *sbl, int port_num, int serdes,
 /* Wait for a particular serdes to complete its DFE tune */
 int sbl_serdes_dfe_tune_wait(struct sbl_inst *sbl, int port_num);
 
+/* Wait for a DFE tune during a start without sleeping */
+void sbl_serdes_dfe_tune_wait_begin(struct sbl_inst *sbl, int port_num);
+int sbl_serdes_dfe_tune_wait_step(struct sbl_inst *sbl, int port_num);
+
 /* Perfrom dfe tune on a port */
 int sbl_port_dfe_tune_start(struct sbl_inst *sbl, int port_num, bool is_retune);
 
-/* Wait for a port to complete its DFE tune */
+/* Poll a port's DFE tune, -EINPROGRESS until it completes */
 int sbl_port_dfe_tune_wait(struct sbl_inst *sbl, int port_num);
 
 /* Read and validate eye heights for a port */
@@ -82,8 +127,9 @@ int sbl_port_get_serdes_state_maps(struct sbl_inst *sbl, int port_num,
 /* Updates the state in the sbl struct from the tgt values */
 void sbl_update_internal_state(struct sbl_inst *sbl, int port_num);
 
-/* DFE tune a port */
-int sbl_port_dfe_tune(struct sbl_inst *sbl, int port_num, bool is_retune);
+/* DFE tune a port, -EINPROGRESS until resumed after the start wait */
+int sbl_port_dfe_tune(struct sbl_inst *sbl, int port_num, bool is_retune,
+		bool resume);
 
 /* Get the 6 eye heights */
 int sbl_get_eye_heights(struct sbl_inst *sbl, int port_num, int serdes,
@@ -92,30 +138,14 @@ int sbl_get_eye_heights(struct sbl_inst *sbl, int port_num, int serdes,
 /* Issues a soft SBus reset */
 int sbl_serdes_soft_reset(struct sbl_inst *sbl, int port_num, int serdes);
 
-/* Runs SerDes initization */
-int sbl_serdes_init(struct sbl_inst *sbl, int port_num, int serdes,
-		    int encoding, int divisor, int width);
-
-/* Applies tx/rx polarity inversion and other config */
-int sbl_serdes_polarity_ctrl(struct sbl_inst *sbl, int port_num, int serdes,
-			     int encoding, bool an);
-
 /* Enables/Disabled SerDes Tx/Rx */
 int sbl_set_tx_rx_enable(struct sbl_inst *sbl, int port_num, int serdes,
 			 bool tx_en, bool rx_en, bool txo_en);
 
-/* Sets the CTLE parameters */
-int sbl_set_gs(struct sbl_inst *sbl, int port_num, int serdes, int gs1,
-	       int gs2);
-
 /* Sets the TX data select */
 int sbl_set_tx_data_sel(struct sbl_inst *sbl, int port_num, int serdes,
 			int data_sel);
 
-/* Sets the TX data select */
-int sbl_set_tx_eq(struct sbl_inst *sbl, int port_num, int serdes,
-		  int atten, int pre, int post, int pre2, int pre3);
-
 /* Sets the Rx compare mode and data, qualification, and performs an
  *	error reset
  */
@@ -139,8 +169,8 @@ int sbl_serdes_minitune_block(struct sbl_inst *sbl, int port_num);
 /* Configure the SerDes lanes for a given port */
 int sbl_serdes_config(struct sbl_inst *sbl, int port_num, bool allow_an);
 
-/* Tune the SerDes lanes for a given port */
-int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num);
+/* Tune the SerDes lanes for a given port, -EINPROGRESS while waiting */
+int sbl_serdes_tuning(struct sbl_inst *sbl, int port_num, bool resume);
 
 /* Reset SPICO micro */
 int sbl_spico_reset(struct sbl_inst *sbl, int port_num);
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* Copyright 2025 Hewlett Packard Enterprise Development LP */
+
+#include <linux/kernel.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include <linux/hpe/sbl/sbl.h>
+
+#include "sbl_constants.h"
+#include "sbl_internal.h"
+
+/*
+ * SPICO interrupt profiler
+ *
+ * Counts, errors, timeouts and a log2 us latency histogram for each
+ * interrupt code. Serdes interrupts are kept for each port and for the
+ * instance, sbus master interrupts (a different code space) for the
+ * instance only. Each table holds the first SBL_SPICO_PROF_CODES codes
+ * seen; any more are only counted as overflow.
+ */
+
+static void sbl_spico_prof_add(struct sbl_spico_prof *prof, int code,
+		u64 ns, int err, int num)
+{
+	struct sbl_spico_prof_entry *entry;
+	int bucket;
+	u64 us;
+	int i;
+
+	us = div_u64(ns, NSEC_PER_USEC);
+	bucket = us ? min_t(int, ilog2(us), SBL_SPICO_PROF_HIST_SIZE - 1) : 0;
+
+	spin_lock(&prof->lock);
+
+	for (i = 0; i < prof->num_codes; ++i) {
+		if (prof->entry[i].code == code)
+			break;
+	}
+	if (i == prof->num_codes) {
+		if (prof->num_codes == SBL_SPICO_PROF_CODES) {
+			prof->overflow += num;
+			goto out;
+		}
+		prof->entry[prof->num_codes++].code = code;
+	}
+
+	entry = prof->entry + i;
+	entry->count += num;
+	if (err == -ETIME || err == -ETIMEDOUT)
+		entry->timeouts += num;
+	else if (err)
+		entry->errors += num;
+	entry->total_ns += ns * num;
+	entry->max_ns = max(entry->max_ns, ns);
+	entry->hist[bucket] += num;
+
+ out:
+	spin_unlock(&prof->lock);
+}
+
+/**
+ * sbl_spico_prof_serdes() - Record serdes spico interrupts
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @code: interrupt code
+ * @start_ns: ktime the interrupts were issued
+ * @err: result of the interrupts
+ * @num_lanes: number of lanes interrupted
+ *
+ * Lanes interrupted together are each recorded with the average latency.
+ */
+void sbl_spico_prof_serdes(struct sbl_inst *sbl, int port_num, int code,
+		u64 start_ns, int err, int num_lanes)
+{
+	u64 ns;
+
+	if (num_lanes <= 0)
+		return;
+
+	ns = div_u64(ktime_get_ns() - start_ns, num_lanes);
+
+	if (port_num >= 0 && port_num < sbl->switch_info->num_ports)
+		sbl_spico_prof_add(&sbl->link[port_num].spico_prof, code, ns, err, num_lanes);
+	sbl_spico_prof_add(sbl->spico_prof + SBL_SPICO_PROF_SERDES, code, ns, err, num_lanes);
+}
+
+/**
+ * sbl_spico_prof_sbm() - Record an sbus master spico interrupt
+ * @sbl: A slingshot base link device instance
+ * @code: interrupt code
+ * @start_ns: ktime the interrupt was issued
+ * @err: result of the interrupt
+ */
+void sbl_spico_prof_sbm(struct sbl_inst *sbl, int code, u64 start_ns, int err)
+{
+	sbl_spico_prof_add(sbl->spico_prof + SBL_SPICO_PROF_SBM, code,
+			ktime_get_ns() - start_ns, err, 1);
+}
+
+/* setup a profile table */
+void sbl_spico_prof_init(struct sbl_spico_prof *prof)
+{
+	spin_lock_init(&prof->lock);
+	prof->num_codes = 0;
+	prof->overflow = 0;
+	memset(prof->entry, 0, sizeof(prof->entry));
+}
+
+static void sbl_spico_prof_zero(struct sbl_spico_prof *prof)
+{
+	spin_lock(&prof->lock);
+	prof->num_codes = 0;
+	prof->overflow = 0;
+	memset(prof->entry, 0, sizeof(prof->entry));
+	spin_unlock(&prof->lock);
+}
+
+/**
+ * sbl_spico_prof_clear() - Reset the spico interrupt profile
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number, or SBL_ALL_PORTS for every port and the instance
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_spico_prof_clear(struct sbl_inst *sbl, int port_num)
+{
+	int err;
+	int i;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (port_num != SBL_ALL_PORTS) {
+		err = sbl_validate_port_num(sbl, port_num);
+		if (err)
+			return err;
+		sbl_spico_prof_zero(&sbl->link[port_num].spico_prof);
+		return 0;
+	}
+
+	for (i = 0; i < sbl->switch_info->num_ports; ++i)
+		sbl_spico_prof_zero(&sbl->link[i].spico_prof);
+	for (i = 0; i < SBL_SPICO_PROF_NUM; ++i)
+		sbl_spico_prof_zero(sbl->spico_prof + i);
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_spico_prof_clear);
+
+#ifdef CONFIG_SYSFS
+static int sbl_spico_prof_sprint(struct sbl_spico_prof *prof, const char *name,
+		char *buf, size_t size)
+{
+	struct sbl_spico_prof_entry entry;
+	int num_codes;
+	int bucket;
+	int i;
+	int s = 0;
+
+	spin_lock(&prof->lock);
+	num_codes = prof->num_codes;
+	spin_unlock(&prof->lock);
+
+	for (i = 0; (i < num_codes) && (s < size - 1); ++i) {
+		spin_lock(&prof->lock);
+		entry = prof->entry[i];
+		spin_unlock(&prof->lock);
+
+		if (!entry.count)
+			continue;
+
+		s += scnprintf(buf+s, size-s, "%s 0x%02x: count %u, err %u, timeout %u, mean %llu, max %llu, hist",
+				name, entry.code, entry.count, entry.errors, entry.timeouts,
+				div_u64(div_u64(entry.total_ns, entry.count), NSEC_PER_USEC),
+				div_u64(entry.max_ns, NSEC_PER_USEC));
+		for (bucket = 0; bucket < SBL_SPICO_PROF_HIST_SIZE; ++bucket) {
+			if (entry.hist[bucket])
+				s += scnprintf(buf+s, size-s, " %lu:%u",
+						BIT(bucket), entry.hist[bucket]);
+		}
+		s += scnprintf(buf+s, size-s, "\n");
+	}
+
+	if (prof->overflow)
+		s += scnprintf(buf+s, size-s, "%s other: count %u\n", name, prof->overflow);
+
+	return s;
+}
+
+/**
+ * sbl_spico_prof_sysfs_sprint() - Print the spico interrupt profile
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number, or SBL_ALL_PORTS for the instance totals
+ * @buf: Destination buffer to write the data
+ * @size: Size of data to write
+ *
+ * One line per interrupt code: count, errors, timeouts, mean and max
+ * latency and the non-empty log2 histogram buckets (all us). The
+ * instance totals include the sbus master interrupts.
+ *
+ * Return: Number of characters on success, negative error on failure
+ */
+int sbl_spico_prof_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size)
+{
+	int s = 0;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	if (buf == NULL || size == 0U)
+		return -ENOMEM;
+
+	if (port_num != SBL_ALL_PORTS) {
+		err = sbl_validate_port_num(sbl, port_num);
+		if (err)
+			return err;
+		return sbl_spico_prof_sprint(&sbl->link[port_num].spico_prof,
+				"serdes", buf, size);
+	}
+
+	s += sbl_spico_prof_sprint(sbl->spico_prof + SBL_SPICO_PROF_SERDES,
+			"serdes", buf+s, size-s);
+	s += sbl_spico_prof_sprint(sbl->spico_prof + SBL_SPICO_PROF_SBM,
+			"sbm", buf+s, size-s);
+
+	return s;
+}
+EXPORT_SYMBOL(sbl_spico_prof_sysfs_sprint);
+#endif
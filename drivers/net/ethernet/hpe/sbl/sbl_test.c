@@ -389,6 +389,12 @@ void sbl_test_manipulate_serdes_fw_crc_result(u16 *crc_result)
 		*crc_result = SPICO_RESULT_SERDES_CRC_FAIL;
 }
 
+/* Cached CRC results must not hide an injected failure */
+bool sbl_test_serdes_fw_crc_failure_injected(void)
+{
+	return sbl_test_crc_failure;
+}
+
 /**
  * sbl_test_inject_serdes_fw_crc_failure() - Test to inject crc failure for serdes fw
  * @set: if set then inject crc
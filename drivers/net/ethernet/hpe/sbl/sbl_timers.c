@@ -6,7 +6,9 @@
 #include <linux/kernel.h>
 #include <linux/device.h>
 #include <linux/delay.h>
+#include <linux/slab.h>
 #include <linux/ktime.h>
+#include <linux/log2.h>
 
 #include <linux/hpe/sbl/sbl.h>
 #include <linux/hpe/sbl/sbl_kconfig.h>
@@ -74,6 +76,35 @@ bool sbl_start_timeout(struct sbl_inst *sbl, int port_num)
 }
 
 
+/*
+ * resumable start waits
+ *
+ * A start phase which has to wait for the hardware or the link partner
+ * returns -EINPROGRESS from here instead of sleeping, with its progress
+ * kept in the link, and is run again with resume set once the wait is
+ * over. The blocking start sleeps for the wait, the non-blocking start
+ * requeues its work with the wait as the delay.
+ */
+int sbl_start_wait(struct sbl_inst *sbl, int port_num, unsigned int wait_ms)
+{
+	sbl->link[port_num].start_wait_ms = wait_ms;
+
+	return -EINPROGRESS;
+}
+
+
+/* sleep for the wait a start phase asked for */
+void sbl_start_wait_sleep(struct sbl_inst *sbl, int port_num)
+{
+	unsigned int wait_ms = sbl->link[port_num].start_wait_ms;
+
+	if (wait_ms < 20)
+		usleep_range(wait_ms * 1000, wait_ms * 1000 + 100);
+	else
+		msleep(wait_ms);
+}
+
+
 u32 sbl_get_start_timeout(struct sbl_inst *sbl, int port_num)
 {
 	struct sbl_link *link = sbl->link + port_num;
@@ -237,3 +268,173 @@ void sbl_link_tune_update_total_timespec(struct sbl_inst *sbl, int port_num)
 	link->total_tune_time.tv_nsec = ns;
 	spin_unlock(&link->timeout_lock);
 }
+
+
+/*
+ * bring-up phase latencies
+ *
+ * each phase keeps a log2 histogram and the last few samples
+ */
+void sbl_link_phase_record(struct sbl_inst *sbl, int port_num, int phase,
+		ktime_t begin, int err)
+{
+	struct sbl_link *link = sbl->link + port_num;
+	struct sbl_link_phase_stats *stats;
+	s64 elapsed_us;
+	u32 us;
+	int bucket;
+
+	if ((phase < 0) || (phase >= SBL_LINK_PHASE_NUM))
+		return;
+
+	elapsed_us = ktime_us_delta(ktime_get(), begin);
+	us = clamp_t(s64, elapsed_us, 0, U32_MAX);
+	bucket = us ? min_t(int, ilog2(us), SBL_LINK_PHASE_HIST_BUCKETS - 1) : 0;
+
+	sbl_dev_dbg(sbl->dev, "%d: phase %s took %u us [%d]\n", port_num,
+			sbl_link_phase_str(phase), us, err);
+
+	spin_lock(&link->phase_stats_lock);
+	stats = link->phase_stats + phase;
+	if (!stats->count || (us < stats->min))
+		stats->min = us;
+	if (us > stats->max)
+		stats->max = us;
+	stats->count++;
+	if (err)
+		stats->errors++;
+	stats->total += us;
+	stats->hist[bucket]++;
+	stats->samples[stats->next_sample] = us;
+	stats->next_sample = (stats->next_sample + 1) % SBL_LINK_PHASE_NUM_SAMPLES;
+	spin_unlock(&link->phase_stats_lock);
+}
+
+
+/**
+ * sbl_link_phase_stats_get() - Get a block of link bring-up phase latencies
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @stats: Array to receive 'count' phase records
+ * @first: Index of the first phase to read
+ * @count: Number of consecutive phases to read starting from 'first'
+ *
+ * Context: Process context, Acquires lock and releases phase_stats_lock <spin_lock>
+ *
+ * Return: 0 on success, negative error code on failure
+ */
+int sbl_link_phase_stats_get(struct sbl_inst *sbl, int port_num,
+		struct sbl_link_phase_stats *stats, u16 first, u16 count)
+{
+	struct sbl_link *link;
+	int err;
+
+	err = sbl_validate_instance(sbl);
+	if (err)
+		return err;
+
+	err = sbl_validate_port_num(sbl, port_num);
+	if (err)
+		return err;
+
+	if ((first + count) > SBL_LINK_PHASE_NUM)
+		return -EINVAL;
+
+	if (!stats)
+		return -EINVAL;
+
+	link = sbl->link + port_num;
+
+	spin_lock(&link->phase_stats_lock);
+	memcpy(stats, link->phase_stats + first, count * sizeof(*stats));
+	spin_unlock(&link->phase_stats_lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(sbl_link_phase_stats_get);
+
+
+/**
+ * sbl_link_phase_stats_clear() - Clear the link bring-up phase latencies
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ *
+ * Context: Process context, Acquires lock and releases phase_stats_lock <spin_lock>
+ */
+void sbl_link_phase_stats_clear(struct sbl_inst *sbl, int port_num)
+{
+	struct sbl_link *link;
+
+	if (sbl_validate_instance(sbl) || sbl_validate_port_num(sbl, port_num))
+		return;
+
+	link = sbl->link + port_num;
+
+	spin_lock(&link->phase_stats_lock);
+	memset(link->phase_stats, 0, sizeof(link->phase_stats));
+	spin_unlock(&link->phase_stats_lock);
+}
+EXPORT_SYMBOL(sbl_link_phase_stats_clear);
+
+
+#ifdef CONFIG_SYSFS
+/**
+ * sbl_link_phase_sysfs_sprint() - Format link bring-up phase latencies into buffer
+ * @sbl: A slingshot base link device instance
+ * @port_num: port number
+ * @buf: Destination buffer to write the data
+ * @size: Size of data to write
+ *
+ * One line per phase that has run: count, errors, min/mean/max, the
+ * non-empty log2 histogram buckets and the most recent samples (all us).
+ *
+ * Return: Number of characters written on success
+ */
+int sbl_link_phase_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size)
+{
+	struct sbl_link_phase_stats *stats;
+	int phase;
+	int bucket;
+	int i;
+	int s = 0;
+
+	stats = kcalloc(SBL_LINK_PHASE_NUM, sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return 0;
+
+	if (sbl_link_phase_stats_get(sbl, port_num, stats, 0, SBL_LINK_PHASE_NUM))
+		goto out;
+
+	for (phase = 0; phase < SBL_LINK_PHASE_NUM; ++phase) {
+		if (!stats[phase].count)
+			continue;
+
+		s += scnprintf(buf+s, size-s, "%s: count %u, err %u, min %u, mean %llu, max %u, hist",
+				sbl_link_phase_str(phase), stats[phase].count,
+				stats[phase].errors, stats[phase].min,
+				div_u64(stats[phase].total, stats[phase].count),
+				stats[phase].max);
+
+		for (bucket = 0; bucket < SBL_LINK_PHASE_HIST_BUCKETS; ++bucket) {
+			if (stats[phase].hist[bucket])
+				s += scnprintf(buf+s, size-s, " %lu:%u",
+						BIT(bucket), stats[phase].hist[bucket]);
+		}
+
+		s += scnprintf(buf+s, size-s, ", last");
+		for (i = 1; i <= min_t(u32, stats[phase].count, SBL_LINK_PHASE_NUM_SAMPLES); ++i)
+			s += scnprintf(buf+s, size-s, " %u",
+					stats[phase].samples[(stats[phase].next_sample +
+					SBL_LINK_PHASE_NUM_SAMPLES - i) % SBL_LINK_PHASE_NUM_SAMPLES]);
+
+		s += scnprintf(buf+s, size-s, "\n");
+	}
+
+out:
+	kfree(stats);
+
+	return s;
+}
+EXPORT_SYMBOL(sbl_link_phase_sysfs_sprint);
+#endif
+
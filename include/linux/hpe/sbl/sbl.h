@@ -7,6 +7,8 @@
 
 #include <linux/types.h>
 #include <linux/mutex.h>
+#include <linux/seqlock.h>
+#include <linux/workqueue.h>
 #include <linux/firmware.h>
 
 #include <uapi/ethernet/sbl-abi.h>
@@ -30,6 +32,9 @@
 /* min size of buffer for base link state string */
 #define SBL_BASE_LINK_STATE_STR_LEN	     (SBL_PCS_STATE_STR_LEN + 16)
 
+/* serdes core interrupt codes with a learned completion time */
+#define SBL_SERDES_OP_CODES		    256
+
 struct sbl_tuning_params;
 struct sbl_sc_values;
 struct sbl_serdes_config;
@@ -116,6 +121,51 @@ enum sbl_fec_discard_type {
 };
 
 
+/**
+ * @brief Phases of base link start
+ */
+enum sbl_start_phase {
+	SBL_START_PHASE_FW_CHECK = 0,	  /**< serdes firmware check/recovery */
+	SBL_START_PHASE_GET_MODE,	  /**< link mode (autoneg) */
+	SBL_START_PHASE_AM_START,	  /**< start sending alignment markers */
+	SBL_START_PHASE_LPD,		  /**< link partner detect */
+	SBL_START_PHASE_SERDES_START,	  /**< serdes start and tuning */
+	SBL_START_PHASE_PML_START,	  /**< pcs, mac and llr start */
+	SBL_START_PHASE_FEC_SETUP,	  /**< fec thresholds and adjustments */
+	SBL_START_PHASE_FEC_UP_CHECK,	  /**< fec up check */
+	SBL_START_PHASE_FAULT_MON,	  /**< start link fault monitoring */
+	SBL_START_PHASE_LINK_CHECK,	  /**< final pcs and lane check */
+	SBL_START_PHASE_NUM,
+};
+
+
+/**
+ * @brief Timed phases of link bring-up
+ *
+ * The start phases followed by the phases of sbl_pml_start()
+ */
+enum sbl_link_phase {
+	SBL_LINK_PHASE_PML_PCS_WAIT = SBL_START_PHASE_NUM, /**< pcs lock and alignment */
+	SBL_LINK_PHASE_PML_LLR_START,			   /**< llr loop timing and ready */
+	SBL_LINK_PHASE_NUM,
+};
+
+#define SBL_LINK_PHASE_HIST_BUCKETS	     24
+#define SBL_LINK_PHASE_NUM_SAMPLES	      8
+
+/* latency record for a link bring-up phase (all times in us) */
+struct sbl_link_phase_stats {
+	u32 count;					   /* times the phase ran */
+	u32 errors;					   /* times the phase failed */
+	u32 min;
+	u32 max;
+	u64 total;
+	u32 hist[SBL_LINK_PHASE_HIST_BUCKETS];		   /* bucket n counts [2^n, 2^(n+1)) us */
+	u32 samples[SBL_LINK_PHASE_NUM_SAMPLES];	   /* most recent times */
+	u32 next_sample;				   /* next samples slot to fill */
+};
+
+
 /**
  * @brief Link Partner Type
  */
@@ -127,6 +177,21 @@ enum sbl_lp_subtype {
 };
 
 
+/* One op of an sbus op batch
+ *
+ * req_data, data_addr, rx_addr and command are filled in by sbl,
+ * rsp_data, result_code and overrun by the batch op.
+ */
+struct sbl_sbus_op_desc {
+	u32 req_data;
+	u8  data_addr;
+	u8  rx_addr;
+	u8  command;
+	u8  result_code;
+	u8  overrun;
+	u32 rsp_data;
+};
+
 /* Operations provided by the calling framework */
 struct sbl_ops {
 	/* register access */
@@ -154,6 +219,18 @@ struct sbl_ops {
 
 	/* async alert */
 	void (*sbl_async_alert)(void *accessor, int port_num, int alert_type, void *alert_data, int size);
+
+	/* base link start completion (optional) */
+	void (*sbl_link_start_complete)(void *accessor, int port_num, int err);
+
+	/* sbus op batch (optional)
+	 *   runs the ops in order on one ring, stopping at the first op
+	 *   with an error or overrun. Returns the number of leading ops
+	 *   completed or a negative error if the batch could not be run.
+	 */
+	int (*sbl_sbus_op_batch)(void *accessor, int ring,
+			struct sbl_sbus_op_desc *desc, int num_ops,
+			int timeout, unsigned int flags);
 };
 
 struct lane_degrade {
@@ -169,6 +246,12 @@ struct fec_data {
 	struct work_struct fec_timer_work;
 };
 
+struct sbl_fw_image;
+struct sbl_sbus_op_log;
+struct sbl_sbus_prof;
+struct sbl_sbus_arb;
+struct sbl_spico_prof;
+
 /* A slingshot base link device instance */
 struct sbl_inst {
 	int magic;
@@ -185,6 +268,7 @@ struct sbl_inst {
 
 	struct list_head serdes_config_list;	 /* list of serdes configurations */
 	spinlock_t serdes_config_lock;		 /* lock serdes configurations list */
+	seqcount_t serdes_config_seq;		 /* bumped on each configurations list change */
 
 	struct sbl_link *link;			 /* link database */
 
@@ -196,7 +280,23 @@ struct sbl_inst {
 
 	atomic_t *sbm_fw_reload_count;		 /* counter to track sbus master fw reload */
 
+	struct sbl_sbus_op_log *sbus_op_log;	 /* binary log of recent sbus ops for each ring */
+
+	struct sbl_sbus_prof *sbus_prof;	 /* sbus lock and op profile for each ring */
+	struct sbl_sbus_arb *sbus_arb;		 /* sbus access arbiter for each ring */
+
+	struct sbl_spico_prof *spico_prof;	 /* instance serdes and sbm spico interrupt profiles */
+
+	struct mutex fw_image_mtx;		 /* lock for the firmware image cache */
+	struct sbl_fw_image *sbm_fw_image;	 /* cached sbus master fw image */
+	struct sbl_fw_image *serdes_fw_image;	 /* cached serdes fw image */
+
 	struct workqueue_struct *workq;
+	struct workqueue_struct *ring_workq;	 /* per sbus ring firmware jobs */
+
+	struct delayed_work fw_scrub_work;	 /* background firmware crc scrubber */
+
+	u32 serdes_op_ns[SBL_SERDES_OP_CODES];	 /* learned serdes op completion time per code */
 
 	bool is_hw;
 };
@@ -242,6 +342,8 @@ int  sbl_get_lp_subtype(struct sbl_inst *sbl, int port_num, enum sbl_lp_subtype
 int  sbl_base_link_config(struct sbl_inst *sbl, int port_num,
 		struct sbl_base_link_attr *blattr);
 int  sbl_base_link_start(struct sbl_inst *sbl, int port_num);
+int  sbl_base_link_start_many(struct sbl_inst *sbl, u64 port_mask, int *results);
+int  sbl_base_link_start_async(struct sbl_inst *sbl, int port_num);
 int  sbl_base_link_enable_start(struct sbl_inst *sbl, int port_num);
 int  sbl_base_link_cancel_start(struct sbl_inst *sbl, int port_num);
 bool sbl_base_link_start_cancelled(struct sbl_inst *sbl, int port_num);
@@ -273,6 +375,8 @@ int sbl_serdes_set_tuning_params(struct sbl_inst *sbl, int port_num,
 		struct sbl_tuning_params *tuning_params);
 int sbl_serdes_invalidate_tuning_params(struct sbl_inst *sbl, int port_num);
 int sbl_serdes_invalidate_all_tuning_params(struct sbl_inst *sbl);
+ssize_t sbl_serdes_export_tuning_params(struct sbl_inst *sbl, void *buf, size_t size);
+int sbl_serdes_import_tuning_params(struct sbl_inst *sbl, const void *buf, size_t size);
 
 /* Timing flags */
 int sbl_flags_get_poll_interval_from_flags(unsigned int flags);
@@ -287,6 +391,8 @@ int  sbl_serdes_del_config(struct sbl_inst *sbl, u64 tp_state_mask0,
 		u64 tp_state_mask1, u64 tp_state_match0, u64 tp_state_match1,
 		u64 port_mask, u8  serdes_mask);
 int sbl_serdes_clear_all_configs(struct sbl_inst *sbl, bool clr_default);
+int sbl_serdes_load_config_table(struct sbl_inst *sbl, const void *data, size_t size);
+int sbl_serdes_request_config_table(struct sbl_inst *sbl, const char *fname);
 void sbl_serdes_dump_configs(struct sbl_inst *sbl);
 struct sbl_switch_info *sbl_get_switch_info(int *size);
 
@@ -299,6 +405,8 @@ int sbl_pml_serdes_op_timing(struct sbl_inst *sbl, int port_num, u64 capture,
 		u64 clear, u64 set);
 int sbl_pml_serdes_op(struct sbl_inst *sbl, int port_num, u64 serdes_sel,
 		u64 op, u64 data, u16 *result, int timeout, unsigned int flags);
+int sbl_pml_serdes_op_lanes(struct sbl_inst *sbl, int port_num, u32 lane_mask,
+		u64 op, u64 data, u16 *results, int timeout, unsigned int flags);
 
 /* MAC */
 void sbl_pml_mac_start(struct sbl_inst *sbl, int port_num);
@@ -317,10 +425,15 @@ void sbl_pml_pcs_recovery_disable(struct sbl_inst *sbl, int port_num);
 void sbl_ignore_save_tuning_param(struct sbl_inst *sbl, int port_num, bool ignore);
 void sbl_enable_opt_lane_degrade(struct sbl_inst *sbl, int port_num, bool enable);
 void sbl_disable_pml_recovery(struct sbl_inst *sbl, int port_num, bool disable);
+void sbl_enable_opt_fw_crc_cache(struct sbl_inst *sbl, int port_num, bool enable);
+void sbl_enable_opt_dfe_adaptive_effort(struct sbl_inst *sbl, int port_num, bool enable);
+void sbl_enable_opt_dfe_peer_seed(struct sbl_inst *sbl, int port_num, bool enable);
 void sbl_pml_recovery_log_link_down(struct sbl_inst *sbl, int port_num);
 void sbl_set_degraded_flag(struct sbl_inst *sbl, int port_num);
 void sbl_clear_degraded_flag(struct sbl_inst *sbl, int port_num);
 bool sbl_get_degraded_flag(struct sbl_inst *sbl, int port_num);
+int sbl_spico_prof_clear(struct sbl_inst *sbl, int port_num);
+int sbl_dfe_effort_clear(struct sbl_inst *sbl, int port_num);
 
 /* sysfs support */
 #ifdef CONFIG_SYSFS
@@ -336,7 +449,12 @@ int sbl_base_link_llr_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf
 int sbl_base_link_loopback_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
 int sbl_debug_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
 int sbl_sbm_fw_sysfs_sprint(struct sbl_inst *sbl, int ring, char *buf, size_t size);
+int sbl_sbus_op_log_sysfs_sprint(struct sbl_inst *sbl, int ring, char *buf, size_t size);
+int sbl_sbus_prof_sysfs_sprint(struct sbl_inst *sbl, int ring, char *buf, size_t size);
+int sbl_spico_prof_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
+int sbl_dfe_effort_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
 int sbl_fec_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
+int sbl_link_phase_sysfs_sprint(struct sbl_inst *sbl, int port_num, char *buf, size_t size);
 #endif
 
 /* debug support */
@@ -364,6 +482,12 @@ const char *sbl_async_alert_str(enum sbl_async_alert_type alert_type);
 const char *sbl_fec_discard_str(enum sbl_fec_discard_type discard_type);
 const char *sbl_down_origin_str(enum sbl_link_down_origin down_origin);
 
+/* link bring-up phase timing */
+int  sbl_link_phase_stats_get(struct sbl_inst *sbl, int port_num,
+		struct sbl_link_phase_stats *stats, u16 first, u16 count);
+void sbl_link_phase_stats_clear(struct sbl_inst *sbl, int port_num);
+const char *sbl_link_phase_str(int phase);
+
 /* SBL counter get functions */
 int sbl_link_counters_get(struct sbl_inst *sbl, int port_num,
 						int *counters, u16 first, u16 count);
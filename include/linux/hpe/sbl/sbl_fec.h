@@ -7,6 +7,8 @@
 #define SBL_FEC_UP_WINDOW		 250	   /* ms */
 #define SBL_FEC_UP_COUNT_FABRIC		 4
 #define SBL_FEC_UP_COUNT_EDGE		 1
+#define SBL_FEC_UP_SEQ_INTERVAL		 10	   /* ms */
+#define SBL_FEC_UP_SEQ_CONFIDENCE_DFLT	 300	   /* z-score x100 (~99.9%) */
 #define SBL_FEC_MON_PERIOD		 1000	   /* 1sec*/
 #define SBL_FEC_LLR_TX_REPLAY_THRESH	 100000	   /* llr_tx_replays/s */
 #define SBL_PCS_NUM_FECL_CNTRS		 8
@@ -24,6 +26,28 @@ struct sbl_pcs_fec_cntrs {
 
 struct sbl_inst;
 
+/* resumable fec up check progress */
+enum sbl_fec_up_state {
+	SBL_FEC_UP_STATE_SETTLE,		  /* waiting for the rates to settle */
+	SBL_FEC_UP_STATE_WINDOW,		  /* fixed window check */
+	SBL_FEC_UP_STATE_SEQ,			  /* sequential check */
+};
+
+struct sbl_fec_up {
+	int state;				  /* enum sbl_fec_up_state */
+	bool use_stp_thresh;			  /* checking against the stp ccw threshold */
+	u32 ucw_thresh_adj;			  /* adjustments in use for this check */
+	u32 ccw_thresh_adj;
+	u32 confidence;				  /* sequential check confidence */
+	int count;				  /* windows to check */
+	int windows_done;			  /* fixed windows checked so far */
+	u64 ucw_bad;				  /* sequential check thresholds */
+	u64 ccw_bad;
+	unsigned long last_jiffy;		  /* end of the sequential check */
+	struct sbl_pcs_fec_cntrs base;		  /* sequential measurement start */
+	struct sbl_pcs_fec_cntrs window;	  /* current window start */
+};
+
 struct sbl_fec {
 	struct sbl_pcs_fec_cntrs *fec_curr_cnts;   /* current fec counters */
 	struct sbl_pcs_fec_cntrs *fec_prev_cnts;   /* previous fec counts */
@@ -43,6 +67,9 @@ struct sbl_fec {
 	u32 fec_ccw_down_thresh_adj;		   /* percentage adjustment for link down threshold */
 	u32 fec_ccw_hwm;			   /* highest value measured */
 
+	u32 fec_up_seq_confidence;		   /* up check confidence (z-score x100), 0 for fixed windows */
+	struct sbl_fec_up fec_up;		   /* up check progress (busy_mtx) */
+
 	u64 fec_llr_tx_replay_thresh;		   /* LLR TX Replay threshold */
 	u32 fec_llr_tx_replay_hwm;		   /* highest value measured */
 	u32 fecl_warn;				   /* corrected codewords per fec lane warning threshold */
@@ -73,7 +100,7 @@ int sbl_fec_thresholds_set(struct sbl_inst *sbl, int port_num,
 		s32 ucw_in, s32 ccw_in);
 
 void sbl_fec_counts_get(struct sbl_inst *sbl, int port_num, struct sbl_pcs_fec_cntrs *cntrs);
-int sbl_fec_up_check(struct sbl_inst *sbl, int port_num);
+int sbl_fec_up_check(struct sbl_inst *sbl, int port_num, bool resume);
 void sbl_zero_all_fec_counts(struct sbl_inst *sbl, int port_num);
 void sbl_fec_timer(struct timer_list *timer);
 void sbl_fec_hwms_clear(struct sbl_inst *sbl, int port_num);
@@ -82,6 +109,8 @@ void sbl_fec_modify_adjustments(struct sbl_inst *sbl, int port_num,
 		u32 *ucw_up_adj, u32 *ccw_up_adj, u32 *ucw_down_adj, u32 *ccw_down_adj, u32 *stp_ccw_up_adj);
 int sbl_fec_txr_rate_set(struct sbl_inst *sbl, int port_num,
 		u32 txr_rate);
+int sbl_fec_up_confidence_set(struct sbl_inst *sbl, int port_num,
+		u32 confidence);
 void sbl_fec_timer_work(struct work_struct *work);
 void sbl_fec_ccw_bad_get(struct sbl_fec *fec_prmts, bool use_stp_thresh,
 			u64 *ccw_bad, u64 *ccw_hwm);
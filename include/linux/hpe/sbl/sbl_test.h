@@ -15,6 +15,7 @@ int sbl_test_scratch(struct sbl_inst *sbl, int port_num);
 int sbl_test_serdes_stop(struct sbl_inst *sbl, int port_num);
 int sbl_test_pcs_tx_rf(struct sbl_inst *sbl, int port_num);
 void sbl_test_manipulate_serdes_fw_crc_result(u16 *crc_result);
+bool sbl_test_serdes_fw_crc_failure_injected(void);
 void sbl_test_inject_serdes_fw_crc_failure(bool set);
 
 #endif /* _SBL_SERDES_H_ */
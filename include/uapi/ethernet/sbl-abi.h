@@ -62,6 +62,9 @@
  *
  *   Values less than 1ms will use a busy wait, values 1ms and greater
  *   will sleep
+ *
+ *   Hybrid polling (serdes ops only) busy waits briefly, then sleeps
+ *   with a backoff capped at the interval
  */
 enum sbl_serdes_sbus_op_flag {
 	SBL_FLAG_DELAY_3US       =  1<<0,  /**< 3us delay */
@@ -75,6 +78,7 @@ enum sbl_serdes_sbus_op_flag {
 	SBL_FLAG_INTERVAL_10MS   =  1<<8,  /**< 10ms interval */
 	SBL_FLAG_INTERVAL_100MS  =  1<<9,  /**< 100ms interval */
 	SBL_FLAG_INTERVAL_1S     =  1<<10, /**< 1s interval */
+	SBL_FLAG_POLL_HYBRID     =  1<<11, /**< busy poll then back off up to the interval */
 };
 
 #include "sbl_serdes_defaults.h"
@@ -361,6 +365,9 @@ enum sbl_options_flags {
 	SBL_OPT_DISABLE_AN_LLR             = 1<<19, /**< disable AN LLR detect */
 	SBL_OPT_LANE_DEGRADE               = 1<<20, /**< enable auto lane degrade */
 	SBL_DISABLE_PML_RECOVERY           = 1<<21, /**< disable pml recovery */
+	SBL_OPT_FW_CRC_CACHE               = 1<<22, /**< trust a recent good serdes fw crc check */
+	SBL_OPT_DFE_ADAPTIVE_EFFORT        = 1<<23, /**< tune with the effort past tunes say is quickest */
+	SBL_OPT_DFE_PEER_SEED              = 1<<24, /**< start tuning from an up port's params */
 };
 
 
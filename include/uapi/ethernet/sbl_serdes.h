@@ -9,8 +9,12 @@
 
 #define SBL_TUNING_PARAM_MAGIC           0x74736d70  /* stpm */
 #define SBL_TUNING_PARAM_VERSION                  2
+#define SBL_TUNING_PARAM_STORE_MAGIC     0x74737073  /* stps */
+#define SBL_TUNING_PARAM_STORE_VERSION            1
 
 #define SBL_SERDES_CONFIG_MAGIC          0x63736d76  /* scvm */
+#define SBL_SERDES_CONFIG_TABLE_MAGIC    0x63736274  /* sctb */
+#define SBL_SERDES_CONFIG_TABLE_VERSION           1
 #define SBL_MAX_OOB_SERDES_PARAMS        0 /* Allow no more than this number of params to be out of bounds */
 #define SBL_CTLE_HF_MIN          0
 #define SBL_CTLE_HF_MAX          15
@@ -325,6 +329,26 @@ struct sbl_tuning_params {
 	struct sbl_serdes_params params[4];
 };
 
+/**
+ * @brief Saved tuning parameters for all the ports of an instance
+ *
+ *        Made by sbl_serdes_export_tuning_params() and given back to
+ *         sbl_serdes_import_tuning_params(), e.g. across a driver reload.
+ */
+struct sbl_tp_store_entry {
+	__u32 port_num;       /**< port the params were saved from */
+	__u32 pad;
+	struct sbl_tuning_params tp;
+};
+
+struct sbl_tp_store {
+	__u32 magic;          /**< = SBL_TUNING_PARAM_STORE_MAGIC */
+	__u32 version;        /**< = SBL_TUNING_PARAM_STORE_VERSION */
+	__u32 entry_size;     /**< = sizeof(struct sbl_tp_store_entry) */
+	__u32 num_entries;    /**< number of entries */
+	struct sbl_tp_store_entry entries[];
+};
+
 
 /**
  * @brief SerDes configuration values
@@ -347,6 +371,37 @@ struct sbl_sc_values {
 };
 
 
+/**
+ * @brief SerDes configuration table
+ *
+ *        A binary image of a whole serdes configuration list, loaded with
+ *         sbl_serdes_request_config_table() or sbl_serdes_load_config_table().
+ *        Each entry has the same meaning as the arguments to
+ *         sbl_serdes_add_config(). Entries as specific as each other are
+ *         looked up in table order.
+ */
+#define SBL_SC_TABLE_MAX_ENTRIES   65536
+
+struct sbl_sc_table_entry {
+	__u64 tp_state_mask0;               /**< State lookup mask */
+	__u64 tp_state_mask1;               /**< State lookup mask */
+	__u64 tp_state_match0;              /**< match values after masking */
+	__u64 tp_state_match1;              /**< match values after masking */
+	__u64 port_mask;                    /**< applicable ports */
+	__u8  serdes_mask;                  /**< applicable serdes */
+	__u8  pad[3];
+	struct sbl_sc_values vals;          /**< Configuration values */
+};
+
+struct sbl_sc_table {
+	__u32 magic;                        /**< = SBL_SERDES_CONFIG_TABLE_MAGIC */
+	__u32 version;                      /**< = SBL_SERDES_CONFIG_TABLE_VERSION */
+	__u32 entry_size;                   /**< = sizeof(struct sbl_sc_table_entry) */
+	__u32 num_entries;                  /**< number of entries */
+	struct sbl_sc_table_entry entries[];
+};
+
+
 /*
  * serdes configuration hash.
  *